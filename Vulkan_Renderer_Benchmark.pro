@@ -0,0 +1,91 @@
+TARGET = Vulkan_Renderer_Benchmark
+TEMPLATE = app
+
+CONFIG += c++17
+
+win32 {
+    QMAKE_CXXFLAGS += /std:c++17
+    INCLUDEPATH += C:/VulkanSDK/1.1.85.0/Include/vulkan/
+    LIBS += "-LC:/VulkanSDK/1.1.85.0/Lib/"
+    LIBS += "-LC:/VulkanSDK/1.1.85.0/Lib/" -lvulkan-1
+    LIBS += "-LC:/Windows/WinSxS/amd64_microsoft-windows-user32_31bf3856ad364e35_10.0.17134.320_none_aef35d46c36383b6/" -luser32
+    SOURCES += src/ui/win32.cpp
+    HEADERS += src/ui/win32.h
+}
+
+unix {
+    INCLUDEPATH += /usr/include/vulkan/
+    LIBS += -lvulkan -lstdc++fs
+    SOURCES += src/ui/xcbwindow.cpp
+    HEADERS += src/ui/xcbwindow.h
+    packagesExist(xcb) {
+        DEFINES += VK_USE_PLATFORM_XCB_KHR
+        LIBS += -lxcb
+    }
+}
+
+SOURCES += \
+    src/benchmark/main.cpp \
+    src/benchmark/benchmarkrunner.cpp \
+    src/logfile.cpp \
+    src/renderer/vulkanrenderer.cpp \
+    src/renderer/physicaldeviceinfo.cpp \
+    src/renderer/logicaldevice.cpp \
+    src/renderer/swapchain.cpp \
+    src/renderer/graphicspipeline.cpp \
+    src/renderer/vulkanvalidationlayers.cpp \
+    src/renderer/framestatistics.cpp \
+    src/renderer/timestampquerypool.cpp \
+    src/renderer/pipelinecache.cpp \
+    src/renderer/devicememoryallocator.cpp \
+    src/renderer/mesh.cpp \
+    src/renderer/threadpool.cpp \
+    src/renderer/computepipeline.cpp \
+    src/renderer/shaderwatcher.cpp \
+    src/renderer/mappedfile.cpp \
+    src/renderer/indirectdrawlist.cpp \
+    src/renderer/descriptorlayoutcache.cpp \
+    src/renderer/descriptorallocator.cpp \
+    src/renderer/uniformringbuffer.cpp \
+    src/renderer/pipelinestatecache.cpp \
+    src/renderer/specializationconstants.cpp \
+    src/renderer/presentpolicy.cpp \
+    src/renderer/devicescorer.cpp \
+    src/renderer/renderthread.cpp \
+    src/renderer/rendergraph.cpp \
+    src/ui/window.cpp \
+    src/ui/windoweventqueue.cpp \
+    src/ui/headlesswindow.cpp
+
+HEADERS += \
+    src/benchmark/benchmarkrunner.h \
+    src/renderer/vulkanrenderer.h \
+    src/renderer/physicaldeviceinfo.h \
+    src/renderer/logicaldevice.h \
+    src/renderer/swapchain.h \
+    src/utility.h \
+    src/logfile.h \
+    src/renderer/graphicspipeline.h \
+    src/renderer/vulkanvalidationlayers.h \
+    src/renderer/framestatistics.h \
+    src/renderer/timestampquerypool.h \
+    src/renderer/pipelinecache.h \
+    src/renderer/devicememoryallocator.h \
+    src/renderer/mesh.h \
+    src/renderer/threadpool.h \
+    src/renderer/computepipeline.h \
+    src/renderer/shaderwatcher.h \
+    src/renderer/mappedfile.h \
+    src/renderer/indirectdrawlist.h \
+    src/renderer/descriptorlayoutcache.h \
+    src/renderer/descriptorallocator.h \
+    src/renderer/uniformringbuffer.h \
+    src/renderer/pipelinestatecache.h \
+    src/renderer/specializationconstants.h \
+    src/renderer/presentpolicy.h \
+    src/renderer/devicescorer.h \
+    src/renderer/renderthread.h \
+    src/renderer/rendergraph.h \
+    src/ui/window.h \
+    src/ui/windoweventqueue.h \
+    src/ui/headlesswindow.h
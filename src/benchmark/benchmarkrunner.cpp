@@ -0,0 +1,208 @@
+#include "benchmarkrunner.h"
+#include <fstream>
+#include <sstream>
+
+/*!
+        \class BenchmarkRunner
+        \brief The BenchmarkRunner class runs named benchmark scenarios and writes their results as CSV and JSON.
+
+        Frame based scenarios render warmupFrames frames that are thrown away and then measuredFrames frames
+        whose frame times are collected by the renderer's own FrameStatistics, so the benchmark reports exactly
+        the numbers the renderer exposes. Scenarios that measure something other than frames add their own
+        metrics to a result. The CSV output has one scenario,metric,value row per metric and the JSON output
+        additionally carries each scenario's frame time histogram.
+*/
+
+BenchmarkOptions::BenchmarkOptions(const std::vector<std::string> & arguments)
+    : warmupFrames(BENCHMARK_DEFAULT_WARMUP_FRAME_COUNT),
+      measuredFrames(BENCHMARK_DEFAULT_MEASURED_FRAME_COUNT),
+      csvPath(BENCHMARK_DEFAULT_CSV_PATH),
+      jsonPath(BENCHMARK_DEFAULT_JSON_PATH),
+#ifdef _WIN32
+      headless(false),
+#else
+      headless(true),
+#endif
+      extent(VK_EXTENT_1080_P)
+{
+    auto value = [&](size_t & index){
+        if (++index >= arguments.size())
+            throw std::runtime_error(std::string("Missing value for benchmark argument ") + arguments[index - 1] + std::string("!"));
+        return arguments[index];
+    };
+    for (auto i = size_t(0); i < arguments.size(); i++){
+        const auto & argument = arguments[i];
+        if (argument == "--warmup"){
+            warmupFrames = static_cast<uint32_t>(std::stoul(value(i)));
+        }else if (argument == "--frames"){
+            measuredFrames = static_cast<uint32_t>(std::stoul(value(i)));
+        }else if (argument == "--csv"){
+            csvPath = value(i);
+        }else if (argument == "--json"){
+            jsonPath = value(i);
+        }else if (argument == "--scenario"){
+            scenarioFilter = value(i);
+        }else if (argument == "--headless"){
+            headless = true;
+        }else if (argument == "--windowed"){
+            headless = false;
+        }else if (argument == "--width"){
+            extent.width = static_cast<uint32_t>(std::stoul(value(i)));
+        }else if (argument == "--height"){
+            extent.height = static_cast<uint32_t>(std::stoul(value(i)));
+        }else{
+            throw std::runtime_error(std::string("Unknown benchmark argument ") + argument + std::string("!"));
+        }
+    }
+    if (!measuredFrames)
+        throw std::runtime_error("At least one measured frame is required!");
+}
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions & benchmarkoptions, const WindowCreateInfo & windowcreateinfo)
+    : options(benchmarkoptions),
+      windowCreateInfo(windowcreateinfo)
+{
+    //
+}
+
+void BenchmarkRunner::addScenario(const std::string & name, const std::function<void(BenchmarkRunner &, const std::string &)> & scenario){
+    scenarios.push_back(std::make_pair(name, scenario));
+}
+
+void BenchmarkRunner::runAll(){
+    for (const auto & scenario : scenarios){
+        if (!options.scenarioFilter.empty() && scenario.first.find(options.scenarioFilter) == std::string::npos)
+            continue;
+        LogFile::writeToLog(std::string("Running benchmark scenario ") + scenario.first + std::string("..."));
+        scenario.second(*this, scenario.first);
+    }
+}
+
+VulkanRenderer & BenchmarkRunner::getRenderer(){
+    //Scenarios share one renderer unless they need a fresh one...
+    if (!renderer)
+        renderer = createRenderer();
+    return *renderer;
+}
+
+std::unique_ptr<VulkanRenderer> BenchmarkRunner::createRenderer(bool forceheadless){
+    //No validation layers, they would dominate the numbers...
+    WindowCreateInfo headlesscreateinfo(options.extent);
+    auto newrenderer = std::make_unique<VulkanRenderer>(forceheadless ? headlesscreateinfo : windowCreateInfo, std::vector<const char *> {});
+    std::array<QueueInfo, 2> flags = {
+        QueueInfo(VK_QUEUE_GRAPHICS_BIT, std::vector<float> {1.0}),
+        QueueInfo(VK_QUEUE_COMPUTE_BIT, std::vector<float> {1.0})
+    };
+    VkPhysicalDeviceFeatures features {};
+    newrenderer->addLogicalDevice(flags, features);
+    newrenderer->addMesh(
+                std::vector<Vertex> {
+                    {{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+                    {{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+                    {{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}}
+                },
+                std::vector<uint32_t> {0, 1, 2}
+                );
+    return newrenderer;
+}
+
+BenchmarkRunner::Result & BenchmarkRunner::measureFrames(
+        const std::string & scenario,
+        VulkanRenderer & renderer,
+        bool warmup,
+        const std::function<void(uint32_t)> & beforeframe
+        )
+{
+    //Warm up caches, drivers and clocks before anything is recorded, scenes that animate are updated before every frame...
+    auto frame = 0U;
+    for (auto i = 0U; warmup && i < options.warmupFrames && renderer.keepRendering(); i++){
+        if (beforeframe)
+            beforeframe(frame++);
+        renderer.drawFrame();
+    }
+
+    //Size the statistics window to hold every measured frame...
+    renderer.resetFrameStatistics(options.measuredFrames);
+    for (auto i = 0U; i <= options.measuredFrames && renderer.keepRendering(); i++){
+        if (beforeframe)
+            beforeframe(frame++);
+        renderer.drawFrame();
+    }
+
+    const auto & statistics = renderer.getFrameStatistics();
+    auto summary = statistics.getSummary();
+    auto & result = addResult(scenario);
+    result.metrics = {
+        {"frames", static_cast<double>(summary.sampleCount)},
+        {"min_ms", summary.minimum},
+        {"mean_ms", summary.mean},
+        {"p50_ms", summary.p50},
+        {"p95_ms", summary.p95},
+        {"p99_ms", summary.p99},
+        {"max_ms", summary.maximum},
+        {"fps", summary.mean > 0.0 ? 1000.0 / summary.mean : 0.0},
+        {"stutters", static_cast<double>(summary.stutterCount)}
+    };
+
+    //GPU scopes report the same percentiles, named gpu_<scope>_<metric>...
+    for (auto scope = 0U; renderer.hasGpuTimestamps() && scope < TimestampQueryPool::SCOPE_COUNT; scope++){
+        auto gpusummary = renderer.getGpuStatistics(static_cast<TimestampQueryPool::Scope>(scope)).getSummary();
+        auto prefix = std::string("gpu_") + TimestampQueryPool::getScopeName(static_cast<TimestampQueryPool::Scope>(scope)) + std::string("_");
+        result.metrics.push_back({prefix + "mean_ms", gpusummary.mean});
+        result.metrics.push_back({prefix + "p50_ms", gpusummary.p50});
+        result.metrics.push_back({prefix + "p95_ms", gpusummary.p95});
+        result.metrics.push_back({prefix + "p99_ms", gpusummary.p99});
+        result.metrics.push_back({prefix + "max_ms", gpusummary.maximum});
+    }
+    result.histogram = statistics.getHistogram();
+    result.histogramBucketWidth = statistics.getHistogramBucketWidth();
+    return result;
+}
+
+BenchmarkRunner::Result & BenchmarkRunner::addResult(const std::string & scenario){
+    Result result = {};
+    result.scenario = scenario;
+    results.push_back(result);
+    return results.back();
+}
+
+void BenchmarkRunner::writeCsv(const std::string & path) const{
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error(std::string("Failed to open ") + path + std::string("!"));
+    file << "scenario,metric,value\n";
+    for (const auto & result : results){
+        for (const auto & metric : result.metrics)
+            file << result.scenario << "," << metric.first << "," << metric.second << "\n";
+    }
+}
+
+void BenchmarkRunner::writeJson(const std::string & path) const{
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error(std::string("Failed to open ") + path + std::string("!"));
+    file << "{\n  \"warmup_frames\": " << options.warmupFrames << ",\n  \"measured_frames\": " << options.measuredFrames << ",\n  \"scenarios\": [";
+    for (auto i = 0U; i < results.size(); i++){
+        const auto & result = results[i];
+        file << (i ? ",\n" : "\n") << "    {\n      \"name\": \"" << result.scenario << "\",\n      \"metrics\": {";
+        for (auto j = 0U; j < result.metrics.size(); j++)
+            file << (j ? ", " : "") << "\"" << result.metrics[j].first << "\": " << result.metrics[j].second;
+        file << "}";
+        if (!result.histogram.empty()){
+            file << ",\n      \"histogram\": {\"bucket_width_ns\": " << result.histogramBucketWidth << ", \"counts\": [";
+            for (auto j = 0U; j < result.histogram.size(); j++)
+                file << (j ? ", " : "") << result.histogram[j];
+            file << "]}";
+        }
+        file << "\n    }";
+    }
+    file << "\n  ]\n}\n";
+}
+
+const BenchmarkOptions & BenchmarkRunner::getOptions() const noexcept{
+    return options;
+}
+
+const std::vector<BenchmarkRunner::Result> & BenchmarkRunner::getResults() const noexcept{
+    return results;
+}
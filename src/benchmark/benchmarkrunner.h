@@ -0,0 +1,71 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include "src/renderer/vulkanrenderer.h"
+#include "src/utility.h"
+#include <functional>
+#include <memory>
+#include <utility>
+
+#define BENCHMARK_DEFAULT_WARMUP_FRAME_COUNT 200
+#define BENCHMARK_DEFAULT_MEASURED_FRAME_COUNT 2000
+#define BENCHMARK_DEFAULT_CSV_PATH "benchmark.csv"
+#define BENCHMARK_DEFAULT_JSON_PATH "benchmark.json"
+
+class BenchmarkOptions final
+{
+public:
+    BenchmarkOptions(const std::vector<std::string> & arguments);
+public:
+    uint32_t warmupFrames;
+    uint32_t measuredFrames;
+    std::string csvPath;
+    std::string jsonPath;
+    std::string scenarioFilter;
+    bool headless;
+    VkExtent2D extent;
+};
+
+class BenchmarkRunner final
+{
+public:
+    struct Result final
+    {
+        std::string scenario;
+        std::vector <std::pair<std::string, double>> metrics;
+        std::vector <uint64_t> histogram;
+        uint64_t histogramBucketWidth;
+    };
+public:
+    BenchmarkRunner(const BenchmarkOptions & options, const WindowCreateInfo & windowcreateinfo);
+public:
+    ~BenchmarkRunner() = default;
+    BenchmarkRunner(const BenchmarkRunner & other) = delete;
+    BenchmarkRunner & operator=(const BenchmarkRunner & other) = delete;
+    BenchmarkRunner(const BenchmarkRunner && other) = delete;
+    BenchmarkRunner & operator=(const BenchmarkRunner && other) = delete;
+public:
+    void addScenario(const std::string & name, const std::function<void(BenchmarkRunner &, const std::string &)> & scenario);
+    void runAll();
+    [[nodiscard]] VulkanRenderer & getRenderer();
+    [[nodiscard]] std::unique_ptr<VulkanRenderer> createRenderer(bool forceheadless = false);
+    Result & measureFrames(
+            const std::string & scenario,
+            VulkanRenderer & renderer,
+            bool warmup = true,
+            const std::function<void(uint32_t)> & beforeframe = nullptr
+            );
+    Result & addResult(const std::string & scenario);
+    void writeCsv(const std::string & path) const;
+    void writeJson(const std::string & path) const;
+    [[nodiscard]] const BenchmarkOptions & getOptions() const noexcept;
+    [[nodiscard]] const std::vector<Result> & getResults() const noexcept;
+private:
+    BenchmarkOptions options;
+    WindowCreateInfo windowCreateInfo;
+    std::unique_ptr <VulkanRenderer> renderer;
+    std::vector <std::pair<std::string, std::function<void(BenchmarkRunner &, const std::string &)>>> scenarios;
+    std::vector <Result> results;
+};
+
+#endif // BENCHMARKRUNNER_H
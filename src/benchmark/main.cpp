@@ -0,0 +1,684 @@
+#include "benchmarkrunner.h"
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include "src/utility.h"
+#include "src/renderer/mappedfile.h"
+#include "src/renderer/threadpool.h"
+#include "src/renderer/pipelinecache.h"
+#include <atomic>
+
+//Startups are slow, so only a few are timed; resizes are cheap enough to take a proper sample...
+#define BENCHMARK_STARTUP_REPETITIONS 5
+#define BENCHMARK_RESIZE_COUNT 100
+#define BENCHMARK_UPLOAD_GRID_SIZE 1024
+#define BENCHMARK_RECORDING_DRAW_COUNT 10000
+#define BENCHMARK_LOG_CALLS_PER_THREAD 100000
+#define BENCHMARK_SHADER_LOAD_COPIES 256
+#define BENCHMARK_GPU_DRIVEN_DRAW_COUNT 10000
+#define BENCHMARK_UNIFORM_DRAW_COUNT 10000
+#define BENCHMARK_PIPELINE_VARIANT_COUNT 256
+#define BENCHMARK_RESIZE_STORM_EVENTS 8
+#define BENCHMARK_PACED_TARGET_FPS 60.0
+#define BENCHMARK_OVERDRAW_LAYER_COUNT 64
+#define BENCHMARK_CACHE_DIRECTORY "vulkan_renderer_benchmark_cache"
+
+template <typename Function>
+static double timeMilliseconds(Function && function){
+    auto t1 = std::chrono::steady_clock::now();
+    function();
+    auto t2 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t2 - t1).count();
+}
+
+//A square grid of count triangles, one mesh each, extent wide and centred on the view...
+static std::vector<uint32_t> addTriangleGrid(VulkanRenderer &renderer, uint32_t count, float extent = 2.0f, float depth = 0.0f){
+    auto gridsize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    auto cellsize = extent / gridsize;
+    std::vector<uint32_t> meshes;
+    meshes.reserve(count);
+    for (auto i = 0U; i < count; i++){
+        auto x = -extent / 2.0f + (i % gridsize) * cellsize;
+        auto y = -extent / 2.0f + (i / gridsize) * cellsize;
+        meshes.push_back(renderer.addMesh({
+            {{x, y, depth}, {1.0f, 0.0f, 0.0f}},
+            {{x + cellsize, y, depth}, {0.0f, 1.0f, 0.0f}},
+            {{x, y + cellsize, depth}, {0.0f, 0.0f, 1.0f}}
+        }, {0, 1, 2}));
+    }
+    return meshes;
+}
+
+//Scenarios that need a cold pipeline cache wipe a temporary directory instead of the one next to the binary,
+//which is put back once the scenario is done...
+class BenchmarkCacheDirectory final
+{
+public:
+    BenchmarkCacheDirectory()
+        : directory(fs::temp_directory_path() / BENCHMARK_CACHE_DIRECTORY)
+    {
+        clear();
+        PipelineCache::setCacheDirectory(directory);
+    }
+    ~BenchmarkCacheDirectory(){
+        PipelineCache::setCacheDirectory(fs::path());
+        std::error_code error;
+        fs::remove_all(directory, error);
+    }
+    BenchmarkCacheDirectory(const BenchmarkCacheDirectory & other) = delete;
+    BenchmarkCacheDirectory & operator=(const BenchmarkCacheDirectory & other) = delete;
+public:
+    void clear(){
+        fs::remove_all(directory);
+    }
+private:
+    fs::path directory;
+};
+
+//Runs headless with no validation layers when the window create info has no window, so it also works on
+//machines without a GPU by pointing the loader at a software ICD (e.g. VK_ICD_FILENAMES=lvp_icd.x86_64.json)...
+static int run(const BenchmarkOptions &options, WindowCreateInfo &createinfo){
+    static LogFile logfile;
+    BenchmarkRunner runner(options, createinfo);
+
+    //Startup with an empty pipeline cache against one that a previous renderer saved on shutdown.
+    //Startup renderers are always headless, the surface costs the same either way...
+    runner.addScenario("pipeline_cache_startup", [](BenchmarkRunner &runner, const std::string &name){
+        BenchmarkCacheDirectory cachedirectory;
+        auto cold = 0.0, warm = 0.0;
+        auto warmhits = 0U;
+        for (auto i = 0U; i < BENCHMARK_STARTUP_REPETITIONS; i++){
+            cachedirectory.clear();
+            std::unique_ptr<VulkanRenderer> renderer;
+            cold += timeMilliseconds([&]{ renderer = runner.createRenderer(true); });
+            renderer.reset();
+            warm += timeMilliseconds([&]{ renderer = runner.createRenderer(true); });
+            warmhits += renderer->wasPipelineCacheLoaded() ? 1 : 0;
+        }
+        auto &result = runner.addResult(name);
+        result.metrics = {
+            {"cold_startup_ms", cold / BENCHMARK_STARTUP_REPETITIONS},
+            {"warm_startup_ms", warm / BENCHMARK_STARTUP_REPETITIONS},
+            {"warm_cache_hit_rate", static_cast<double>(warmhits) / BENCHMARK_STARTUP_REPETITIONS}
+        };
+    });
+
+    //Read a library of shaders the old way, one ifstream copy after another, against mapping them on every core.
+    //The directory only holds a few shaders, so each one stands in for BENCHMARK_SHADER_LOAD_COPIES modules...
+    runner.addScenario("shader_loading", [](BenchmarkRunner &runner, const std::string &name){
+        std::vector<std::string> shaders;
+        for (auto &shader : fs::directory_iterator(getShaderDirectory()))
+            if (shader.path().filename().u8string().find(".spv") != std::string::npos)
+                shaders.push_back(shader.path().u8string());
+        auto loads = shaders.size() * BENCHMARK_SHADER_LOAD_COPIES;
+
+        //Both sides check every word, as the driver would when it parses the module...
+        auto checksum = [](const char *data, size_t size){
+            uint32_t sum = 0, word = 0;
+            for (size_t i = 0; i + sizeof(word) <= size; i += sizeof(word)){
+                std::memcpy(&word, data + i, sizeof(word));
+                sum ^= word;
+            }
+            return sum;
+        };
+        std::atomic<uint32_t> checksums(0);
+        auto serial = timeMilliseconds([&]{
+            for (auto i = 0U; i < loads; i++){
+                auto code = readFile(shaders[i % shaders.size()]);
+                checksums ^= checksum(code.data(), code.size());
+            }
+        });
+        ThreadPool threads;
+        auto parallel = timeMilliseconds([&]{
+            threads.parallelFor(loads, [&](uint32_t, size_t task){
+                MappedFile code(shaders[task % shaders.size()]);
+                checksums ^= checksum(code.getData(), code.getSize());
+            });
+        });
+
+        //Startup now maps and creates the real shader modules on the recording threads...
+        std::unique_ptr<VulkanRenderer> renderer;
+        auto startup = timeMilliseconds([&]{ renderer = runner.createRenderer(true); });
+        auto &result = runner.addResult(name);
+        result.metrics = {
+            {"shader_loads", static_cast<double>(loads)},
+            {"ifstream_serial_ms", serial},
+            {"mapped_parallel_ms", parallel},
+            {"loading_speedup", parallel > 0.0 ? serial / parallel : 0.0},
+            {"loading_threads", static_cast<double>(threads.getThreadCount())},
+            {"startup_ms", startup}
+        };
+    });
+
+    //Time a frame that has to recreate the swapchain, pipelines are kept since the viewport and scissor are dynamic...
+    runner.addScenario("resize_latency", [](BenchmarkRunner &runner, const std::string &name){
+        auto &renderer = runner.getRenderer();
+        FrameStatistics resizes(BENCHMARK_RESIZE_COUNT);
+        for (auto i = 0U; i < BENCHMARK_RESIZE_COUNT && renderer.keepRendering(); i++){
+            auto milliseconds = timeMilliseconds([&]{
+                VulkanRenderer::setWindowResized(true);
+                renderer.drawFrame();
+            });
+            resizes.addSample(static_cast<uint64_t>(milliseconds * 1000000.0));
+        }
+        auto summary = resizes.getSummary();
+        auto &result = runner.addResult(name);
+        result.metrics = {
+            {"resizes", static_cast<double>(summary.sampleCount)},
+            {"mean_ms", summary.mean},
+            {"p95_ms", summary.p95},
+            {"max_ms", summary.maximum},
+            {"cache_loaded", renderer.wasPipelineCacheLoaded() ? 1.0 : 0.0}
+        };
+        result.histogram = resizes.getHistogram();
+        result.histogramBucketWidth = resizes.getHistogramBucketWidth();
+    });
+
+    //Several resize events land before every frame, as they do while a window edge is dragged. They should
+    //cost one recreation per frame without draining the device, max_ms is the worst frame of the storm...
+    runner.addScenario("resize_storm", [](BenchmarkRunner &runner, const std::string &name){
+        auto renderer = runner.createRenderer();
+        auto extent = runner.getOptions().extent;
+        auto events = 0ULL;
+        auto &result = runner.measureFrames(name, *renderer, true, [&](uint32_t frame){
+            for (auto i = 0U; i < BENCHMARK_RESIZE_STORM_EVENTS; i++, events++){
+                if (renderer->isHeadless()){
+                    auto shrink = ((frame * BENCHMARK_RESIZE_STORM_EVENTS + i) % 16) * 8;
+                    renderer->setOffscreenExtent({extent.width > shrink ? extent.width - shrink : extent.width, extent.height > shrink ? extent.height - shrink : extent.height});
+                }else{
+                    VulkanRenderer::setWindowResized(true);
+                }
+            }
+        });
+        result.metrics.push_back({"resize_events", static_cast<double>(events)});
+        result.metrics.push_back({"events_per_frame", static_cast<double>(BENCHMARK_RESIZE_STORM_EVENTS)});
+    });
+
+    //Compare frame times for every supported number of frames in flight...
+    for (uint32_t framesinflight = 1; framesinflight <= MAX_FRAMES_IN_FLIGHT_ALLOWED; framesinflight++){
+        runner.addScenario(std::string("frames_in_flight_") + std::to_string(framesinflight), [framesinflight](BenchmarkRunner &runner, const std::string &name){
+            auto &renderer = runner.getRenderer();
+            renderer.setFramesInFlight(framesinflight);
+            runner.measureFrames(name, renderer);
+        });
+    }
+
+    //Every present policy, with how evenly frames are presented (jitter is p99 less p50 of the present to present
+    //interval) and how long the CPU spends waiting on fences and the frame limiter...
+    for (auto mode = 0U; mode < PresentPolicy::MODE_COUNT; mode++){
+        auto policymode = static_cast<PresentPolicy::Mode>(mode);
+        runner.addScenario(std::string("present_policy_") + PresentPolicy::getModeName(policymode), [policymode](BenchmarkRunner &runner, const std::string &name){
+            auto &renderer = runner.getRenderer();
+            renderer.setPresentPolicy(PresentPolicy(policymode, policymode == PresentPolicy::PACED_FIFO ? BENCHMARK_PACED_TARGET_FPS : 0.0));
+            auto &result = runner.measureFrames(name, renderer);
+            auto present = renderer.getPresentStatistics().getSummary();
+            auto fencewait = renderer.getFenceWaitStatistics().getSummary();
+            auto limiterwait = renderer.getLimiterWaitStatistics().getSummary();
+            result.metrics.push_back({"present_mean_ms", present.mean});
+            result.metrics.push_back({"present_p50_ms", present.p50});
+            result.metrics.push_back({"present_p99_ms", present.p99});
+            result.metrics.push_back({"present_jitter_ms", present.p99 - present.p50});
+            result.metrics.push_back({"fence_wait_mean_ms", fencewait.mean});
+            result.metrics.push_back({"fence_wait_p95_ms", fencewait.p95});
+            result.metrics.push_back({"limiter_wait_mean_ms", limiterwait.mean});
+            result.metrics.push_back({"cpu_wait_mean_ms", fencewait.mean + limiterwait.mean});
+            result.metrics.push_back({"frames_in_flight", static_cast<double>(renderer.getFramesInFlight())});
+            renderer.setPresentPolicy(PresentPolicy());
+        });
+    }
+
+    //Frame times while a large mesh streams in, the upload shouldn't show up as stutter...
+    runner.addScenario("large_mesh_upload", [](BenchmarkRunner &runner, const std::string &name){
+        auto &renderer = runner.getRenderer();
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        vertices.reserve(BENCHMARK_UPLOAD_GRID_SIZE * BENCHMARK_UPLOAD_GRID_SIZE);
+        for (auto y = 0U; y < BENCHMARK_UPLOAD_GRID_SIZE; y++){
+            for (auto x = 0U; x < BENCHMARK_UPLOAD_GRID_SIZE; x++){
+                auto u = static_cast<float>(x) / (BENCHMARK_UPLOAD_GRID_SIZE - 1);
+                auto v = static_cast<float>(y) / (BENCHMARK_UPLOAD_GRID_SIZE - 1);
+                vertices.push_back({{u - 0.5f, v - 0.5f, 0.0f}, {u, v, 1.0f - u}});
+            }
+        }
+        indices.reserve((BENCHMARK_UPLOAD_GRID_SIZE - 1) * (BENCHMARK_UPLOAD_GRID_SIZE - 1) * 6);
+        for (auto y = 0U; y + 1 < BENCHMARK_UPLOAD_GRID_SIZE; y++){
+            for (auto x = 0U; x + 1 < BENCHMARK_UPLOAD_GRID_SIZE; x++){
+                auto corner = y * BENCHMARK_UPLOAD_GRID_SIZE + x;
+                indices.insert(indices.end(), {corner, corner + 1, corner + BENCHMARK_UPLOAD_GRID_SIZE});
+                indices.insert(indices.end(), {corner + 1, corner + BENCHMARK_UPLOAD_GRID_SIZE + 1, corner + BENCHMARK_UPLOAD_GRID_SIZE});
+            }
+        }
+        auto milliseconds = timeMilliseconds([&]{ renderer.addMesh(vertices, indices); });
+        //No warm up, the frames right after the upload starts are the interesting ones...
+        auto &result = runner.measureFrames(name, renderer, false);
+        result.metrics.push_back({"add_mesh_ms", milliseconds});
+    });
+
+    //Re-record every frame with a 10k draw scene, doubling the recording threads up to one per core...
+    runner.addScenario("parallel_recording", [](BenchmarkRunner &runner, const std::string &name){
+        auto renderer = runner.createRenderer();
+        addTriangleGrid(*renderer, BENCHMARK_RECORDING_DRAW_COUNT);
+        renderer->setRecordEveryFrame(true);
+        auto cores = (std::max)(1U, std::thread::hardware_concurrency());
+        auto baseline = 0.0;
+        for (auto threads = 1U; ; threads = (std::min)(threads * 2, cores)){
+            renderer->setRecordingThreadCount(threads);
+            auto &result = runner.measureFrames(name + std::string("_threads_") + std::to_string(threads), *renderer);
+            auto summary = renderer->getRecordingStatistics().getSummary();
+            if (threads == 1)
+                baseline = summary.mean;
+            result.metrics.push_back({"draws", static_cast<double>(BENCHMARK_RECORDING_DRAW_COUNT)});
+            result.metrics.push_back({"recording_threads", static_cast<double>(threads)});
+            result.metrics.push_back({"record_mean_ms", summary.mean});
+            result.metrics.push_back({"record_p95_ms", summary.p95});
+            result.metrics.push_back({"record_speedup", summary.mean > 0.0 ? baseline / summary.mean : 0.0});
+            if (threads == cores)
+                break;
+        }
+    });
+
+    //The same 10k draw scene recorded mesh by mesh on the CPU, then culled and drawn indirectly on the GPU.
+    //The grid is twice the size of the view, so about three quarters of it is culled...
+    runner.addScenario("gpu_driven", [](BenchmarkRunner &runner, const std::string &name){
+        if (!fs::exists(fs::path(getShaderDirectory()) / CULL_SHADER_NAME))
+            return;
+        auto renderer = runner.createRenderer();
+        addTriangleGrid(*renderer, BENCHMARK_GPU_DRIVEN_DRAW_COUNT, 4.0f);
+        renderer->setRecordEveryFrame(true);
+        auto baseline = 0.0;
+        for (auto gpudriven : {false, true}){
+            renderer->setGpuDriven(gpudriven);
+            auto &result = runner.measureFrames(name + (gpudriven ? std::string("_on") : std::string("_off")), *renderer);
+            auto summary = renderer->getRecordingStatistics().getSummary();
+            auto frametime = renderer->getFrameStatistics().getSummary().mean;
+            if (!gpudriven)
+                baseline = frametime;
+            result.metrics.push_back({"draws", static_cast<double>(BENCHMARK_GPU_DRIVEN_DRAW_COUNT)});
+            result.metrics.push_back({"gpu_driven", gpudriven ? 1.0 : 0.0});
+            result.metrics.push_back({"record_mean_ms", summary.mean});
+            result.metrics.push_back({"record_p95_ms", summary.p95});
+            result.metrics.push_back({"frame_speedup", frametime > 0.0 ? baseline / frametime : 0.0});
+        }
+    });
+
+    //Every object in a 10k draw scene changes every frame. Pushed colours re-record the whole scene each frame,
+    //transforms in the uniform ring are only copied in and the recorded buffers are reused...
+    runner.addScenario("uniform_updates", [](BenchmarkRunner &runner, const std::string &name){
+        auto renderer = runner.createRenderer();
+        auto meshes = addTriangleGrid(*renderer, BENCHMARK_UNIFORM_DRAW_COUNT);
+        auto baseline = 0.0;
+        for (auto ring : {false, true}){
+            auto update = [&](uint32_t frame){
+                auto phase = static_cast<float>(frame % 360) / 360.0f;
+                for (auto mesh : meshes){
+                    if (ring)
+                        renderer->setMeshUniforms(mesh, {{0.0f, phase * 0.01f, 1.0f, 0.0f}});
+                    else
+                        renderer->setMeshConstants(mesh, {{1.0f, phase, 1.0f, 1.0f}});
+                }
+            };
+            auto &result = runner.measureFrames(name + (ring ? std::string("_ring") : std::string("_push")), *renderer, true, update);
+            auto summary = renderer->getRecordingStatistics().getSummary();
+            auto frametime = renderer->getFrameStatistics().getSummary().mean;
+            if (!ring)
+                baseline = frametime;
+            result.metrics.push_back({"draws", static_cast<double>(BENCHMARK_UNIFORM_DRAW_COUNT)});
+            result.metrics.push_back({"uniform_ring", ring ? 1.0 : 0.0});
+            result.metrics.push_back({"record_mean_ms", summary.mean});
+            result.metrics.push_back({"records", static_cast<double>(summary.sampleCount)});
+            result.metrics.push_back({"frame_speedup", frametime > 0.0 ? baseline / frametime : 0.0});
+        }
+    });
+
+    //Distinct fixed function states compiled one call at a time against the same number in one batch, each
+    //half of the states is new to the pipeline cache. Then a 10k draw scene is drawn with the variants interleaved...
+    runner.addScenario("pipeline_variants", [](BenchmarkRunner &runner, const std::string &name){
+        BenchmarkCacheDirectory cachedirectory;
+        std::vector <PipelineState> states;
+        for (auto cull : {VK_CULL_MODE_NONE, VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_FRONT_BIT, VK_CULL_MODE_FRONT_AND_BACK})
+            for (auto front : {VK_FRONT_FACE_CLOCKWISE, VK_FRONT_FACE_COUNTER_CLOCKWISE})
+                for (auto blend = 0U; blend < 2; blend++)
+                    for (auto depth = 0U; depth < 4; depth++)
+                        for (auto compare = 0U; compare < 8; compare++){
+                            PipelineState state;
+                            state.cullMode = static_cast<VkCullModeFlags>(cull);
+                            state.frontFace = front;
+                            state.blendEnable = blend ? VK_TRUE : VK_FALSE;
+                            state.depthTestEnable = depth & 1 ? VK_TRUE : VK_FALSE;
+                            state.depthWriteEnable = depth & 2 ? VK_TRUE : VK_FALSE;
+                            state.depthCompareOp = static_cast<VkCompareOp>(compare);
+                            states.push_back(state);
+                        }
+        auto count = (std::min)(static_cast<size_t>(BENCHMARK_PIPELINE_VARIANT_COUNT), states.size() / 2);
+        std::vector <PipelineState> single(states.begin(), states.begin() + count);
+        std::vector <PipelineState> batched(states.begin() + count, states.begin() + count * 2);
+
+        auto renderer = runner.createRenderer();
+        auto singlems = timeMilliseconds([&]{
+            for (const auto & state : single)
+                (void)renderer->addPipelineVariants({state});
+        });
+        std::vector <uint32_t> variants;
+        auto batchedms = timeMilliseconds([&]{ variants = renderer->addPipelineVariants(batched); });
+
+        //Neighbouring draws use different variants, so nearly every draw rebinds...
+        auto meshes = addTriangleGrid(*renderer, BENCHMARK_RECORDING_DRAW_COUNT);
+        for (auto i = 0U; i < meshes.size(); i++)
+            renderer->setMeshPipeline(meshes[i], variants[i % variants.size()]);
+        renderer->setRecordEveryFrame(true);
+        auto &result = runner.measureFrames(name, *renderer);
+        auto summary = renderer->getRecordingStatistics().getSummary();
+        result.metrics.push_back({"variants", static_cast<double>(count)});
+        result.metrics.push_back({"single_create_ms", singlems});
+        result.metrics.push_back({"batched_create_ms", batchedms});
+        result.metrics.push_back({"batch_speedup", batchedms > 0.0 ? singlems / batchedms : 0.0});
+        result.metrics.push_back({"record_mean_ms", summary.mean});
+        result.metrics.push_back({"record_p95_ms", summary.p95});
+    });
+
+    //One fragment shader module specialized with and without its tint. Asking for the same constants again is
+    //a cache hit, so the repeated requests should cost hashing only and leave two pipelines...
+    runner.addScenario("specialization_variants", [](BenchmarkRunner &runner, const std::string &name){
+        std::vector <PipelineState> states;
+        for (auto i = 0U; i < BENCHMARK_PIPELINE_VARIANT_COUNT; i++){
+            PipelineState state;
+            state.specialization.set(0, i % 2 == 0);
+            states.push_back(state);
+        }
+        auto renderer = runner.createRenderer();
+        std::vector <uint32_t> variants;
+        auto createms = timeMilliseconds([&]{ variants = renderer->addPipelineVariants(states); });
+        auto repeatms = timeMilliseconds([&]{ (void)renderer->addPipelineVariants(states); });
+
+        auto meshes = addTriangleGrid(*renderer, BENCHMARK_RECORDING_DRAW_COUNT);
+        for (auto i = 0U; i < meshes.size(); i++)
+            renderer->setMeshPipeline(meshes[i], variants[i % 2]);
+        auto &result = runner.measureFrames(name, *renderer);
+        result.metrics.push_back({"requests", static_cast<double>(states.size())});
+        std::sort(variants.begin(), variants.end());
+        result.metrics.push_back({"variants", static_cast<double>(std::unique(variants.begin(), variants.end()) - variants.begin())});
+        result.metrics.push_back({"create_ms", createms});
+        result.metrics.push_back({"repeat_request_ms", repeatms});
+    });
+
+    //Full screen opaque layers drawn back to front, the worst case for early depth testing since every layer is
+    //nearer than the last. Depth testing alone still shades every layer, a depth pre-pass shades only the front one...
+    runner.addScenario("depth_overdraw", [](BenchmarkRunner &runner, const std::string &name){
+        auto renderer = runner.createRenderer();
+        PipelineState opaque;
+        opaque.blendEnable = VK_FALSE;
+        auto variant = renderer->addPipelineVariants({opaque}).front();
+        for (auto i = 0U; i < BENCHMARK_OVERDRAW_LAYER_COUNT; i++){
+            auto depth = 1.0f - static_cast<float>(i + 1) / (BENCHMARK_OVERDRAW_LAYER_COUNT + 1);
+            auto shade = static_cast<float>(i) / BENCHMARK_OVERDRAW_LAYER_COUNT;
+            auto mesh = renderer->addMesh({
+                {{-1.0f, -1.0f, depth}, {shade, 0.0f, 1.0f - shade}},
+                {{1.0f, -1.0f, depth}, {shade, 1.0f, 1.0f - shade}},
+                {{1.0f, 1.0f, depth}, {shade, 0.0f, 1.0f - shade}},
+                {{-1.0f, 1.0f, depth}, {shade, 1.0f, 1.0f - shade}}
+            }, {0, 1, 2, 2, 3, 0});
+            renderer->setMeshPipeline(mesh, variant);
+        }
+        auto baseline = 0.0, gpubaseline = 0.0;
+        for (auto mode = 0U; mode < GraphicsPipeline::DEPTH_MODE_COUNT; mode++){
+            auto depthmode = static_cast<GraphicsPipeline::DepthMode>(mode);
+            renderer->setDepthMode(depthmode);
+            auto &result = runner.measureFrames(name + std::string("_") + GraphicsPipeline::getDepthModeName(depthmode), *renderer);
+            auto frametime = renderer->getFrameStatistics().getSummary().mean;
+            auto gputime = renderer->hasGpuTimestamps() ? renderer->getGpuStatistics(TimestampQueryPool::RENDER_PASS_SCOPE).getSummary().mean : 0.0;
+            if (depthmode == GraphicsPipeline::NO_DEPTH){
+                baseline = frametime;
+                gpubaseline = gputime;
+            }
+            result.metrics.push_back({"layers", static_cast<double>(BENCHMARK_OVERDRAW_LAYER_COUNT)});
+            result.metrics.push_back({"depth_format", static_cast<double>(renderer->getDepthFormat())});
+            result.metrics.push_back({"frame_speedup", frametime > 0.0 ? baseline / frametime : 0.0});
+            result.metrics.push_back({"render_pass_speedup", gputime > 0.0 ? gpubaseline / gputime : 0.0});
+        }
+    });
+
+    //The same triangle grid at every sample count the device supports, with depth testing so depth is
+    //multisampled too. Samples live in transient attachments and are resolved in the subpass, so the only
+    //bytes stored per frame are the resolved backbuffer's; a stored attachment would write every sample...
+    runner.addScenario("msaa", [](BenchmarkRunner &runner, const std::string &name){
+        auto renderer = runner.createRenderer();
+        addTriangleGrid(*renderer, BENCHMARK_RECORDING_DRAW_COUNT, 2.0f, 0.5f);
+        renderer->setDepthMode(GraphicsPipeline::DEPTH_TEST);
+        auto baseline = 0.0, gpubaseline = 0.0;
+        for (auto samples : {VK_SAMPLE_COUNT_1_BIT, VK_SAMPLE_COUNT_2_BIT, VK_SAMPLE_COUNT_4_BIT, VK_SAMPLE_COUNT_8_BIT}){
+            if (!(renderer->getSupportedSampleCounts() & samples)){
+                LogFile::writeToLog(std::to_string(samples) + std::string("x MSAA isn't supported, skipping it in ") + name + std::string("..."));
+                continue;
+            }
+            renderer->setSampleCount(samples);
+            auto &result = runner.measureFrames(name + std::string("_") + std::to_string(samples) + std::string("x"), *renderer);
+            auto memory = renderer->getTransientMemoryStatistics();
+            auto frametime = renderer->getFrameStatistics().getSummary().mean;
+            auto gputime = renderer->hasGpuTimestamps() ? renderer->getGpuStatistics(TimestampQueryPool::RENDER_PASS_SCOPE).getSummary().mean : 0.0;
+            if (samples == VK_SAMPLE_COUNT_1_BIT){
+                baseline = frametime;
+                gpubaseline = gputime;
+            }
+            result.metrics.push_back({"samples", static_cast<double>(samples)});
+            result.metrics.push_back({"transient_requested_bytes", static_cast<double>(memory.requestedBytes)});
+            result.metrics.push_back({"transient_allocated_bytes", static_cast<double>(memory.allocatedBytes)});
+            result.metrics.push_back({"lazily_allocated_bytes", static_cast<double>(memory.lazilyAllocatedBytes)});
+            result.metrics.push_back({"stored_bytes_per_frame", static_cast<double>(memory.storedBytesPerFrame)});
+            result.metrics.push_back({"store_bytes_avoided_per_frame", static_cast<double>(memory.discardedColorBytesPerFrame)});
+            result.metrics.push_back({"depth_store_bytes_avoided_per_frame", static_cast<double>(memory.discardedDepthBytesPerFrame)});
+            result.metrics.push_back({"frame_time_ratio", baseline > 0.0 ? frametime / baseline : 0.0});
+            result.metrics.push_back({"render_pass_time_ratio", gpubaseline > 0.0 ? gputime / gpubaseline : 0.0});
+        }
+    });
+
+    //A deferred style graph compiled on the current device, with the answers worked out by hand. The debug view
+    //writes nothing the output needs so it's culled, the tonemapped image takes over the G-buffer's slot once
+    //lighting has read it, and depth is preserved through the two subpasses that don't touch it before fog reads it...
+    runner.addScenario("render_graph", [](BenchmarkRunner &runner, const std::string &name){
+        auto renderer = runner.createRenderer(true);
+        auto graph = renderer->createRenderGraph();
+        auto backbuffer = graph->addExternalAttachment("backbuffer", VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        auto depth = graph->addTransientAttachment("depth", VK_FORMAT_D16_UNORM, RenderGraph::DEPTH_ATTACHMENT);
+        auto albedo = graph->addTransientAttachment("albedo", VK_FORMAT_R8G8B8A8_UNORM, RenderGraph::COLOR_ATTACHMENT);
+        auto debug = graph->addTransientAttachment("debug", VK_FORMAT_R8G8B8A8_UNORM, RenderGraph::COLOR_ATTACHMENT);
+        auto lit = graph->addTransientAttachment("lit", VK_FORMAT_R8G8B8A8_UNORM, RenderGraph::COLOR_ATTACHMENT);
+        auto tonemapped = graph->addTransientAttachment("tonemapped", VK_FORMAT_R8G8B8A8_UNORM, RenderGraph::COLOR_ATTACHMENT);
+        auto prepass = graph->addPass("depth_prepass");
+        graph->writeDepth(prepass, depth);
+        auto gbuffer = graph->addPass("gbuffer");
+        graph->readDepth(gbuffer, depth);
+        graph->writeColor(gbuffer, albedo);
+        auto debugview = graph->addPass("debug_view");
+        graph->readInput(debugview, albedo);
+        graph->writeColor(debugview, debug);
+        auto lighting = graph->addPass("lighting");
+        graph->readInput(lighting, albedo);
+        graph->writeColor(lighting, lit);
+        auto tonemap = graph->addPass("tonemap");
+        graph->readInput(tonemap, lit);
+        graph->writeColor(tonemap, tonemapped);
+        auto fog = graph->addPass("fog");
+        graph->readInput(fog, depth);
+        graph->readInput(fog, tonemapped);
+        graph->writeColor(fog, backbuffer);
+        graph->setOutput(backbuffer);
+        auto compilems = timeMilliseconds([&]{ graph->compile(); });
+
+        //Five chained subpasses, a dependency from each to the next plus prepass to fog, an external one into
+        //each first use and one out of fog. The slot handover from G-buffer to tonemapped folds into lighting to tonemap...
+        const auto expectedsubpasses = 5U, expectedtransients = 4U, expectedslots = 3U;
+        const size_t expecteddependencies = 11, expectedpreserves = 2;
+        const auto & memory = graph->getMemoryStatistics();
+        auto culled = graph->isCulled(debugview) && !graph->isCulled(prepass) && !graph->isCulled(fog);
+        auto matches = culled &&
+                graph->getSubpassCount() == expectedsubpasses &&
+                memory.transientCount == expectedtransients &&
+                memory.aliasSlotCount == expectedslots &&
+                graph->getDependencyCount() == expecteddependencies &&
+                graph->getPreserveCount() == expectedpreserves;
+        if (!matches)
+            LOG_ERROR(name + std::string(" compiled a render pass that doesn't match the expected one!"));
+        auto &result = runner.addResult(name);
+        result.metrics = {
+            {"passes", 6.0},
+            {"subpasses", static_cast<double>(graph->getSubpassCount())},
+            {"debug_view_culled", graph->isCulled(debugview) ? 1.0 : 0.0},
+            {"transients", static_cast<double>(memory.transientCount)},
+            {"alias_slots", static_cast<double>(memory.aliasSlotCount)},
+            {"dependencies", static_cast<double>(graph->getDependencyCount())},
+            {"preserves", static_cast<double>(graph->getPreserveCount())},
+            {"matches_expected", matches ? 1.0 : 0.0},
+            {"compile_ms", compilems}
+        };
+        graph->cleanup();
+    });
+
+    //Aggregate frame rate as logical devices are added, spread across physical devices, each on its own render thread.
+    //The last device added stays on this thread, so one device is the plain single threaded loop...
+    runner.addScenario("device_scaling", [](BenchmarkRunner &runner, const std::string &name){
+        const auto maxdevices = static_cast<uint32_t>(MAX_NUM_PHYSICAL_DEVICES_SUPPORTED * MAX_NUM_LOGICAL_DEVICES_PER_PHYSICAL_DEVICE_ALLOWED);
+        for (auto devicecount = 1U; devicecount <= maxdevices; devicecount++){
+            auto renderer = runner.createRenderer(true);
+            std::array<QueueInfo, 2> flags = {
+                QueueInfo(VK_QUEUE_GRAPHICS_BIT, std::vector<float> {1.0}),
+                QueueInfo(VK_QUEUE_COMPUTE_BIT, std::vector<float> {1.0})
+            };
+            VkPhysicalDeviceFeatures features {};
+            auto physicaldevices = (std::min)(renderer->getPhysicalDeviceCount(), static_cast<uint32_t>(MAX_NUM_PHYSICAL_DEVICES_SUPPORTED));
+            auto devices = 1U;
+            for (auto i = 0U; devices < devicecount && i < maxdevices; i++){
+                auto physicaldevice = i % physicaldevices;
+                if (renderer->getLogicalDeviceCount(physicaldevice) >= MAX_NUM_LOGICAL_DEVICES_PER_PHYSICAL_DEVICE_ALLOWED)
+                    continue;
+                renderer->addLogicalDevice(flags, features, nullptr, std::vector<const char *> {}, std::vector<const char *> {VK_KHR_SWAPCHAIN_EXTENSION_NAME}, static_cast<int>(physicaldevice));
+                renderer->addMesh(
+                            std::vector<Vertex> {
+                                {{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+                                {{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+                                {{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}}
+                            },
+                            std::vector<uint32_t> {0, 1, 2}
+                            );
+                devices++;
+            }
+            if (devices < devicecount){
+                LogFile::writeToLog(std::string("Only ") + std::to_string(devices) + std::string(" logical devices fit on this machine, stopping ") + name + std::string("..."));
+                break;
+            }
+
+            //Warm every device up before the clock starts...
+            renderer->startRenderThreads();
+            for (auto i = 0U; i < runner.getOptions().warmupFrames; i++)
+                renderer->drawFrame();
+            auto threadframes = renderer->getRenderThreadFrameCount();
+            auto t1 = std::chrono::steady_clock::now();
+            for (auto i = 0U; i < runner.getOptions().measuredFrames; i++)
+                renderer->drawFrame();
+            auto t2 = std::chrono::steady_clock::now();
+            threadframes = renderer->getRenderThreadFrameCount() - threadframes;
+            auto threads = renderer->getRenderThreadCount();
+            renderer->stopRenderThreads();
+
+            auto seconds = std::chrono::duration<double>(t2 - t1).count();
+            auto frames = static_cast<double>(runner.getOptions().measuredFrames + threadframes);
+            auto &result = runner.addResult(name + std::string("_devices_") + std::to_string(devicecount));
+            result.metrics = {
+                {"logical_devices", static_cast<double>(devicecount)},
+                {"physical_devices", static_cast<double>(physicaldevices)},
+                {"render_threads", static_cast<double>(threads)},
+                {"frames", frames},
+                {"aggregate_fps", seconds > 0.0 ? frames / seconds : 0.0},
+                {"per_device_fps", seconds > 0.0 ? frames / seconds / devicecount : 0.0},
+                {"calling_thread_fps", seconds > 0.0 ? runner.getOptions().measuredFrames / seconds : 0.0}
+            };
+        }
+    });
+
+    //Cost of a log call as more threads log at once, and how many records the drain thread couldn't keep up with...
+    runner.addScenario("logger_contention", [](BenchmarkRunner &runner, const std::string &name){
+        auto cores = (std::max)(1U, std::thread::hardware_concurrency());
+        for (auto threads = 1U; ; threads = (std::min)(threads * 2, cores)){
+            LogFile::flush();
+            auto before = LogFile::getStatistics();
+            std::vector<std::thread> loggers;
+            std::vector<double> nanoseconds(threads);
+            for (auto i = 0U; i < threads; i++){
+                loggers.push_back(std::thread([i, &nanoseconds]{
+                    auto message = std::string("Benchmark log record from thread ") + std::to_string(i);
+                    auto t1 = std::chrono::steady_clock::now();
+                    for (auto j = 0U; j < BENCHMARK_LOG_CALLS_PER_THREAD; j++)
+                        LogFile::writeToLog(message, LogFile::TRACE_LEVEL);
+                    auto t2 = std::chrono::steady_clock::now();
+                    nanoseconds[i] = std::chrono::duration<double, std::nano>(t2 - t1).count();
+                }));
+            }
+            for (auto &logger : loggers)
+                logger.join();
+            LogFile::flush();
+            auto after = LogFile::getStatistics();
+            auto total = 0.0, slowest = 0.0;
+            for (auto time : nanoseconds){
+                total += time;
+                slowest = (std::max)(slowest, time);
+            }
+            auto calls = static_cast<double>(threads) * BENCHMARK_LOG_CALLS_PER_THREAD;
+            auto &result = runner.addResult(name + std::string("_threads_") + std::to_string(threads));
+            result.metrics = {
+                {"threads", static_cast<double>(threads)},
+                {"calls", calls},
+                {"ns_per_call", total / calls},
+                {"calls_per_second", slowest > 0.0 ? calls / (slowest / 1e9) : 0.0},
+                {"written", static_cast<double>(after.written - before.written)},
+                {"dropped", static_cast<double>(after.dropped - before.dropped)},
+                {"overflows", static_cast<double>(after.overflows - before.overflows)}
+            };
+            if (threads == cores)
+                break;
+        }
+    });
+    runner.runAll();
+
+    for (const auto &result : runner.getResults()){
+        std::string line = result.scenario + std::string(":");
+        for (const auto &metric : result.metrics)
+            line += std::string(" ") + metric.first + std::string("=") + std::to_string(metric.second);
+        LogFile::writeToLog(line);
+    }
+    runner.writeCsv(options.csvPath);
+    runner.writeJson(options.jsonPath);
+    return 0;
+}
+
+#ifdef _WIN32
+int WINAPI WinMain(
+        HINSTANCE hInstance,
+        HINSTANCE hPrevInstance,
+        LPSTR lpCmdLine,
+        int nShowCmd
+        )
+{
+    std::vector<std::string> arguments;
+    std::istringstream stream(lpCmdLine ? lpCmdLine : "");
+    for (std::string argument; stream >> argument;)
+        arguments.push_back(argument);
+    BenchmarkOptions options(arguments);
+
+    //Pass --headless to benchmark offscreen rendering on Windows too...
+    if (options.headless){
+        WindowCreateInfo createinfo(options.extent);
+        return run(options, createinfo);
+    }
+    WindowCreateInfo createinfo(hInstance, hPrevInstance, lpCmdLine, nShowCmd);
+    return run(options, createinfo);
+}
+#else
+int main(int argc, char *argv[]){
+    BenchmarkOptions options(std::vector<std::string>(argv + 1, argv + argc));
+
+    //Pass --windowed to benchmark through an XCB window...
+    WindowCreateInfo createinfo(options.extent, options.headless);
+    return run(options, createinfo);
+}
+#endif
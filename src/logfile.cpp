@@ -0,0 +1,247 @@
+#include "logfile.h"
+#include "utility.h"
+#include <cstdio>
+#include <algorithm>
+
+/*!
+        \class LogFile
+        \brief The LogFile class writes log records to logs/debug.txt from a background thread.
+
+        \threadsafe
+
+        Each thread that logs gets a ring buffer of its own on its first call. Only that thread writes to the ring
+        and only the drain thread reads from it, so writeToLog() never takes a lock or touches the file. The message
+        is copied into a fixed size record, truncated if it's too long, and the call returns. If the ring is full
+        the record is dropped and counted rather than blocking the caller. The drain thread wakes every
+        LOG_DRAIN_INTERVAL_MS, formats whatever has queued up across all rings into one batch, and writes the batch
+        with a single call. Any drops since the last batch are reported in the log itself.
+
+        Rings are kept until the LogFile is destroyed and are handed to new threads once their thread exits, so
+        short lived threads don't grow the ring list. Only one LogFile may be open at a time, and messages logged
+        while none is open are discarded. The LOG_TRACE to LOG_ERROR macros compile away below LOG_MINIMUM_LEVEL.
+*/
+
+std::ofstream LogFile::logFile;
+std::mutex LogFile::mutex;
+std::condition_variable LogFile::drainRequested;
+std::condition_variable LogFile::drainFinished;
+std::vector <std::unique_ptr<LogFile::Ring>> LogFile::rings;
+std::thread LogFile::drainThread;
+std::atomic<bool> LogFile::running(false);
+std::atomic<uint32_t> LogFile::pushesInFlight(0);
+std::chrono::steady_clock::time_point LogFile::startTime;
+uint64_t LogFile::written = 0;
+uint64_t LogFile::reportedDrops = 0;
+uint64_t LogFile::drainPasses = 0;
+thread_local LogFile::RingHandle LogFile::ringHandle;
+
+LogFile::RingHandle::~RingHandle(){
+    //Whatever the thread logged is still drained, a new thread can carry on from where it left off...
+    if (ring)
+        ring->owned.store(false, std::memory_order_release);
+}
+
+LogFile::LogFile(){
+    if (running.load())
+        throw std::runtime_error("Only one LogFile may be open at a time!");
+
+    //Generate path to log file...
+    auto currentpath = fs::current_path().u8string();
+    auto index = currentpath.find_last_of('\\');
+    std::string logpath = PATH_TO_LOG_DIRECTORY_WINDOWS;
+    if (index == (std::numeric_limits<size_t>::max)()){ //Not Windows...
+        index = currentpath.find_last_of('/');
+        logpath = PATH_TO_LOG_DIRECTORY_LINUX;
+        if (index == (std::numeric_limits<size_t>::max)())
+            throw std::runtime_error("LogFile: Invalid directory path!");
+    }
+    index++;
+    currentpath.resize(currentpath.size() + 1 + logpath.size() - sizeof("build"));
+    auto j = 0U;
+    while (index < currentpath.size())
+        currentpath[index++] = logpath[j++];
+    currentpath[index] = '\0';
+    logFile.open(currentpath, std::ios::out | std::ios::trunc);
+
+    startTime = std::chrono::steady_clock::now();
+    written = 0;
+    reportedDrops = 0;
+    running.store(true);
+    drainThread = std::thread(&LogFile::drainLoop);
+}
+
+LogFile::~LogFile(){
+    //The drain thread empties the rings one last time, once no push is still writing a record, before it exits...
+    {
+        std::lock_guard <std::mutex> guard(mutex);
+        running.store(false);
+    }
+    drainRequested.notify_all();
+    drainThread.join();
+    logFile << "\n\nApplication closing... Bye..\n";
+    logFile.close();
+}
+
+void LogFile::writeToLog(const char * message, Level level) noexcept{
+    push(message, message ? std::strlen(message) : 0, level);
+}
+
+void LogFile::writeToLog(const std::string & message, Level level) noexcept{
+    push(message.data(), message.size(), level);
+}
+
+void LogFile::writeToLog(const std::vector <std::string> & messages, Level level) noexcept{
+    for (const auto & message : messages)
+        push(message.data(), message.size(), level);
+}
+
+void LogFile::flush(){
+    //The pass running when we ask may have already passed our ring, so wait for the one after it as well...
+    std::unique_lock <std::mutex> lock(mutex);
+    auto target = drainPasses + 2;
+    drainRequested.notify_all();
+    drainFinished.wait(lock, [&]{ return drainPasses >= target || !running.load(); });
+}
+
+LogFile::Statistics LogFile::getStatistics(){
+    std::lock_guard <std::mutex> guard(mutex);
+    Statistics statistics = {written, 0, 0, rings.size()};
+    for (const auto & ring : rings){
+        statistics.dropped += ring->dropped.load(std::memory_order_relaxed);
+        statistics.overflows += ring->overflows.load(std::memory_order_relaxed);
+    }
+    return statistics;
+}
+
+const char * LogFile::getLevelName(Level level) noexcept{
+    switch (level){
+    case TRACE_LEVEL: return "TRACE";
+    case DEBUG_LEVEL: return "DEBUG";
+    case INFO_LEVEL: return "INFO";
+    case WARNING_LEVEL: return "WARNING";
+    case ERROR_LEVEL: return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+void LogFile::push(const char * message, size_t length, Level level) noexcept{
+    //Counted before running is checked, so the last drain can wait for a push that got past the check
+    //just before shutdown, and anything after it sees running cleared...
+    pushesInFlight.fetch_add(1);
+    if (running.load())
+        publish(message, length, level);
+    pushesInFlight.fetch_sub(1);
+}
+
+void LogFile::publish(const char * message, size_t length, Level level) noexcept{
+    Ring *ring;
+    try {
+        ring = getRing();
+    } catch (...) {
+        return;
+    }
+
+    //Single producer, so only the consumer's tail needs an acquire...
+    auto head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= LOG_RING_CAPACITY){
+        if (!ring->overflowing)
+            ring->overflows.fetch_add(1, std::memory_order_relaxed);
+        ring->overflowing = true;
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->overflowing = false;
+    auto & record = ring->records[head & (LOG_RING_CAPACITY - 1)];
+    record.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count());
+    record.level = static_cast<uint32_t>(level);
+    record.length = static_cast<uint32_t>((std::min)(length, sizeof(record.text)));
+    if (record.length)
+        std::memcpy(record.text, message, record.length);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+LogFile::Ring * LogFile::getRing(){
+    if (ringHandle.ring)
+        return ringHandle.ring;
+
+    //First call on this thread, reuse a ring whose thread has exited or add a new one...
+    std::lock_guard <std::mutex> guard(mutex);
+    for (auto & ring : rings){
+        auto owned = false;
+        if (ring->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)){
+            ringHandle.ring = ring.get();
+            return ringHandle.ring;
+        }
+    }
+    auto ring = std::make_unique<Ring>();
+    ring->head.store(0);
+    ring->tail.store(0);
+    ring->dropped.store(0);
+    ring->overflows.store(0);
+    ring->owned.store(true);
+    ring->overflowing = false;
+    ring->thread = static_cast<uint32_t>(rings.size());
+    ringHandle.ring = ring.get();
+    rings.push_back(std::move(ring));
+    return ringHandle.ring;
+}
+
+void LogFile::drainLoop(){
+    std::string batch;
+    std::unique_lock <std::mutex> lock(mutex);
+    for (;;){
+        auto stopping = !running.load() && !pushesInFlight.load();
+        if (!stopping)
+            drainRequested.wait_for(lock, std::chrono::milliseconds(LOG_DRAIN_INTERVAL_MS));
+        stopping = !running.load() && !pushesInFlight.load();
+        drainRings(batch);
+
+        //Write without the lock so new threads can still register their rings...
+        if (!batch.empty()){
+            lock.unlock();
+            logFile << batch;
+            logFile.flush();
+            batch.clear();
+            lock.lock();
+        }
+        drainPasses++;
+        drainFinished.notify_all();
+        if (stopping)
+            return;
+    }
+}
+
+void LogFile::drainRings(std::string & batch){
+    char prefix[64];
+    uint64_t dropped = 0;
+    for (auto & ring : rings){
+        auto tail = ring->tail.load(std::memory_order_relaxed);
+        auto head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; tail++){
+            const auto & record = ring->records[tail & (LOG_RING_CAPACITY - 1)];
+            std::snprintf(
+                        prefix,
+                        sizeof(prefix),
+                        "[%llu.%06llu][%s][%u] ",
+                        static_cast<unsigned long long>(record.timestamp / 1000000),
+                        static_cast<unsigned long long>(record.timestamp % 1000000),
+                        getLevelName(static_cast<Level>(record.level)),
+                        ring->thread
+                        );
+            batch.append(prefix);
+            batch.append(record.text, record.length);
+            batch.push_back('\n');
+            written++;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+
+    //Note any records that didn't fit since the last batch...
+    if (dropped > reportedDrops){
+        batch.append("[LogFile] ");
+        batch.append(std::to_string(dropped - reportedDrops));
+        batch.append(" records dropped, a ring buffer was full\n");
+        reportedDrops = dropped;
+    }
+}
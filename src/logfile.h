@@ -0,0 +1,133 @@
+#ifndef LOGFILE_H
+#define LOGFILE_H
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_ERROR 4
+#ifndef LOG_MINIMUM_LEVEL
+#ifdef NDEBUG
+#define LOG_MINIMUM_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_MINIMUM_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif
+#define LOG_RING_CAPACITY 4096
+#define LOG_RECORD_SIZE 256
+#define LOG_DRAIN_INTERVAL_MS 2
+
+class LogFile final
+{
+public:
+    enum Level {
+        TRACE_LEVEL = LOG_LEVEL_TRACE,
+        DEBUG_LEVEL = LOG_LEVEL_DEBUG,
+        INFO_LEVEL = LOG_LEVEL_INFO,
+        WARNING_LEVEL = LOG_LEVEL_WARNING,
+        ERROR_LEVEL = LOG_LEVEL_ERROR
+    };
+    struct Statistics final
+    {
+        uint64_t written;
+        uint64_t dropped;
+        uint64_t overflows;
+        size_t threadCount;
+    };
+private:
+    struct Record final
+    {
+        uint64_t timestamp;
+        uint32_t level;
+        uint32_t length;
+        char text[LOG_RECORD_SIZE - 16];
+    };
+    struct Ring final
+    {
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+        alignas(64) std::atomic<uint64_t> dropped;
+        std::atomic<uint64_t> overflows;
+        std::atomic<bool> owned;
+        bool overflowing;
+        uint32_t thread;
+        Record records[LOG_RING_CAPACITY];
+    };
+    struct RingHandle final
+    {
+        ~RingHandle();
+        Ring *ring = nullptr;
+    };
+public:
+    LogFile();
+    ~LogFile();
+public:
+    LogFile(const LogFile & other) = delete;
+    LogFile & operator=(const LogFile & other) = delete;
+    LogFile(const LogFile && other) = delete;
+    LogFile & operator=(const LogFile && other) = delete;
+public:
+    static void writeToLog(const char * message, Level level = INFO_LEVEL) noexcept;
+    static void writeToLog(const std::string & message, Level level = INFO_LEVEL) noexcept;
+    static void writeToLog(const std::vector <std::string> & messages, Level level = INFO_LEVEL) noexcept;
+    static void flush();
+    [[nodiscard]] static Statistics getStatistics();
+    [[nodiscard]] static const char * getLevelName(Level level) noexcept;
+private:
+    static void push(const char * message, size_t length, Level level) noexcept;
+    static void publish(const char * message, size_t length, Level level) noexcept;
+    [[nodiscard]] static Ring * getRing();
+    static void drainLoop();
+    static void drainRings(std::string & batch);
+private:
+    static std::ofstream logFile;
+    static std::mutex mutex;
+    static std::condition_variable drainRequested;
+    static std::condition_variable drainFinished;
+    static std::vector <std::unique_ptr<Ring>> rings;
+    static std::thread drainThread;
+    static std::atomic<bool> running;
+    static std::atomic<uint32_t> pushesInFlight;
+    static std::chrono::steady_clock::time_point startTime;
+    static uint64_t written;
+    static uint64_t reportedDrops;
+    static uint64_t drainPasses;
+    static thread_local RingHandle ringHandle;
+};
+
+//Calls below LOG_MINIMUM_LEVEL compile away entirely, arguments included...
+#if LOG_MINIMUM_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(message) LogFile::writeToLog(message, LogFile::TRACE_LEVEL)
+#else
+#define LOG_TRACE(message) ((void)0)
+#endif
+#if LOG_MINIMUM_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(message) LogFile::writeToLog(message, LogFile::DEBUG_LEVEL)
+#else
+#define LOG_DEBUG(message) ((void)0)
+#endif
+#if LOG_MINIMUM_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(message) LogFile::writeToLog(message, LogFile::INFO_LEVEL)
+#else
+#define LOG_INFO(message) ((void)0)
+#endif
+#if LOG_MINIMUM_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(message) LogFile::writeToLog(message, LogFile::WARNING_LEVEL)
+#else
+#define LOG_WARNING(message) ((void)0)
+#endif
+#define LOG_ERROR(message) LogFile::writeToLog(message, LogFile::ERROR_LEVEL)
+
+#endif // LOGFILE_H
@@ -1,20 +1,16 @@
 #include "src/renderer/vulkanrenderer.h"
-#include <iostream>
-#include <chrono>
-#include <thread>
 #include <array>
+#include <cstdlib>
 #include "utility.h"
 
-int WINAPI WinMain(
-        HINSTANCE hInstance,
-        HINSTANCE hPrevInstance,
-        LPSTR lpCmdLine,
-        int nShowCmd
-        )
-{
+static int run(WindowCreateInfo &createinfo){
     static LogFile logfile;
-    WindowCreateInfo createinfo(hInstance, hPrevInstance, lpCmdLine, nShowCmd);
-    VulkanRenderer renderer(createinfo);
+
+    //Validation layers usually aren't installed on headless render boxes...
+    std::vector<const char *> layers;
+    if (!createinfo.headless)
+        layers.push_back("VK_LAYER_LUNARG_standard_validation");
+    VulkanRenderer renderer(createinfo, layers);
     std::array<QueueInfo, 2> flags = {
         QueueInfo(VK_QUEUE_GRAPHICS_BIT, std::vector<float> {1.0}),
         QueueInfo(VK_QUEUE_COMPUTE_BIT, std::vector<float> {1.0})
@@ -24,24 +20,89 @@ int WINAPI WinMain(
     features.geometryShader = VK_TRUE;
     features.tessellationShader = VK_TRUE;
     renderer.addLogicalDevice(flags, features);
-    uint16_t index = 0;
-    std::array <uint64_t, (std::numeric_limits<uint8_t>::max)()> frametimes;
+
+    //The triangle that used to be hard coded in the vertex shader...
+    renderer.addMesh(
+                std::vector<Vertex> {
+                    {{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+                    {{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+                    {{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}}
+                },
+                std::vector<uint32_t> {0, 1, 2}
+                );
+
+    //A ribbon of 64 columns animated by shader.comp on the async compute queue...
+    renderer.addComputeMesh("comp.spv", 128, 63 * 6);
+
+#ifndef NDEBUG
+    //Recompiled shaders are swapped in while running...
+    renderer.setShaderHotReload(true);
+#endif
+
+    //Log how much device memory each heap has reserved and handed out...
+    auto heaps = renderer.getMemoryStatistics();
+    for (auto i = 0U; i < heaps.size(); i++){
+        LogFile::writeToLog(
+                    std::string("Memory heap ") + std::to_string(i) + std::string(" (") + std::to_string(heaps[i].heapSize >> 20) + std::string(" MiB): ") +
+                    std::to_string(heaps[i].reservedBytes >> 10) + std::string(" KiB reserved, ") +
+                    std::to_string(heaps[i].usedBytes >> 10) + std::string(" KiB used, ") +
+                    std::to_string(heaps[i].blockCount) + std::string(" blocks, ") +
+                    std::to_string(heaps[i].dedicatedAllocationCount) + std::string(" dedicated allocations, ") +
+                    std::to_string(heaps[i].subAllocationCount) + std::string(" sub-allocations")
+                    );
+    }
+    uint64_t frames = 0;
     while (renderer.keepRendering()){
-        auto t1 = std::chrono::system_clock::now();
         renderer.drawFrame();
-        auto t2 = std::chrono::system_clock::now();
-        auto int_us = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count()/100;
-        //LogFile::writeToLog(std::string("Frametime (rounded): ") + std::to_string(int_us) + std::string(" us"));
-        frametimes[index++] = int_us;
-        if (index == frametimes.size()){
-            uint64_t avg = 0;
-            for (auto i : frametimes)
-                avg = avg + i;
-            avg = avg/frametimes.size();
-            LogFile::writeToLog(std::string("\nFPS (rounded): ") + std::to_string(int_us) + std::string("\n"));
-            index = 0;
+
+        //Log a summary each time the statistics window has filled...
+        if (++frames % FRAME_STATISTICS_WINDOW_SIZE == 0){
+            auto summary = renderer.getFrameStatistics().getSummary();
+            LogFile::writeToLog(
+                        std::string("Frame time (ms) over ") + std::to_string(summary.sampleCount) + std::string(" frames: ") +
+                        std::string("min ") + std::to_string(summary.minimum) +
+                        std::string(", mean ") + std::to_string(summary.mean) +
+                        std::string(", p50 ") + std::to_string(summary.p50) +
+                        std::string(", p95 ") + std::to_string(summary.p95) +
+                        std::string(", p99 ") + std::to_string(summary.p99) +
+                        std::string(", max ") + std::to_string(summary.maximum) +
+                        std::string(", FPS ") + std::to_string(summary.mean > 0.0 ? 1000.0 / summary.mean : 0.0) +
+                        std::string(", stutters ") + std::to_string(summary.stutterCount)
+                        );
+            for (auto scope = 0U; renderer.hasGpuTimestamps() && scope < TimestampQueryPool::SCOPE_COUNT; scope++){
+                auto gpusummary = renderer.getGpuStatistics(static_cast<TimestampQueryPool::Scope>(scope)).getSummary();
+                LogFile::writeToLog(
+                            std::string("GPU ") + TimestampQueryPool::getScopeName(static_cast<TimestampQueryPool::Scope>(scope)) +
+                            std::string(" time (ms): mean ") + std::to_string(gpusummary.mean) +
+                            std::string(", p95 ") + std::to_string(gpusummary.p95) +
+                            std::string(", max ") + std::to_string(gpusummary.maximum)
+                            );
+            }
         }
-        //std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
     return 0;
 }
+
+#ifdef _WIN32
+int WINAPI WinMain(
+        HINSTANCE hInstance,
+        HINSTANCE hPrevInstance,
+        LPSTR lpCmdLine,
+        int nShowCmd
+        )
+{
+    WindowCreateInfo createinfo(hInstance, hPrevInstance, lpCmdLine, nShowCmd);
+    return run(createinfo);
+}
+#else
+int main(){
+#ifdef VK_USE_PLATFORM_XCB_KHR
+    //Open an XCB window when there's an X server to show it on, otherwise render offscreen...
+    WindowCreateInfo createinfo(VK_EXTENT_1080_P, !std::getenv("DISPLAY"));
+#else
+    //No window backend was built, render offscreen...
+    WindowCreateInfo createinfo(VK_EXTENT_1080_P);
+#endif
+    return run(createinfo);
+}
+#endif
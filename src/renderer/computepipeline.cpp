@@ -0,0 +1,149 @@
+#include "computepipeline.h"
+
+/*!
+        \class ComputePipeline
+        \brief The ComputePipeline class wraps a compute shader along with its pipeline and descriptor set layout.
+
+        Every binding in set 0 is a dynamic storage buffer, bindings 0 to storageBufferCount - 1, so one descriptor
+        set can address a different region of the same buffers each frame through its dynamic offsets. Push
+        constants, if any, are visible to the compute stage only. The set layout comes from the device's layout
+        cache and descriptor sets from whichever allocator the caller passes in, usually the long lived one.
+
+        Specialization constant COMPUTE_WORKGROUP_SIZE_CONSTANT_ID is the workgroup size. Shaders that declare
+        local_size_x_id with it get COMPUTE_WORKGROUP_SIZE unless the caller specializes it to something else.
+*/
+
+ComputePipeline::ComputePipeline(
+        VkDevice *device,
+        const std::string & shaderpath,
+        uint32_t storagebuffercount,
+        uint32_t pushconstantsize,
+        DescriptorLayoutCache & layoutcache,
+        VkPipelineCache pipelinecache,
+        const SpecializationConstants & specialization
+        )
+    : logicalDevice(device),
+      name(fs::path(shaderpath).filename().u8string()),
+      shader(VK_NULL_HANDLE),
+      descriptorSetLayout(VK_NULL_HANDLE),
+      pipelineLayout(VK_NULL_HANDLE),
+      pipeline(VK_NULL_HANDLE),
+      storageBufferCount(storagebuffercount),
+      pushConstantSize(pushconstantsize)
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to ComputePipeline!");
+    if (!storagebuffercount)
+        throw std::runtime_error("A compute pipeline needs at least one storage buffer!");
+
+    //Load the shader...
+    MappedFile code(shaderpath);
+    if (!code.getSize())
+        throw std::runtime_error("Empty shader found!");
+    VkShaderModuleCreateInfo shaderInfo = {};
+    shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shaderInfo.codeSize = code.getSize();
+    shaderInfo.pCode = reinterpret_cast<const uint32_t*>(code.getData());
+    if (vkCreateShaderModule(*logicalDevice, &shaderInfo, nullptr, &shader) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create shader module!");
+
+    //One dynamic storage buffer per binding, pipelines with the same count share a layout...
+    std::vector <VkDescriptorSetLayoutBinding> bindings(storageBufferCount);
+    for (auto i = 0U; i < storageBufferCount; i++){
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    descriptorSetLayout = layoutcache.getLayout(bindings);
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = pushConstantSize;
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = pushConstantSize ? 1 : 0;
+    pipelineLayoutInfo.pPushConstantRanges = pushConstantSize ? &pushConstantRange : nullptr;
+    if (vkCreatePipelineLayout(*logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create compute pipeline layout!");
+
+    //The dispatch sizes assume COMPUTE_WORKGROUP_SIZE, so that's what the workgroup is specialized to by default...
+    auto constants = specialization;
+    if (!constants.contains(COMPUTE_WORKGROUP_SIZE_CONSTANT_ID))
+        constants.set(COMPUTE_WORKGROUP_SIZE_CONSTANT_ID, static_cast<uint32_t>(COMPUTE_WORKGROUP_SIZE));
+    auto specializationInfo = constants.getInfo();
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shader;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.stage.pSpecializationInfo = &specializationInfo;
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+    if (vkCreateComputePipelines(*logicalDevice, pipelinecache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create compute pipeline!");
+}
+
+const std::string & ComputePipeline::getName() const noexcept{
+    return name;
+}
+
+VkDescriptorSet ComputePipeline::allocateDescriptorSet(DescriptorAllocator & allocator, const std::vector<VkDescriptorBufferInfo> & buffers) const{
+    auto descriptorset = allocator.allocate(descriptorSetLayout);
+    updateDescriptorSet(descriptorset, buffers);
+    return descriptorset;
+}
+
+void ComputePipeline::updateDescriptorSet(VkDescriptorSet descriptorset, const std::vector<VkDescriptorBufferInfo> & buffers) const{
+    if (buffers.size() != storageBufferCount)
+        throw std::runtime_error("Wrong number of storage buffers passed to a compute descriptor set!");
+
+    //The set must not be in use by any pending command buffer...
+    std::vector <VkWriteDescriptorSet> writes(buffers.size());
+    for (auto i = 0U; i < buffers.size(); i++){
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = descriptorset;
+        writes[i].dstBinding = i;
+        writes[i].dstArrayElement = 0;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        writes[i].pBufferInfo = &buffers[i];
+    }
+    vkUpdateDescriptorSets(*logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void ComputePipeline::dispatch(
+        VkCommandBuffer commandbuffer,
+        VkDescriptorSet descriptorset,
+        const std::vector<uint32_t> & dynamicoffsets,
+        uint32_t groupcount,
+        const void *pushconstants
+        ) const
+{
+    vkCmdBindPipeline(commandbuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(
+                commandbuffer,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                pipelineLayout,
+                0,
+                1,
+                &descriptorset,
+                static_cast<uint32_t>(dynamicoffsets.size()),
+                dynamicoffsets.data()
+                );
+    if (pushconstants && pushConstantSize)
+        vkCmdPushConstants(commandbuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, pushconstants);
+    vkCmdDispatch(commandbuffer, groupcount, 1, 1);
+}
+
+void ComputePipeline::cleanup() noexcept{
+    //Sets belong to the allocator they came from and the layout to the cache...
+    vkDestroyPipeline(*logicalDevice, pipeline, nullptr);
+    vkDestroyPipelineLayout(*logicalDevice, pipelineLayout, nullptr);
+    vkDestroyShaderModule(*logicalDevice, shader, nullptr);
+}
@@ -0,0 +1,53 @@
+#ifndef COMPUTEPIPELINE_H
+#define COMPUTEPIPELINE_H
+
+#include "src/utility.h"
+#include "mappedfile.h"
+#include "descriptorlayoutcache.h"
+#include "descriptorallocator.h"
+#include "specializationconstants.h"
+
+class ComputePipeline final
+{
+    friend class LogicalDevice;
+    friend class IndirectDrawList;
+public:
+    ComputePipeline(
+            VkDevice *device,
+            const std::string & shaderpath,
+            uint32_t storagebuffercount,
+            uint32_t pushconstantsize,
+            DescriptorLayoutCache & layoutcache,
+            VkPipelineCache pipelinecache = VK_NULL_HANDLE,
+            const SpecializationConstants & specialization = SpecializationConstants()
+            );
+public:
+    ComputePipeline() = default;
+    ~ComputePipeline() = default;
+    ComputePipeline(const ComputePipeline & other) = default;
+    ComputePipeline & operator=(const ComputePipeline & other) = default;
+public:
+    [[nodiscard]] const std::string & getName() const noexcept;
+private:
+    [[nodiscard]] VkDescriptorSet allocateDescriptorSet(DescriptorAllocator & allocator, const std::vector<VkDescriptorBufferInfo> & buffers) const;
+    void updateDescriptorSet(VkDescriptorSet descriptorset, const std::vector<VkDescriptorBufferInfo> & buffers) const;
+    void dispatch(
+            VkCommandBuffer commandbuffer,
+            VkDescriptorSet descriptorset,
+            const std::vector<uint32_t> & dynamicoffsets,
+            uint32_t groupcount,
+            const void *pushconstants = nullptr
+            ) const;
+    void cleanup() noexcept;
+private:
+    VkDevice *logicalDevice;
+    std::string name;
+    VkShaderModule shader;
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkPipelineLayout pipelineLayout;
+    VkPipeline pipeline;
+    uint32_t storageBufferCount;
+    uint32_t pushConstantSize;
+};
+
+#endif // COMPUTEPIPELINE_H
@@ -0,0 +1,114 @@
+#include "descriptorallocator.h"
+#include <algorithm>
+
+/*!
+        \class DescriptorAllocator
+        \brief The DescriptorAllocator class hands out descriptor sets from a growing list of descriptor pools.
+
+        When a pool runs out another one is created, each twice the size of the last up to
+        DESCRIPTOR_POOL_MAX_SET_COUNT sets, so pools are never sized up front for the worst case. Pools
+        are never reset or freed before cleanup().
+
+        reset() doesn't give sets back to their pool. Every set handed out since the last reset goes on a
+        free list for its layout, and allocate() takes from that list before it asks a pool for more. A
+        frame that binds the same kinds of sets as the last one therefore makes no vkAllocateDescriptorSets
+        calls. Recycled sets keep whatever was written to them, so callers rewrite them before use. Per frame
+        allocators are reset once their frame's command buffer has retired. Allocators for long lived sets
+        are simply never reset.
+
+        An allocator isn't thread safe, give each recording thread its own.
+*/
+
+DescriptorAllocator::DescriptorAllocator(VkDevice *device, uint32_t setsperpool)
+    : logicalDevice(device),
+      setsPerPool(setsperpool),
+      poolAllocationCount(0)
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to DescriptorAllocator!");
+    if (!setsperpool)
+        throw std::runtime_error("Descriptor pools need room for at least one set!");
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout){
+    //Reuse a set recycled by reset() before touching a pool...
+    auto & recycled = freeSets[layout];
+    if (!recycled.empty()){
+        auto set = recycled.back();
+        recycled.pop_back();
+        usedSets.push_back({layout, set});
+        return set;
+    }
+
+    //A full or fragmented pool is left as it is and a bigger one takes over...
+    if (pools.empty())
+        createPool();
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pools.back();
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+    VkDescriptorSet set;
+    auto result = vkAllocateDescriptorSets(*logicalDevice, &allocInfo, &set);
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL){
+        createPool();
+        allocInfo.descriptorPool = pools.back();
+        result = vkAllocateDescriptorSets(*logicalDevice, &allocInfo, &set);
+    }
+    if (result != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate descriptor set!");
+    poolAllocationCount++;
+    usedSets.push_back({layout, set});
+    return set;
+}
+
+void DescriptorAllocator::reset() noexcept{
+    for (const auto & used : usedSets)
+        freeSets[used.first].push_back(used.second);
+    usedSets.clear();
+}
+
+size_t DescriptorAllocator::getPoolCount() const noexcept{
+    return pools.size();
+}
+
+uint64_t DescriptorAllocator::getPoolAllocationCount() const noexcept{
+    return poolAllocationCount;
+}
+
+void DescriptorAllocator::createPool(){
+    //Each pool doubles the last one's size...
+    auto setcount = setsPerPool;
+    for (auto i = 0U; i < pools.size() && setcount < DESCRIPTOR_POOL_MAX_SET_COUNT; i++)
+        setcount = (std::min)(setcount * 2, static_cast<uint32_t>(DESCRIPTOR_POOL_MAX_SET_COUNT));
+
+    //Room for a few of every common descriptor type per set, storage buffers are what compute uses most...
+    std::vector <VkDescriptorPoolSize> poolSizes = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, setcount * 2},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, setcount},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, setcount * 2},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, setcount * 4},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setcount * 4},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, setcount * 2},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setcount},
+        {VK_DESCRIPTOR_TYPE_SAMPLER, setcount}
+    };
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = setcount;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(*logicalDevice, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create descriptor pool!");
+    pools.push_back(pool);
+}
+
+void DescriptorAllocator::cleanup() noexcept{
+    //Destroying a pool frees every set allocated from it...
+    for (auto pool : pools)
+        vkDestroyDescriptorPool(*logicalDevice, pool, nullptr);
+    pools.clear();
+    freeSets.clear();
+    usedSets.clear();
+}
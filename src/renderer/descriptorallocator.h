@@ -0,0 +1,35 @@
+#ifndef DESCRIPTORALLOCATOR_H
+#define DESCRIPTORALLOCATOR_H
+
+#include "src/utility.h"
+#include <unordered_map>
+
+#define DESCRIPTOR_POOL_SET_COUNT 256
+#define DESCRIPTOR_POOL_MAX_SET_COUNT 4096
+
+class DescriptorAllocator final
+{
+public:
+    DescriptorAllocator(VkDevice *device, uint32_t setsperpool = DESCRIPTOR_POOL_SET_COUNT);
+public:
+    ~DescriptorAllocator() = default;
+    DescriptorAllocator(const DescriptorAllocator & other) = default;
+    DescriptorAllocator & operator=(const DescriptorAllocator & other) = default;
+public:
+    [[nodiscard]] VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+    void reset() noexcept;
+    [[nodiscard]] size_t getPoolCount() const noexcept;
+    [[nodiscard]] uint64_t getPoolAllocationCount() const noexcept;
+    void cleanup() noexcept;
+private:
+    void createPool();
+private:
+    VkDevice *logicalDevice;
+    uint32_t setsPerPool;
+    std::vector <VkDescriptorPool> pools;
+    std::unordered_map <VkDescriptorSetLayout, std::vector<VkDescriptorSet>> freeSets;
+    std::vector <std::pair<VkDescriptorSetLayout, VkDescriptorSet>> usedSets;
+    uint64_t poolAllocationCount;
+};
+
+#endif // DESCRIPTORALLOCATOR_H
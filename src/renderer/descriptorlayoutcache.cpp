@@ -0,0 +1,77 @@
+#include "descriptorlayoutcache.h"
+#include <algorithm>
+#include <functional>
+
+/*!
+        \class DescriptorLayoutCache
+        \brief The DescriptorLayoutCache class creates each distinct descriptor set layout once and hands out the same handle after that.
+
+        \reentrant
+
+        Layouts are keyed on their bindings, sorted by binding number, so two pipelines asking for the same
+        bindings in a different order share a layout. Sets allocated for one layout are then compatible with
+        every pipeline built from it. The cache owns the layouts and destroys them in cleanup(), after every
+        pipeline layout that uses them is gone. Immutable samplers aren't part of the key, so they aren't supported.
+*/
+
+bool DescriptorLayoutCache::LayoutKey::operator==(const LayoutKey & other) const noexcept{
+    return std::equal(bindings.begin(), bindings.end(), other.bindings.begin(), other.bindings.end(), [](const VkDescriptorSetLayoutBinding & a, const VkDescriptorSetLayoutBinding & b){
+        return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags;
+    });
+}
+
+size_t DescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey & key) const noexcept{
+    //Each binding packs into one 64 bit word, which is mixed into the running hash...
+    size_t hash = key.bindings.size();
+    for (const auto & binding : key.bindings){
+        auto packed = static_cast<uint64_t>(binding.binding) | static_cast<uint64_t>(binding.descriptorType) << 16 |
+                static_cast<uint64_t>(binding.descriptorCount) << 24 | static_cast<uint64_t>(binding.stageFlags) << 40;
+        hash ^= std::hash<uint64_t>()(packed) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+DescriptorLayoutCache::DescriptorLayoutCache(VkDevice *device)
+    : logicalDevice(device)
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to DescriptorLayoutCache!");
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::getLayout(std::vector<VkDescriptorSetLayoutBinding> bindings){
+    for (const auto & binding : bindings){
+        if (binding.pImmutableSamplers)
+            throw std::runtime_error("Immutable samplers aren't supported by the descriptor layout cache!");
+    }
+    std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding & a, const VkDescriptorSetLayoutBinding & b){
+        return a.binding < b.binding;
+    });
+
+    //Pipelines may be built on several threads at once...
+    std::lock_guard<std::mutex> lock(mutex);
+    LayoutKey key = {bindings};
+    auto layout = layouts.find(key);
+    if (layout != layouts.end())
+        return layout->second;
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    VkDescriptorSetLayout newlayout;
+    if (vkCreateDescriptorSetLayout(*logicalDevice, &layoutInfo, nullptr, &newlayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create descriptor set layout!");
+    layouts.emplace(std::move(key), newlayout);
+    return newlayout;
+}
+
+size_t DescriptorLayoutCache::getLayoutCount() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return layouts.size();
+}
+
+void DescriptorLayoutCache::cleanup() noexcept{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto & layout : layouts)
+        vkDestroyDescriptorSetLayout(*logicalDevice, layout.second, nullptr);
+    layouts.clear();
+}
@@ -0,0 +1,39 @@
+#ifndef DESCRIPTORLAYOUTCACHE_H
+#define DESCRIPTORLAYOUTCACHE_H
+
+#include "src/utility.h"
+#include <unordered_map>
+#include <mutex>
+
+class DescriptorLayoutCache final
+{
+private:
+    struct LayoutKey final
+    {
+        std::vector <VkDescriptorSetLayoutBinding> bindings;
+
+        [[nodiscard]] bool operator==(const LayoutKey & other) const noexcept;
+    };
+    struct LayoutKeyHash final
+    {
+        [[nodiscard]] size_t operator()(const LayoutKey & key) const noexcept;
+    };
+public:
+    DescriptorLayoutCache(VkDevice *device);
+public:
+    ~DescriptorLayoutCache() = default;
+    DescriptorLayoutCache(const DescriptorLayoutCache & other) = delete;
+    DescriptorLayoutCache & operator=(const DescriptorLayoutCache & other) = delete;
+    DescriptorLayoutCache(const DescriptorLayoutCache && other) = delete;
+    DescriptorLayoutCache & operator=(const DescriptorLayoutCache && other) = delete;
+public:
+    [[nodiscard]] VkDescriptorSetLayout getLayout(std::vector<VkDescriptorSetLayoutBinding> bindings);
+    [[nodiscard]] size_t getLayoutCount() const;
+    void cleanup() noexcept;
+private:
+    VkDevice *logicalDevice;
+    mutable std::mutex mutex;
+    std::unordered_map <LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> layouts;
+};
+
+#endif // DESCRIPTORLAYOUTCACHE_H
@@ -0,0 +1,371 @@
+#include "devicememoryallocator.h"
+
+/*!
+        \class DeviceMemoryAllocator
+        \brief The DeviceMemoryAllocator class sub-allocates resources from a few large blocks of device memory.
+
+        \reentrant
+
+        Each memory type gets blocks of DEVICE_MEMORY_BLOCK_SIZE bytes. On small heaps the blocks are shrunk so
+        that at least DEVICE_MEMORY_MIN_BLOCKS_PER_HEAP fit. A buddy allocator hands out power of two pieces
+        of each block, no smaller than DEVICE_MEMORY_MIN_ALLOCATION_SIZE. Buddies are aligned to their own
+        size, so any alignment up to the piece size comes for free. Linear and optimal resources never share
+        a block, so bufferImageGranularity never has to be padded for. Requests above
+        DEVICE_MEMORY_DEDICATED_ALLOCATION_THRESHOLD get their own vkAllocateMemory.
+
+        Linear pools are bump allocators for transient data. They are reset as a whole rather than freed
+        piece by piece, and they pad to bufferImageGranularity whenever the resource type changes.
+
+        Host visible memory is mapped once when it is allocated and stays mapped, so allocations carry a
+        CPU pointer. Usage is tracked per memory heap, and a request that would go past
+        maxMemoryAllocationCount throws rather than failing inside the driver.
+*/
+
+namespace {
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) noexcept{
+    return alignment ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+}
+
+DeviceMemoryAllocator::DeviceMemoryAllocator(VkDevice *device, const VkPhysicalDeviceMemoryProperties & memoryproperties, const VkPhysicalDeviceLimits & limits)
+    : logicalDevice(device),
+      memoryProperties(memoryproperties),
+      bufferImageGranularity(limits.bufferImageGranularity),
+      nonCoherentAtomSize(limits.nonCoherentAtomSize),
+      maxMemoryAllocationCount(limits.maxMemoryAllocationCount),
+      deviceAllocationCount(0)
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to DeviceMemoryAllocator!");
+    heapStatistics.resize(memoryProperties.memoryHeapCount);
+    for (auto i = 0U; i < memoryProperties.memoryHeapCount; i++){
+        heapStatistics[i] = {};
+        heapStatistics[i].heapSize = memoryProperties.memoryHeaps[i].size;
+    }
+}
+
+DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::allocate(
+        const VkMemoryRequirements & requirements,
+        VkMemoryPropertyFlags requiredflags,
+        ResourceType resourcetype,
+        VkMemoryPropertyFlags preferredflags
+        )
+{
+    std::lock_guard <std::mutex> guard(mutex);
+    Allocation allocation = {};
+    allocation.memoryType = findMemoryType(requirements.memoryTypeBits, requiredflags, preferredflags);
+    auto & heap = getHeap(allocation.memoryType);
+
+    //Big resources would just fragment the blocks, give them memory of their own...
+    auto blocksize = getBlockSize(allocation.memoryType);
+    if (requirements.size > DEVICE_MEMORY_DEDICATED_ALLOCATION_THRESHOLD || requirements.size > blocksize / 2){
+        allocation.memory = allocateDeviceMemory(requirements.size, allocation.memoryType, &allocation.mapped);
+        allocation.size = requirements.size;
+        allocation.source = DEDICATED_ALLOCATION;
+        heap.dedicatedAllocationCount++;
+        heap.usedBytes += allocation.size;
+        return allocation;
+    }
+
+    //Round up to a power of two that is also large enough to meet the alignment...
+    auto size = (std::max<VkDeviceSize>)(DEVICE_MEMORY_MIN_ALLOCATION_SIZE, (std::max)(requirements.size, requirements.alignment));
+    allocation.order = 0;
+    while ((DEVICE_MEMORY_MIN_ALLOCATION_SIZE << allocation.order) < size)
+        allocation.order++;
+    allocation.size = DEVICE_MEMORY_MIN_ALLOCATION_SIZE << allocation.order;
+    allocation.source = BUDDY_ALLOCATION;
+
+    //First fit over the existing blocks of this type, then grow...
+    for (auto i = 0U; i < blocks.size(); i++){
+        auto & block = blocks[i];
+        if (block.memoryType != allocation.memoryType || block.resourceType != resourcetype || block.maxOrder < allocation.order)
+            continue;
+        if (allocateFromBlock(block, allocation.order, allocation.offset)){
+            allocation.memory = block.memory;
+            allocation.owner = i;
+            allocation.mapped = block.mapped ? static_cast<char *>(block.mapped) + allocation.offset : nullptr;
+            heap.usedBytes += allocation.size;
+            heap.subAllocationCount++;
+            return allocation;
+        }
+    }
+    Block block = {};
+    block.memory = allocateDeviceMemory(blocksize, allocation.memoryType, &block.mapped);
+    block.memoryType = allocation.memoryType;
+    block.resourceType = resourcetype;
+    while ((DEVICE_MEMORY_MIN_ALLOCATION_SIZE << block.maxOrder) < blocksize)
+        block.maxOrder++;
+    block.freeLists.resize(block.maxOrder + 1);
+    block.freeLists[block.maxOrder].insert(0);
+    heap.blockCount++;
+    blocks.push_back(block);
+    if (!allocateFromBlock(blocks.back(), allocation.order, allocation.offset))
+        throw std::runtime_error("Failed to sub-allocate from a new memory block!");
+    allocation.memory = blocks.back().memory;
+    allocation.owner = static_cast<uint32_t>(blocks.size() - 1);
+    allocation.mapped = blocks.back().mapped ? static_cast<char *>(blocks.back().mapped) + allocation.offset : nullptr;
+    heap.usedBytes += allocation.size;
+    heap.subAllocationCount++;
+    return allocation;
+}
+
+DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::allocateImage(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags requiredflags, VkMemoryPropertyFlags preferredflags){
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(*logicalDevice, image, &requirements);
+    auto allocation = allocate(requirements, requiredflags, tiling == VK_IMAGE_TILING_OPTIMAL ? OPTIMAL_RESOURCE : LINEAR_RESOURCE, preferredflags);
+    if (vkBindImageMemory(*logicalDevice, image, allocation.memory, allocation.offset) != VK_SUCCESS){
+        free(allocation);
+        throw std::runtime_error("Failed to bind image memory!");
+    }
+    return allocation;
+}
+
+DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags requiredflags, VkMemoryPropertyFlags preferredflags){
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(*logicalDevice, buffer, &requirements);
+    auto allocation = allocate(requirements, requiredflags, LINEAR_RESOURCE, preferredflags);
+    if (vkBindBufferMemory(*logicalDevice, buffer, allocation.memory, allocation.offset) != VK_SUCCESS){
+        free(allocation);
+        throw std::runtime_error("Failed to bind buffer memory!");
+    }
+    return allocation;
+}
+
+void DeviceMemoryAllocator::free(const Allocation & allocation) noexcept{
+    if (allocation.memory == VK_NULL_HANDLE)
+        return;
+    std::lock_guard <std::mutex> guard(mutex);
+    auto & heap = getHeap(allocation.memoryType);
+    switch (allocation.source){
+    case DEDICATED_ALLOCATION:
+        freeDeviceMemory(allocation.memory, allocation.size, allocation.memoryType);
+        heap.dedicatedAllocationCount--;
+        heap.usedBytes -= allocation.size;
+        break;
+    case BUDDY_ALLOCATION:{
+        //Merge with the buddy for as long as it is free too...
+        auto & block = blocks[allocation.owner];
+        auto offset = allocation.offset;
+        auto order = allocation.order;
+        while (order < block.maxOrder){
+            auto buddy = offset ^ (DEVICE_MEMORY_MIN_ALLOCATION_SIZE << order);
+            auto found = block.freeLists[order].find(buddy);
+            if (found == block.freeLists[order].end())
+                break;
+            block.freeLists[order].erase(found);
+            offset = (std::min<VkDeviceSize>)(offset, buddy);
+            order++;
+        }
+        block.freeLists[order].insert(offset);
+        block.allocationCount--;
+        heap.usedBytes -= allocation.size;
+        heap.subAllocationCount--;
+        break;
+    }
+    case LINEAR_POOL_ALLOCATION:
+        //Linear pools are only ever reset as a whole...
+        break;
+    }
+}
+
+void DeviceMemoryAllocator::flush(const Allocation & allocation) const{
+    //Coherent memory needs no flush, otherwise the range has to cover whole atoms...
+    if (memoryProperties.memoryTypes[allocation.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+        return;
+    VkMappedMemoryRange range = {};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = allocation.memory;
+    range.offset = allocation.offset / nonCoherentAtomSize * nonCoherentAtomSize;
+    range.size = alignUp(allocation.offset + allocation.size - range.offset, nonCoherentAtomSize);
+
+    //Rounding up mustn't run past the end of the memory object, a range that reaches it flushes the rest...
+    VkDeviceSize memorysize = allocation.size;
+    if (allocation.source == BUDDY_ALLOCATION){
+        memorysize = getBlockSize(allocation.memoryType);
+    }else if (allocation.source == LINEAR_POOL_ALLOCATION){
+        std::lock_guard <std::mutex> guard(mutex);
+        memorysize = linearPools[allocation.owner].size;
+    }
+    if (range.offset + range.size >= memorysize)
+        range.size = VK_WHOLE_SIZE;
+    if (vkFlushMappedMemoryRanges(*logicalDevice, 1, &range) != VK_SUCCESS)
+        throw std::runtime_error("Failed to flush mapped memory!");
+}
+
+uint32_t DeviceMemoryAllocator::createLinearPool(VkDeviceSize size, uint32_t memorytypebits, VkMemoryPropertyFlags requiredflags, VkMemoryPropertyFlags preferredflags){
+    std::lock_guard <std::mutex> guard(mutex);
+    LinearPool pool = {};
+    pool.memoryType = findMemoryType(memorytypebits, requiredflags, preferredflags);
+    pool.memory = allocateDeviceMemory(size, pool.memoryType, &pool.mapped);
+    pool.size = size;
+    pool.alive = true;
+    getHeap(pool.memoryType).linearPoolCount++;
+
+    //Reuse the slot of a destroyed pool before growing...
+    for (auto i = 0U; i < linearPools.size(); i++){
+        if (!linearPools[i].alive){
+            linearPools[i] = pool;
+            return i;
+        }
+    }
+    linearPools.push_back(pool);
+    return static_cast<uint32_t>(linearPools.size() - 1);
+}
+
+DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::allocateFromLinearPool(uint32_t pool, const VkMemoryRequirements & requirements, ResourceType resourcetype){
+    std::lock_guard <std::mutex> guard(mutex);
+    if (pool >= linearPools.size() || !linearPools[pool].alive)
+        throw std::runtime_error("Invalid linear pool!");
+    auto & linearpool = linearPools[pool];
+    if (!(requirements.memoryTypeBits & (1U << linearpool.memoryType)))
+        throw std::runtime_error("Resource can't live in this linear pool's memory type!");
+
+    //A linear resource next to an optimal one must be a whole granularity page away...
+    auto alignment = requirements.alignment;
+    if (linearpool.allocationCount && linearpool.lastResourceType != resourcetype)
+        alignment = (std::max)(alignment, bufferImageGranularity);
+    auto offset = alignUp(linearpool.head, alignment);
+    if (offset + requirements.size > linearpool.size)
+        throw std::runtime_error("Linear pool is full!");
+
+    Allocation allocation = {};
+    allocation.memory = linearpool.memory;
+    allocation.offset = offset;
+    allocation.size = requirements.size;
+    allocation.mapped = linearpool.mapped ? static_cast<char *>(linearpool.mapped) + offset : nullptr;
+    allocation.memoryType = linearpool.memoryType;
+    allocation.source = LINEAR_POOL_ALLOCATION;
+    allocation.owner = pool;
+    getHeap(linearpool.memoryType).usedBytes += offset + requirements.size - linearpool.head;
+    linearpool.head = offset + requirements.size;
+    linearpool.lastResourceType = resourcetype;
+    linearpool.allocationCount++;
+    return allocation;
+}
+
+void DeviceMemoryAllocator::resetLinearPool(uint32_t pool) noexcept{
+    std::lock_guard <std::mutex> guard(mutex);
+    if (pool >= linearPools.size() || !linearPools[pool].alive)
+        return;
+    getHeap(linearPools[pool].memoryType).usedBytes -= linearPools[pool].head;
+    linearPools[pool].head = 0;
+    linearPools[pool].allocationCount = 0;
+}
+
+void DeviceMemoryAllocator::destroyLinearPool(uint32_t pool) noexcept{
+    std::lock_guard <std::mutex> guard(mutex);
+    if (pool >= linearPools.size() || !linearPools[pool].alive)
+        return;
+    auto & linearpool = linearPools[pool];
+    auto & heap = getHeap(linearpool.memoryType);
+    heap.usedBytes -= linearpool.head;
+    heap.linearPoolCount--;
+    freeDeviceMemory(linearpool.memory, linearpool.size, linearpool.memoryType);
+    linearpool.alive = false;
+}
+
+uint32_t DeviceMemoryAllocator::findMemoryType(uint32_t typefilter, VkMemoryPropertyFlags requiredflags, VkMemoryPropertyFlags preferredflags) const{
+    //Take a type with the preferred properties as well if there is one...
+    for (auto i = 0U; i < memoryProperties.memoryTypeCount; i++){
+        auto wanted = requiredflags | preferredflags;
+        if ((typefilter & (1U << i)) && (memoryProperties.memoryTypes[i].propertyFlags & wanted) == wanted)
+            return i;
+    }
+    for (auto i = 0U; i < memoryProperties.memoryTypeCount; i++){
+        if ((typefilter & (1U << i)) && (memoryProperties.memoryTypes[i].propertyFlags & requiredflags) == requiredflags)
+            return i;
+    }
+    throw std::runtime_error("Failed to find a suitable memory type!");
+}
+
+VkMemoryPropertyFlags DeviceMemoryAllocator::getMemoryTypeFlags(uint32_t memorytype) const{
+    if (memorytype >= memoryProperties.memoryTypeCount)
+        throw std::runtime_error("Invalid memory type!");
+    return memoryProperties.memoryTypes[memorytype].propertyFlags;
+}
+
+std::vector<DeviceMemoryAllocator::HeapStatistics> DeviceMemoryAllocator::getHeapStatistics() const{
+    std::lock_guard <std::mutex> guard(mutex);
+    return heapStatistics;
+}
+
+void DeviceMemoryAllocator::cleanup() noexcept{
+    std::lock_guard <std::mutex> guard(mutex);
+    auto blocksize = [&](const Block & block){ return DEVICE_MEMORY_MIN_ALLOCATION_SIZE << block.maxOrder; };
+    for (const auto & block : blocks)
+        freeDeviceMemory(block.memory, blocksize(block), block.memoryType);
+    for (const auto & pool : linearPools){
+        if (pool.alive)
+            freeDeviceMemory(pool.memory, pool.size, pool.memoryType);
+    }
+    blocks.clear();
+    linearPools.clear();
+    for (auto & heap : heapStatistics){
+        auto heapsize = heap.heapSize;
+        heap = {};
+        heap.heapSize = heapsize;
+    }
+}
+
+VkDeviceMemory DeviceMemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memorytype, void **mapped){
+    if (deviceAllocationCount >= maxMemoryAllocationCount)
+        throw std::runtime_error("Out of device memory allocations (maxMemoryAllocationCount)!");
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memorytype;
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(*logicalDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate device memory!");
+
+    //Host visible memory stays mapped for as long as it lives...
+    *mapped = nullptr;
+    if (memoryProperties.memoryTypes[memorytype].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT){
+        if (vkMapMemory(*logicalDevice, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS){
+            vkFreeMemory(*logicalDevice, memory, nullptr);
+            throw std::runtime_error("Failed to map device memory!");
+        }
+    }
+    deviceAllocationCount++;
+    getHeap(memorytype).reservedBytes += size;
+    return memory;
+}
+
+void DeviceMemoryAllocator::freeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memorytype) noexcept{
+    //Freeing memory implicitly unmaps it...
+    vkFreeMemory(*logicalDevice, memory, nullptr);
+    deviceAllocationCount--;
+    getHeap(memorytype).reservedBytes -= size;
+}
+
+VkDeviceSize DeviceMemoryAllocator::getBlockSize(uint32_t memorytype) const noexcept{
+    //Keep blocks a power of two, and small enough that a small heap still holds several...
+    auto heapsize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memorytype].heapIndex].size;
+    auto blocksize = DEVICE_MEMORY_BLOCK_SIZE;
+    while (blocksize > DEVICE_MEMORY_MIN_ALLOCATION_SIZE && blocksize * DEVICE_MEMORY_MIN_BLOCKS_PER_HEAP > heapsize)
+        blocksize /= 2;
+    return blocksize;
+}
+
+bool DeviceMemoryAllocator::allocateFromBlock(Block & block, uint32_t order, VkDeviceSize & offset){
+    //Find the smallest free piece that fits, then split it down to size...
+    auto found = order;
+    while (found <= block.maxOrder && block.freeLists[found].empty())
+        found++;
+    if (found > block.maxOrder)
+        return false;
+    offset = *block.freeLists[found].begin();
+    block.freeLists[found].erase(block.freeLists[found].begin());
+    while (found > order){
+        found--;
+        block.freeLists[found].insert(offset + (DEVICE_MEMORY_MIN_ALLOCATION_SIZE << found));
+    }
+    block.allocationCount++;
+    return true;
+}
+
+DeviceMemoryAllocator::HeapStatistics & DeviceMemoryAllocator::getHeap(uint32_t memorytype) noexcept{
+    return heapStatistics[memoryProperties.memoryTypes[memorytype].heapIndex];
+}
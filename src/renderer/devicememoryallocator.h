@@ -0,0 +1,119 @@
+#ifndef DEVICEMEMORYALLOCATOR_H
+#define DEVICEMEMORYALLOCATOR_H
+
+#include "src/utility.h"
+#include <set>
+#include <algorithm>
+
+#define DEVICE_MEMORY_BLOCK_SIZE (64ULL * 1024 * 1024)
+#define DEVICE_MEMORY_MIN_ALLOCATION_SIZE 256ULL
+#define DEVICE_MEMORY_DEDICATED_ALLOCATION_THRESHOLD (DEVICE_MEMORY_BLOCK_SIZE / 2)
+#define DEVICE_MEMORY_MIN_BLOCKS_PER_HEAP 8
+
+class DeviceMemoryAllocator final
+{
+public:
+    enum ResourceType {
+        LINEAR_RESOURCE = 0,
+        OPTIMAL_RESOURCE = 1
+    };
+    enum Source {
+        BUDDY_ALLOCATION = 0,
+        DEDICATED_ALLOCATION = 1,
+        LINEAR_POOL_ALLOCATION = 2
+    };
+    struct Allocation final
+    {
+        VkDeviceMemory memory;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        void *mapped;
+        uint32_t memoryType;
+        Source source;
+        uint32_t owner;
+        uint32_t order;
+    };
+    struct HeapStatistics final
+    {
+        VkDeviceSize heapSize;
+        VkDeviceSize reservedBytes;
+        VkDeviceSize usedBytes;
+        uint32_t blockCount;
+        uint32_t dedicatedAllocationCount;
+        uint32_t linearPoolCount;
+        uint32_t subAllocationCount;
+    };
+private:
+    struct Block final
+    {
+        VkDeviceMemory memory;
+        void *mapped;
+        uint32_t memoryType;
+        ResourceType resourceType;
+        uint32_t maxOrder;
+        uint32_t allocationCount;
+        std::vector <std::set<VkDeviceSize>> freeLists;
+    };
+    struct LinearPool final
+    {
+        VkDeviceMemory memory;
+        void *mapped;
+        uint32_t memoryType;
+        VkDeviceSize size;
+        VkDeviceSize head;
+        ResourceType lastResourceType;
+        uint32_t allocationCount;
+        bool alive;
+    };
+public:
+    DeviceMemoryAllocator(VkDevice *device, const VkPhysicalDeviceMemoryProperties & memoryproperties, const VkPhysicalDeviceLimits & limits);
+public:
+    ~DeviceMemoryAllocator() = default;
+    DeviceMemoryAllocator(const DeviceMemoryAllocator & other) = delete;
+    DeviceMemoryAllocator & operator=(const DeviceMemoryAllocator & other) = delete;
+    DeviceMemoryAllocator(const DeviceMemoryAllocator && other) = delete;
+    DeviceMemoryAllocator & operator=(const DeviceMemoryAllocator && other) = delete;
+public:
+    [[nodiscard]] Allocation allocate(
+            const VkMemoryRequirements & requirements,
+            VkMemoryPropertyFlags requiredflags,
+            ResourceType resourcetype,
+            VkMemoryPropertyFlags preferredflags = 0
+            );
+    [[nodiscard]] Allocation allocateImage(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags requiredflags, VkMemoryPropertyFlags preferredflags = 0);
+    [[nodiscard]] Allocation allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags requiredflags, VkMemoryPropertyFlags preferredflags = 0);
+    void free(const Allocation & allocation) noexcept;
+    void flush(const Allocation & allocation) const;
+    [[nodiscard]] uint32_t createLinearPool(
+            VkDeviceSize size,
+            uint32_t memorytypebits,
+            VkMemoryPropertyFlags requiredflags,
+            VkMemoryPropertyFlags preferredflags = 0
+            );
+    [[nodiscard]] Allocation allocateFromLinearPool(uint32_t pool, const VkMemoryRequirements & requirements, ResourceType resourcetype);
+    void resetLinearPool(uint32_t pool) noexcept;
+    void destroyLinearPool(uint32_t pool) noexcept;
+    [[nodiscard]] uint32_t findMemoryType(uint32_t typefilter, VkMemoryPropertyFlags requiredflags, VkMemoryPropertyFlags preferredflags = 0) const;
+    [[nodiscard]] VkMemoryPropertyFlags getMemoryTypeFlags(uint32_t memorytype) const;
+    [[nodiscard]] std::vector<HeapStatistics> getHeapStatistics() const;
+    void cleanup() noexcept;
+private:
+    [[nodiscard]] VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memorytype, void **mapped);
+    void freeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memorytype) noexcept;
+    [[nodiscard]] VkDeviceSize getBlockSize(uint32_t memorytype) const noexcept;
+    [[nodiscard]] bool allocateFromBlock(Block & block, uint32_t order, VkDeviceSize & offset);
+    [[nodiscard]] HeapStatistics & getHeap(uint32_t memorytype) noexcept;
+private:
+    VkDevice *logicalDevice;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    VkDeviceSize bufferImageGranularity;
+    VkDeviceSize nonCoherentAtomSize;
+    uint32_t maxMemoryAllocationCount;
+    uint32_t deviceAllocationCount;
+    std::vector <Block> blocks;
+    std::vector <LinearPool> linearPools;
+    std::vector <HeapStatistics> heapStatistics;
+    mutable std::mutex mutex;
+};
+
+#endif // DEVICEMEMORYALLOCATOR_H
@@ -0,0 +1,306 @@
+#include "devicescorer.h"
+#include <chrono>
+
+/*!
+        \class DeviceScorer
+        \brief The DeviceScorer class scores physical devices by how fast they actually are.
+
+        A score is the device type's weight times the sum of a measured fill bandwidth, a measured copy
+        bandwidth (both in MB/s) and the size of the largest device local heap in MiB. Bandwidth dominates,
+        the heap size only separates devices that measure close or couldn't be measured at all, and the
+        type weight keeps a discrete GPU ahead of an integrated one that shares its memory with the CPU.
+
+        The bandwidths come from a micro-benchmark that creates a throwaway logical device, fills a device
+        local buffer and copies half of it onto the other half a few times, and times both with timestamp
+        queries, or on the CPU when the queue has none. A warm up submission runs first so clocks are up
+        and the memory is resident. This costs a fraction of a second per device, so the results are kept
+        in a scores directory next to the pipeline caches, one file per pipelineCacheUUID, and reused while
+        the vendor, device and driver version still match. Later startups only read the file.
+*/
+
+uint64_t DeviceScorer::getScore(
+        VkPhysicalDevice physicaldevice,
+        const VkPhysicalDeviceProperties & deviceproperties,
+        const VkPhysicalDeviceMemoryProperties & memoryproperties,
+        const std::vector<VkQueueFamilyProperties> & queuefamilies
+        ) const{
+    auto measurement = getMeasurement(physicaldevice, deviceproperties, memoryproperties, queuefamilies);
+    auto devicelocalmemory = getDeviceLocalMemory(memoryproperties) / (1024 * 1024);
+    return getTypeWeight(deviceproperties.deviceType) * (measurement.fillBandwidth + measurement.copyBandwidth + devicelocalmemory);
+}
+
+DeviceScorer::Measurement DeviceScorer::getMeasurement(
+        VkPhysicalDevice physicaldevice,
+        const VkPhysicalDeviceProperties & deviceproperties,
+        const VkPhysicalDeviceMemoryProperties & memoryproperties,
+        const std::vector<VkQueueFamilyProperties> & queuefamilies
+        ) const{
+    Measurement measurement = {0, 0};
+    if (loadMeasurement(deviceproperties, measurement))
+        return measurement;
+    measurement = measure(physicaldevice, deviceproperties, memoryproperties, queuefamilies);
+
+    //Devices that couldn't be measured are tried again next time...
+    if (measurement.fillBandwidth || measurement.copyBandwidth){
+        try {
+            saveMeasurement(deviceproperties, measurement);
+        } catch (...) {
+            //Losing the file only costs the next startup another benchmark...
+        }
+    }
+    return measurement;
+}
+
+uint64_t DeviceScorer::getTypeWeight(VkPhysicalDeviceType devicetype) noexcept{
+    switch (devicetype){
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        return 4;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+uint64_t DeviceScorer::getDeviceLocalMemory(const VkPhysicalDeviceMemoryProperties & memoryproperties) noexcept{
+    uint64_t largest = 0;
+    for (auto i = 0U; i < memoryproperties.memoryHeapCount; i++){
+        if (memoryproperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            largest = (std::max)(largest, static_cast<uint64_t>(memoryproperties.memoryHeaps[i].size));
+    }
+    return largest;
+}
+
+DeviceScorer::Measurement DeviceScorer::measure(
+        VkPhysicalDevice physicaldevice,
+        const VkPhysicalDeviceProperties & deviceproperties,
+        const VkPhysicalDeviceMemoryProperties & memoryproperties,
+        const std::vector<VkQueueFamilyProperties> & queuefamilies
+        ) const{
+    Measurement measurement = {0, 0};
+
+    //Fills need a graphics or compute queue before Vulkan 1.1...
+    auto family = static_cast<uint32_t>(queuefamilies.size());
+    for (auto i = 0U; i < queuefamilies.size(); i++){
+        if (queuefamilies[i].queueCount && (queuefamilies[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))){
+            family = i;
+            break;
+        }
+    }
+    if (family == queuefamilies.size())
+        return measurement;
+    auto timestamps = queuefamilies[family].timestampValidBits != 0;
+
+    //A throwaway device with a single queue...
+    auto priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = family;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    VkDevice device = VK_NULL_HANDLE;
+    if (vkCreateDevice(physicaldevice, &deviceInfo, nullptr, &device) != VK_SUCCESS)
+        return measurement;
+    VkQueue queue = VK_NULL_HANDLE;
+    vkGetDeviceQueue(device, family, 0, &queue);
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    auto benchmark = [&]() -> bool{
+        //Half of the buffer is filled, then copied onto the other half...
+        const VkDeviceSize size = DEVICE_SCORE_BENCHMARK_SIZE;
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size * 2;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+            return false;
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, buffer, &requirements);
+        auto memorytype = memoryproperties.memoryTypeCount;
+        for (auto i = 0U; i < memoryproperties.memoryTypeCount; i++){
+            if (!(requirements.memoryTypeBits & (1U << i)))
+                continue;
+            if (memorytype == memoryproperties.memoryTypeCount || (memoryproperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)){
+                memorytype = i;
+                if (memoryproperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                    break;
+            }
+        }
+        if (memorytype == memoryproperties.memoryTypeCount)
+            return false;
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = memorytype;
+        if (vkAllocateMemory(device, &allocateInfo, nullptr, &memory) != VK_SUCCESS)
+            return false;
+        if (vkBindBufferMemory(device, buffer, memory, 0) != VK_SUCCESS)
+            return false;
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = family;
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+            return false;
+        VkCommandBufferAllocateInfo commandBufferInfo = {};
+        commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferInfo.commandPool = commandPool;
+        commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        if (vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer) != VK_SUCCESS)
+            return false;
+        if (timestamps){
+            VkQueryPoolCreateInfo queryInfo = {};
+            queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryInfo.queryCount = 3;
+            if (vkCreateQueryPool(device, &queryInfo, nullptr, &queryPool) != VK_SUCCESS)
+                return false;
+        }
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+            return false;
+
+        //Fills, a barrier so copies read finished fills, then copies, with a timestamp between each...
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+            return false;
+        if (timestamps){
+            vkCmdResetQueryPool(commandBuffer, queryPool, 0, 3);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+        }
+        for (auto i = 0U; i < DEVICE_SCORE_BENCHMARK_ITERATIONS; i++)
+            vkCmdFillBuffer(commandBuffer, buffer, 0, size, i);
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        if (timestamps)
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1);
+        VkBufferCopy region = {0, size, size};
+        for (auto i = 0U; i < DEVICE_SCORE_BENCHMARK_ITERATIONS; i++)
+            vkCmdCopyBuffer(commandBuffer, buffer, buffer, 1, &region);
+        if (timestamps)
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 2);
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            return false;
+
+        //The first run warms clocks and memory up, only the second is measured...
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        uint64_t elapsed = 0;
+        for (auto run = 0; run < 2; run++){
+            auto start = std::chrono::steady_clock::now();
+            if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS)
+                return false;
+            if (vkWaitForFences(device, 1, &fence, VK_TRUE, (std::numeric_limits<uint64_t>::max)()) != VK_SUCCESS)
+                return false;
+            elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            if (vkResetFences(device, 1, &fence) != VK_SUCCESS)
+                return false;
+        }
+
+        //Bytes per microsecond is MB/s...
+        const uint64_t bytes = size * DEVICE_SCORE_BENCHMARK_ITERATIONS;
+        if (timestamps){
+            uint64_t ticks[3] = {};
+            if (vkGetQueryPoolResults(device, queryPool, 0, 3, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+                return false;
+            auto mask = queuefamilies[family].timestampValidBits >= 64 ? ~0ULL : (1ULL << queuefamilies[family].timestampValidBits) - 1;
+            auto period = static_cast<double>(deviceproperties.limits.timestampPeriod);
+            auto fillnanoseconds = static_cast<double>((ticks[1] - ticks[0]) & mask) * period;
+            auto copynanoseconds = static_cast<double>((ticks[2] - ticks[1]) & mask) * period;
+            if (fillnanoseconds > 0.0)
+                measurement.fillBandwidth = static_cast<uint64_t>(static_cast<double>(bytes) * 1000.0 / fillnanoseconds);
+            if (copynanoseconds > 0.0)
+                measurement.copyBandwidth = static_cast<uint64_t>(static_cast<double>(bytes) * 1000.0 / copynanoseconds);
+        }else if (elapsed){
+            //Without timestamps both halves share the submission's CPU time...
+            measurement.fillBandwidth = bytes * 2 * 1000 / elapsed;
+            measurement.copyBandwidth = measurement.fillBandwidth;
+        }
+        return true;
+    };
+    if (!benchmark())
+        measurement = {0, 0};
+
+    if (fence != VK_NULL_HANDLE)
+        vkDestroyFence(device, fence, nullptr);
+    if (queryPool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(device, queryPool, nullptr);
+    if (commandPool != VK_NULL_HANDLE)
+        vkDestroyCommandPool(device, commandPool, nullptr);
+    if (buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(device, buffer, nullptr);
+    if (memory != VK_NULL_HANDLE)
+        vkFreeMemory(device, memory, nullptr);
+    vkDestroyDevice(device, nullptr);
+    return measurement;
+}
+
+fs::path DeviceScorer::getCachePath(const VkPhysicalDeviceProperties & deviceproperties) const{
+    //Score files get a directory of their own, wiping the pipeline caches mustn't make every device measure again...
+    static const char digits[] = "0123456789abcdef";
+    std::string name = "device_";
+    for (auto byte : deviceproperties.pipelineCacheUUID){
+        name += digits[byte >> 4];
+        name += digits[byte & 0x0F];
+    }
+    name += ".bin";
+    return fs::current_path().parent_path() / DEVICE_SCORE_DIRECTORY / name;
+}
+
+bool DeviceScorer::loadMeasurement(const VkPhysicalDeviceProperties & deviceproperties, Measurement & measurement) const{
+    std::ifstream file(getCachePath(deviceproperties).u8string(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    //A new driver can be faster or slower, so its device is measured again...
+    FileHeader header = {};
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        return false;
+    if (header.magic != DEVICE_SCORE_FILE_MAGIC ||
+            header.driverVersion != deviceproperties.driverVersion ||
+            header.vendorID != deviceproperties.vendorID ||
+            header.deviceID != deviceproperties.deviceID)
+        return false;
+    Measurement loaded = {};
+    if (!file.read(reinterpret_cast<char *>(&loaded), sizeof(loaded)))
+        return false;
+    measurement = loaded;
+    return true;
+}
+
+void DeviceScorer::saveMeasurement(const VkPhysicalDeviceProperties & deviceproperties, const Measurement & measurement) const{
+    auto path = getCachePath(deviceproperties);
+    fs::create_directories(path.parent_path());
+    auto temporarypath = path;
+    temporarypath += ".tmp";
+    {
+        std::ofstream file(temporarypath.u8string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open device score file!");
+        FileHeader header = {DEVICE_SCORE_FILE_MAGIC, deviceproperties.driverVersion, deviceproperties.vendorID, deviceproperties.deviceID};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(&measurement), sizeof(measurement));
+        if (!file)
+            throw std::runtime_error("Failed to write device score file!");
+    }
+    fs::rename(temporarypath, path);
+}
@@ -0,0 +1,56 @@
+#ifndef DEVICESCORER_H
+#define DEVICESCORER_H
+
+#include "src/utility.h"
+
+class DeviceScorer final
+{
+private:
+    struct FileHeader final
+    {
+        uint32_t magic;
+        uint32_t driverVersion;
+        uint32_t vendorID;
+        uint32_t deviceID;
+    };
+public:
+    struct Measurement final
+    {
+        uint64_t fillBandwidth;
+        uint64_t copyBandwidth;
+    };
+public:
+    DeviceScorer() = default;
+    ~DeviceScorer() = default;
+    DeviceScorer(const DeviceScorer & other) = delete;
+    DeviceScorer & operator=(const DeviceScorer & other) = delete;
+    DeviceScorer(const DeviceScorer && other) = delete;
+    DeviceScorer & operator=(const DeviceScorer && other) = delete;
+public:
+    [[nodiscard]] uint64_t getScore(
+            VkPhysicalDevice physicaldevice,
+            const VkPhysicalDeviceProperties & deviceproperties,
+            const VkPhysicalDeviceMemoryProperties & memoryproperties,
+            const std::vector<VkQueueFamilyProperties> & queuefamilies
+            ) const;
+    [[nodiscard]] Measurement getMeasurement(
+            VkPhysicalDevice physicaldevice,
+            const VkPhysicalDeviceProperties & deviceproperties,
+            const VkPhysicalDeviceMemoryProperties & memoryproperties,
+            const std::vector<VkQueueFamilyProperties> & queuefamilies
+            ) const;
+    [[nodiscard]] static uint64_t getTypeWeight(VkPhysicalDeviceType devicetype) noexcept;
+    [[nodiscard]] static uint64_t getDeviceLocalMemory(const VkPhysicalDeviceMemoryProperties & memoryproperties) noexcept;
+private:
+    [[nodiscard]] Measurement measure(
+            VkPhysicalDevice physicaldevice,
+            const VkPhysicalDeviceProperties & deviceproperties,
+            const VkPhysicalDeviceMemoryProperties & memoryproperties,
+            const std::vector<VkQueueFamilyProperties> & queuefamilies
+            ) const;
+    [[nodiscard]] fs::path getCachePath(const VkPhysicalDeviceProperties & deviceproperties) const;
+    [[nodiscard]] bool loadMeasurement(const VkPhysicalDeviceProperties & deviceproperties, Measurement & measurement) const;
+    void saveMeasurement(const VkPhysicalDeviceProperties & deviceproperties, const Measurement & measurement) const;
+};
+
+#endif // DEVICESCORER_H
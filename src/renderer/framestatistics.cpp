@@ -0,0 +1,91 @@
+#include "framestatistics.h"
+#include <algorithm>
+#include <stdexcept>
+
+/*!
+        \class FrameStatistics
+        \brief The FrameStatistics class keeps rolling timing statistics over the most recent samples.
+
+        \reentrant
+
+        FrameStatistics stores the last windowSize samples (in nanoseconds) in a ring buffer along with
+        their running total and a histogram, so adding a sample is O(1) and never allocates. Percentiles,
+        min and max are only worked out when a summary is requested. A sample counts as a stutter when it
+        takes more than FRAME_STATISTICS_STUTTER_FACTOR times the rolling mean; the stutter count covers
+        every sample since the last reset. Summaries are reported in milliseconds.
+*/
+
+FrameStatistics::FrameStatistics(size_t windowsize)
+{
+    reset(windowsize);
+}
+
+void FrameStatistics::reset(size_t windowsize){
+    if (!windowsize)
+        throw std::runtime_error("FrameStatistics: window size must not be zero!");
+    samples.assign(windowsize, 0);
+    histogram.assign(FRAME_STATISTICS_HISTOGRAM_BUCKET_COUNT, 0);
+    nextSample = 0;
+    sampleCount = 0;
+    windowTotal = 0;
+    stutterCount = 0;
+}
+
+void FrameStatistics::addSample(uint64_t nanoseconds) noexcept{
+    //Check for a stutter against the rolling mean before this sample joins it...
+    if (sampleCount && nanoseconds > FRAME_STATISTICS_STUTTER_FACTOR * (static_cast<double>(windowTotal) / sampleCount))
+        stutterCount++;
+
+    //Evict the oldest sample once the window is full...
+    if (sampleCount == samples.size()){
+        windowTotal -= samples[nextSample];
+        histogram[getBucket(samples[nextSample])]--;
+    }else{
+        sampleCount++;
+    }
+    samples[nextSample] = nanoseconds;
+    windowTotal += nanoseconds;
+    histogram[getBucket(nanoseconds)]++;
+    nextSample = (nextSample + 1) % samples.size();
+}
+
+FrameStatistics::Summary FrameStatistics::getSummary() const{
+    Summary summary = {};
+    summary.sampleCount = sampleCount;
+    summary.stutterCount = stutterCount;
+    if (!sampleCount)
+        return summary;
+
+    //Work on a copy so percentiles can be selected in place...
+    std::vector<uint64_t> sorted(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(sampleCount));
+    auto percentile = [&](double fraction){
+        auto index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+        std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(index), sorted.end());
+        return sorted[index] / 1e6;
+    };
+    auto minmax = std::minmax_element(sorted.begin(), sorted.end());
+    summary.minimum = *minmax.first / 1e6;
+    summary.maximum = *minmax.second / 1e6;
+    summary.mean = static_cast<double>(windowTotal) / sampleCount / 1e6;
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    return summary;
+}
+
+const std::vector<uint64_t> & FrameStatistics::getHistogram() const noexcept{
+    return histogram;
+}
+
+uint64_t FrameStatistics::getHistogramBucketWidth() const noexcept{
+    return FRAME_STATISTICS_HISTOGRAM_BUCKET_WIDTH_NS;
+}
+
+size_t FrameStatistics::getSampleCount() const noexcept{
+    return sampleCount;
+}
+
+size_t FrameStatistics::getBucket(uint64_t nanoseconds) const noexcept{
+    //The last bucket collects everything that's off the end of the histogram...
+    return static_cast<size_t>((std::min)(static_cast<uint64_t>(nanoseconds / FRAME_STATISTICS_HISTOGRAM_BUCKET_WIDTH_NS), static_cast<uint64_t>(FRAME_STATISTICS_HISTOGRAM_BUCKET_COUNT - 1)));
+}
@@ -0,0 +1,51 @@
+#ifndef FRAMESTATISTICS_H
+#define FRAMESTATISTICS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#define FRAME_STATISTICS_WINDOW_SIZE 1024
+#define FRAME_STATISTICS_HISTOGRAM_BUCKET_COUNT 64
+#define FRAME_STATISTICS_HISTOGRAM_BUCKET_WIDTH_NS 250000ULL
+#define FRAME_STATISTICS_STUTTER_FACTOR 2.0
+
+class FrameStatistics final
+{
+public:
+    struct Summary final
+    {
+        uint64_t sampleCount;
+        double minimum;
+        double mean;
+        double p50;
+        double p95;
+        double p99;
+        double maximum;
+        uint64_t stutterCount;
+    };
+public:
+    FrameStatistics(size_t windowsize = FRAME_STATISTICS_WINDOW_SIZE);
+public:
+    ~FrameStatistics() = default;
+    FrameStatistics(const FrameStatistics & other) = default;
+    FrameStatistics & operator=(const FrameStatistics & other) = default;
+public:
+    void addSample(uint64_t nanoseconds) noexcept;
+    void reset(size_t windowsize = FRAME_STATISTICS_WINDOW_SIZE);
+    [[nodiscard]] Summary getSummary() const;
+    [[nodiscard]] const std::vector<uint64_t> & getHistogram() const noexcept;
+    [[nodiscard]] uint64_t getHistogramBucketWidth() const noexcept;
+    [[nodiscard]] size_t getSampleCount() const noexcept;
+private:
+    [[nodiscard]] size_t getBucket(uint64_t nanoseconds) const noexcept;
+private:
+    std::vector <uint64_t> samples;
+    std::vector <uint64_t> histogram;
+    size_t nextSample;
+    size_t sampleCount;
+    uint64_t windowTotal;
+    uint64_t stutterCount;
+};
+
+#endif // FRAMESTATISTICS_H
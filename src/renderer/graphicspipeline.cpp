@@ -1,6 +1,8 @@
 #include "graphicspipeline.h"
 
 #include <experimental/filesystem>
+#include <algorithm>
+#include <chrono>
 
 namespace fs = std::experimental::filesystem;
 
@@ -45,246 +47,281 @@ GraphicsPipeline::Shader::Shader(VkDevice *device, const std::string & filepath,
         stageFlag = shadertype;
     }
 
-    //Load shader...
-    auto code = readFile(filepath);
-    if (code.empty())
+    //Map the shader, the mapping is page aligned so the driver can read the words from it directly...
+    MappedFile code(filepath);
+    if (!code.getSize())
         throw std::runtime_error("Empty shader found!");
 
+    //A shader caught half written by the compiler would otherwise reach the driver...
+    uint32_t magic = 0;
+    if (code.getSize() % sizeof(uint32_t) || code.getSize() < sizeof(magic))
+        throw std::runtime_error("Truncated SPIR-V shader found!");
+    std::memcpy(&magic, code.getData(), sizeof(magic));
+    if (magic != SPIRV_MAGIC_NUMBER)
+        throw std::runtime_error("Invalid SPIR-V shader found!");
+
     //Create shader...
     VkShaderModuleCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    createInfo.codeSize = code.getSize();
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.getData());
     if (vkCreateShaderModule(*device, &createInfo, nullptr, &shader) != VK_SUCCESS)
         throw std::runtime_error("Failed to create shader module!");
 }
 
-GraphicsPipeline::GraphicsPipeline(VkDevice *device)
-    : logicalDevice(device)
+GraphicsPipeline::GraphicsPipeline(VkDevice *device, VkPipelineCache pipelinecache, ThreadPool *threadpool, DescriptorLayoutCache *layoutcache)
+    : logicalDevice(device),
+      pipelineCache(pipelinecache),
+      renderPass(VK_NULL_HANDLE),
+      scenePass(0),
+      depthPass(0),
+      depthMode(NO_DEPTH),
+      depthFormat(VK_FORMAT_UNDEFINED),
+      sampleCount(VK_SAMPLE_COUNT_1_BIT),
+      pipelineStates(std::make_shared<PipelineStateCache>(device, pipelinecache)),
+      variants(1, PipelineState())
 {
     if (!device)
         throw std::runtime_error("Null device was passed to Shader!");
 
-    //Generate path to shaders directory...
-    auto currentpath = fs::current_path().u8string();
-    auto index = currentpath.find_last_of('\\') + 1;
-    std::string shaderpath = PATH_TO_SHADERS_DIRECTORY_WINDOWS;
-    if (index == (std::numeric_limits<size_t>::max)()){ //Not Windows...
-        index = currentpath.find_last_of('/') + 1;
-        shaderpath = PATH_TO_SHADERS_DIRECTORY_LINUX;
-        if (index == (std::numeric_limits<size_t>::max)())
-            throw std::runtime_error("GraphicsPipeline: Invalid directory path!");
+    //Set 0 holds per object data, a dynamic uniform buffer whose offset moves on every draw...
+    if (layoutcache){
+        VkDescriptorSetLayoutBinding framebinding = {};
+        framebinding.binding = 0;
+        framebinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        framebinding.descriptorCount = 1;
+        framebinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        setLayouts.push_back(layoutcache->getLayout({framebinding}));
     }
-    currentpath.resize(currentpath.size() + 1 + shaderpath.size() - sizeof("build"));
-    auto j = 0U;
-    while (index < currentpath.size())
-        currentpath[index++] = shaderpath[j++];
-    currentpath[index] = '\0';
 
-    //Search shaders directory for shaders to load...
+    //Create shaders...
+    auto start = std::chrono::steady_clock::now();
+    shaders = loadShaders(logicalDevice, findShaders(), threadpool);
+    LOG_INFO(
+                std::string("Loaded ") + std::to_string(shaders.size()) + std::string(" shaders in ") +
+                std::to_string(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()) + std::string(" ms")
+                );
+}
+
+std::vector<std::string> GraphicsPipeline::findShaders(){
+    //Search shaders directory for shaders to load, compute shaders get pipelines of their own...
     std::vector <std::string> shadernames;
-    for (auto & shader : fs::directory_iterator(currentpath)){
+    for (auto & shader : fs::directory_iterator(getShaderDirectory())){
         auto name = shader.path().filename().generic_u8string();
-        if (name.find(".spv") != std::string::npos)
+        if (name.find(".spv") != std::string::npos && name.find(COMPUTE_SHADER_SUBSTRING) == std::string::npos)
             shadernames.push_back(shader.path().generic_u8string());
     }
 
-    //Create shaders...
-    for (const auto & name : shadernames)
-        shaders.push_back(Shader(logicalDevice, name));
+    //Directory order isn't stable, keep the stages in the same order across reloads...
+    std::sort(shadernames.begin(), shadernames.end());
+    return shadernames;
 }
 
-void GraphicsPipeline::createRenderpass(VkFormat & format){
-    //Create renderpass...
-    VkAttachmentDescription colorAttachment = {};
-    colorAttachment.format = format;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef = {};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-
-    VkRenderPassCreateInfo renderPassInfo = {};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-
-    if (vkCreateRenderPass(*logicalDevice, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create render pass!");
+std::vector<GraphicsPipeline::Shader> GraphicsPipeline::loadShaders(VkDevice *device, const std::vector<std::string> & shadernames, ThreadPool *threadpool){
+    //Module creation is free threaded, so each worker maps and creates its own shaders...
+    std::vector <Shader> loaded(shadernames.size());
+    auto load = [&](uint32_t, size_t index){
+        loaded[index] = Shader(device, shadernames[index]);
+    };
+    try {
+        if (threadpool && shadernames.size() > 1){
+            threadpool->parallelFor(shadernames.size(), load);
+        }else{
+            for (auto i = 0U; i < shadernames.size(); i++)
+                load(0, i);
+        }
+    } catch (...) {
+        //Every task has finished by now, so whatever was created can be destroyed...
+        for (const auto & shader : loaded)
+            vkDestroyShaderModule(*device, shader.shader, nullptr);
+        throw;
+    }
+    return loaded;
 }
 
-void GraphicsPipeline::initializeFixedFunctions(VkExtent2D &swapchainextent){
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 0;
-    vertexInputInfo.pVertexBindingDescriptions = nullptr;
-    vertexInputInfo.vertexAttributeDescriptionCount = 0;
-    vertexInputInfo.pVertexAttributeDescriptions = nullptr;
-
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    VkViewport viewport = {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(swapchainextent.width);
-    viewport.height = static_cast<float>(swapchainextent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor = {};
-    scissor.offset = {0, 0};
-    scissor.extent = swapchainextent;
-
-    VkPipelineViewportStateCreateInfo viewportState = {};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    VkPipelineRasterizationStateCreateInfo rasterizer = {};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-    rasterizer.depthBiasConstantFactor = 0.0f;
-    rasterizer.depthBiasClamp = 0.0f;
-    rasterizer.depthBiasSlopeFactor = 0.0f;
-
-    VkPipelineMultisampleStateCreateInfo multisampling = {};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisampling.minSampleShading = 1.0f;
-    multisampling.pSampleMask = nullptr;
-    multisampling.alphaToCoverageEnable = VK_FALSE;
-    multisampling.alphaToOneEnable = VK_FALSE;
-
-    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_FALSE;
-    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.blendEnable = VK_TRUE;
-    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending = {};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.logicOp = VK_LOGIC_OP_COPY;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-    colorBlending.blendConstants[0] = 0.0f;
-    colorBlending.blendConstants[1] = 0.0f;
-    colorBlending.blendConstants[2] = 0.0f;
-    colorBlending.blendConstants[3] = 0.0f;
-
-    VkDynamicState dynamicStates[] = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_LINE_WIDTH
-    };
-    VkPipelineDynamicStateCreateInfo dynamicState = {};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = 2;
-    dynamicState.pDynamicStates = dynamicStates;
+GraphicsPipeline GraphicsPipeline::rebuild() const{
+    //Build on a copy so the live pipeline is untouched, only the render pass is shared with it...
+    GraphicsPipeline reloaded(*this);
+    reloaded.shaders.clear();
+    reloaded.pipelineLayout = VK_NULL_HANDLE;
+    reloaded.pipelineStates = std::make_shared<PipelineStateCache>(logicalDevice, pipelineCache);
+    reloaded.variantHandles.clear();
+    reloaded.depthVariantHandles.clear();
+    try {
+        //Loaded on this thread, the pool may be busy recording on the main thread...
+        reloaded.shaders = loadShaders(logicalDevice, findShaders());
+        reloaded.createPipelines();
+    } catch (...) {
+        reloaded.cleanupRetired();
+        throw;
+    }
+    return reloaded;
+}
+
+void GraphicsPipeline::swapShaders(GraphicsPipeline & other) noexcept{
+    //The render pass stays with this pipeline, the copy shares its render graph...
+    std::swap(shaders, other.shaders);
+    std::swap(pipelineLayout, other.pipelineLayout);
+    std::swap(pipelineStates, other.pipelineStates);
+    std::swap(variantHandles, other.variantHandles);
+    std::swap(depthVariantHandles, other.depthVariantHandles);
+}
+
+void GraphicsPipeline::createRenderpass(VkFormat & format, VkImageLayout finallayout){
+    //The frame is described as a graph, which works out the render pass, its layouts and dependencies.
+    //A pre-pass lays depth down on its own, so the scene only shades the nearest surface at each pixel...
+    renderGraph = std::make_shared<RenderGraph>(logicalDevice);
+    auto backbuffer = renderGraph->addExternalAttachment("backbuffer", format, finallayout);
+    auto depth = 0U;
+    if (depthMode != NO_DEPTH)
+        depth = renderGraph->addTransientAttachment("depth", depthFormat, RenderGraph::DEPTH_ATTACHMENT, sampleCount);
+    if (depthMode == DEPTH_PREPASS){
+        depthPass = renderGraph->addPass("depth prepass");
+        renderGraph->writeDepth(depthPass, depth);
+    }
+
+    //Multisampled colour is resolved into the backbuffer at the end of the scene subpass, so its samples are
+    //never stored and never need a blit...
+    scenePass = renderGraph->addPass("scene");
+    if (sampleCount != VK_SAMPLE_COUNT_1_BIT){
+        auto multisampled = renderGraph->addTransientAttachment("multisampled colour", format, RenderGraph::COLOR_ATTACHMENT, sampleCount);
+        renderGraph->writeColor(scenePass, multisampled, static_cast<int32_t>(backbuffer));
+    }else{
+        renderGraph->writeColor(scenePass, backbuffer);
+    }
+    if (depthMode == DEPTH_PREPASS)
+        renderGraph->readDepth(scenePass, depth);
+    else if (depthMode == DEPTH_TEST)
+        renderGraph->writeDepth(scenePass, depth);
+    renderGraph->setOutput(backbuffer);
+    renderGraph->compile();
+    renderPass = renderGraph->getRenderPass();
+}
 
+void GraphicsPipeline::setDepthMode(DepthMode depthmode, VkFormat depthformat){
+    if (depthmode >= DEPTH_MODE_COUNT)
+        throw std::runtime_error("Invalid depth mode!");
+    if (depthmode != NO_DEPTH && depthformat == VK_FORMAT_UNDEFINED)
+        throw std::runtime_error("Depth testing needs a depth format!");
+
+    //Takes effect when the render pass and pipelines are next created...
+    depthMode = depthmode;
+    depthFormat = depthmode != NO_DEPTH ? depthformat : VK_FORMAT_UNDEFINED;
+}
+
+GraphicsPipeline::DepthMode GraphicsPipeline::getDepthMode() const noexcept{
+    return depthMode;
+}
+
+VkFormat GraphicsPipeline::getDepthFormat() const noexcept{
+    return depthFormat;
+}
+
+void GraphicsPipeline::setSampleCount(VkSampleCountFlagBits samplecount) noexcept{
+    //Takes effect when the render pass and pipelines are next created...
+    sampleCount = samplecount;
+}
+
+VkSampleCountFlagBits GraphicsPipeline::getSampleCount() const noexcept{
+    return sampleCount;
+}
+
+const char * GraphicsPipeline::getDepthModeName(DepthMode depthmode) noexcept{
+    switch (depthmode){
+    case NO_DEPTH:
+        return "no_depth";
+    case DEPTH_TEST:
+        return "depth_test";
+    case DEPTH_PREPASS:
+        return "depth_prepass";
+    default:
+        return "unknown";
+    }
+}
+
+void GraphicsPipeline::createPipelines(){
+    //Every variant shares one layout, per object data in set 0 and the per draw colour as a push constant...
+    VkPushConstantRange pushConstantRange = {VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(DrawConstants)};
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0;
-    pipelineLayoutInfo.pSetLayouts = nullptr;
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-    pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.empty() ? nullptr : setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
     if (vkCreatePipelineLayout(*logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
         throw std::runtime_error("failed to create pipeline layout!");
 
-    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
-    for (auto & shader : shaders){
-        VkPipelineShaderStageCreateInfo shaderStageInfo = {};
-        shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        shaderStageInfo.pName = "main";
-        shaderStageInfo.stage = shader.stageFlag;
-        shaderStageInfo.module = shader.shader;
-        shaderStageInfo.pSpecializationInfo = nullptr;
-        shaderStages.push_back(shaderStageInfo);
+    //All the variants are compiled in one batch...
+    variantHandles.clear();
+    depthVariantHandles.clear();
+    for (const auto & variant : variants)
+        requestVariant(variant);
+    pipelineStates->createPending();
+}
+
+PipelineDescription GraphicsPipeline::describe(const PipelineState & state, bool depthonly) const{
+    if (shaders.empty() || shaders.size() > PIPELINE_MAX_SHADER_STAGES)
+        throw std::runtime_error("Unsupported number of graphics shader stages!");
+
+    //The loaded shaders and the Vertex layout are the same for every variant, only the fixed function state changes.
+    //Depth only pipelines have no colour to write, so they leave the fragment shader out...
+    PipelineDescription description = {};
+    description.shaderCount = 0;
+    for (const auto & shader : shaders){
+        if (depthonly && shader.stageFlag == VK_SHADER_STAGE_FRAGMENT_BIT)
+            continue;
+        description.shaders[description.shaderCount] = shader.shader;
+        description.stages[description.shaderCount++] = shader.stageFlag;
     }
+    auto attributes = Vertex::getAttributeDescriptions();
+    description.vertexStride = Vertex::getBindingDescription().stride;
+    description.vertexAttributeCount = static_cast<uint32_t>(attributes.size());
+    std::copy(attributes.begin(), attributes.end(), description.vertexAttributes.begin());
+    description.state = state;
+
+    //The depth mode owns every variant's depth state, everything is drawn as opaque. After a pre-pass the
+    //scene only passes the test where it matches the depth already there...
+    if (depthMode != NO_DEPTH){
+        description.state.depthTestEnable = VK_TRUE;
+        description.state.depthWriteEnable = depthMode == DEPTH_TEST || depthonly ? VK_TRUE : VK_FALSE;
+        description.state.depthCompareOp = depthMode == DEPTH_PREPASS && !depthonly ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS;
+    }
+    if (depthonly)
+        description.state.blendEnable = VK_FALSE;
+    auto pass = depthonly ? depthPass : scenePass;
+    description.colorAttachmentCount = depthonly ? 0 : 1;
+    description.samples = renderGraph->getSamples(pass);
+    description.layout = pipelineLayout;
+    description.renderPass = renderPass;
+    description.subpass = renderGraph->getSubpass(pass);
+    return description;
+}
 
-    createGraphicsPipeline(
-                shaderStages.data(),
-                &vertexInputInfo,
-                &inputAssembly,
-                nullptr,
-                &viewportState,
-                &rasterizer,
-                &multisampling,
-                nullptr,
-                &colorBlending,
-                &dynamicState
-                );
+void GraphicsPipeline::requestVariant(const PipelineState & state){
+    //With a pre-pass every variant has a depth only twin at the same index...
+    variantHandles.push_back(pipelineStates->request(describe(state)));
+    if (depthMode == DEPTH_PREPASS)
+        depthVariantHandles.push_back(pipelineStates->request(describe(state, true)));
 }
 
-void GraphicsPipeline::createGraphicsPipeline(
-        VkPipelineShaderStageCreateInfo * shaderStages,
-        VkPipelineVertexInputStateCreateInfo * vertexInputInfo,
-        VkPipelineInputAssemblyStateCreateInfo * inputAssembly,
-        VkPipelineTessellationStateCreateInfo * tessellation,
-        VkPipelineViewportStateCreateInfo * viewportState,
-        VkPipelineRasterizationStateCreateInfo * rasterizer,
-        VkPipelineMultisampleStateCreateInfo * multisampling,
-        VkPipelineDepthStencilStateCreateInfo * depthStencil,
-        VkPipelineColorBlendStateCreateInfo * colorBlending,
-        VkPipelineDynamicStateCreateInfo * dynamicState
-        )
-{
-    VkGraphicsPipelineCreateInfo pipelineInfo = {};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStages;
-    pipelineInfo.pVertexInputState = vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = inputAssembly;
-    pipelineInfo.pTessellationState = tessellation;
-    pipelineInfo.pViewportState = viewportState;
-    pipelineInfo.pRasterizationState = rasterizer;
-    pipelineInfo.pMultisampleState = multisampling;
-    pipelineInfo.pDepthStencilState = depthStencil;
-    pipelineInfo.pColorBlendState = colorBlending;
-    pipelineInfo.pDynamicState = dynamicState;
-    pipelineInfo.layout = pipelineLayout;
-    pipelineInfo.renderPass = renderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = nullptr;
-    pipelineInfo.basePipelineIndex = -1;
-    if (vkCreateGraphicsPipelines(*logicalDevice, nullptr, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create graphics pipeline!");
+std::vector<uint32_t> GraphicsPipeline::addVariants(const std::vector<PipelineState> & states){
+    //Identical states share a variant, new ones are compiled together...
+    std::vector <uint32_t> indices;
+    for (const auto & state : states){
+        auto variant = std::find(variants.begin(), variants.end(), state);
+        if (variant == variants.end()){
+            variants.push_back(state);
+            requestVariant(state);
+            variant = variants.end() - 1;
+        }
+        indices.push_back(static_cast<uint32_t>(variant - variants.begin()));
+    }
+    pipelineStates->createPending();
+    return indices;
+}
+
+uint32_t GraphicsPipeline::getVariantCount() const noexcept{
+    return static_cast<uint32_t>(variants.size());
 }
 
 void GraphicsPipeline::cleanup(bool destroyshaders) noexcept{
@@ -293,20 +330,53 @@ void GraphicsPipeline::cleanup(bool destroyshaders) noexcept{
             vkDestroyShaderModule(*logicalDevice, shader.shader, nullptr);
         shaders.clear();
     }
-    vkDestroyPipeline(*logicalDevice, graphicsPipeline, nullptr);
+    pipelineStates->cleanup();
+    vkDestroyPipelineLayout(*logicalDevice, pipelineLayout, nullptr);
+    if (renderGraph)
+        renderGraph->cleanup();
+    renderPass = VK_NULL_HANDLE;
+}
+
+void GraphicsPipeline::cleanupRetired() noexcept{
+    //A retired pipeline shares its render graph with the live one, so that is left alone...
+    for (const auto & shader : shaders)
+        vkDestroyShaderModule(*logicalDevice, shader.shader, nullptr);
+    shaders.clear();
+    pipelineStates->cleanup();
     vkDestroyPipelineLayout(*logicalDevice, pipelineLayout, nullptr);
-    vkDestroyRenderPass(*logicalDevice, renderPass, nullptr);
+    pipelineLayout = VK_NULL_HANDLE;
 }
 
 VkRenderPass GraphicsPipeline::getRenderPass() const{
     return renderPass;
 }
 
+RenderGraph & GraphicsPipeline::getRenderGraph() const{
+    if (!renderGraph)
+        throw std::runtime_error("The graphics pipeline has no render graph yet!");
+    return *renderGraph;
+}
+
+VkPipelineLayout GraphicsPipeline::getPipelineLayout() const noexcept{
+    return pipelineLayout;
+}
+
+VkDescriptorSetLayout GraphicsPipeline::getSetLayout(uint32_t set) const{
+    if (set >= setLayouts.size())
+        throw std::runtime_error("The graphics pipeline has no such descriptor set!");
+    return setLayouts[set];
+}
+
 void GraphicsPipeline::startRenderPass(
         VkFramebuffer & framebuffer,
         VkExtent2D & swapchainextent,
         VkCommandBuffer & commandbuffer,
-        bool primarybuffer
+        const std::vector<Mesh> & meshes,
+        const std::vector<VkCommandBuffer> *secondarybuffers,
+        const TimestampQueryPool *timestamps,
+        uint32_t frame,
+        const DrawUniforms *uniforms,
+        const IndirectDrawList *indirectdraws
         )
 {
     //Set up the renderpass create info using the framebuffer associated with the swapchain image we are sampling from...
@@ -317,19 +387,121 @@ void GraphicsPipeline::startRenderPass(
     renderPassInfo.renderArea.offset = {0, 0};
     renderPassInfo.renderArea.extent = swapchainextent;
 
-    //Set the default color attachment to black...
-    VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
-    renderPassInfo.clearValueCount = 1;
-    renderPassInfo.pClearValues = &clearColor;
-    primarybuffer ? vkCmdBeginRenderPass(commandbuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE) :
-                    vkCmdBeginRenderPass(commandbuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-
-    //Bind the command buffer to the graphics pipeline and execute the commands in it...
-    vkCmdBindPipeline(commandbuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-    vkCmdDraw(commandbuffer, 3, 1, 0, 0);   //TO DO: passed index buffer, use direct or indirect draw?
+    //Every attachment is cleared on its first use, the graph keeps a clear value for each one...
+    const auto & clearvalues = renderGraph->getClearValues();
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearvalues.size());
+    renderPassInfo.pClearValues = clearvalues.data();
+    if (timestamps)
+        timestamps->beginScope(commandbuffer, frame, TimestampQueryPool::RENDER_PASS_SCOPE);
+
+    //Draws recorded on worker threads are executed from the primary buffer, otherwise they are recorded inline.
+    //The depth pre-pass is always recorded inline, it only binds depth only pipelines and draws...
+    auto primarybuffer = !secondarybuffers || secondarybuffers->empty();
+    auto scenesubpass = renderGraph->getSubpass(scenePass);
+    for (auto subpass = 0U; subpass < renderGraph->getSubpassCount(); subpass++){
+        auto contents = subpass == scenesubpass && !primarybuffer ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+        subpass ? vkCmdNextSubpass(commandbuffer, contents) : vkCmdBeginRenderPass(commandbuffer, &renderPassInfo, contents);
+        if (depthMode == DEPTH_PREPASS && subpass == renderGraph->getSubpass(depthPass))
+            recordDraws(commandbuffer, swapchainextent, meshes.data(), meshes.size(), frame, uniforms, indirectdraws, true, true);
+        if (subpass != scenesubpass)
+            continue;
+        if (primarybuffer)
+            recordDraws(commandbuffer, swapchainextent, meshes.data(), meshes.size(), frame, uniforms, indirectdraws);
+        else
+            vkCmdExecuteCommands(commandbuffer, static_cast<uint32_t>(secondarybuffers->size()), secondarybuffers->data());
+    }
 
     //End the render pass and finish recording the command buffer...
     vkCmdEndRenderPass(commandbuffer);
+    if (timestamps){
+        timestamps->endScope(commandbuffer, frame, TimestampQueryPool::RENDER_PASS_SCOPE);
+        timestamps->endScope(commandbuffer, frame, TimestampQueryPool::SUBMIT_SCOPE);
+    }
     if (vkEndCommandBuffer(commandbuffer) != VK_SUCCESS)
         throw std::runtime_error("Failed to record command buffer!");
 }
+
+void GraphicsPipeline::recordSecondaryCommandBuffer(
+        VkCommandBuffer & commandbuffer,
+        VkFramebuffer & framebuffer,
+        VkExtent2D & swapchainextent,
+        const Mesh *meshes,
+        size_t meshcount,
+        uint32_t frame,
+        const DrawUniforms *uniforms,
+        const IndirectDrawList *indirectdraws,
+        bool recordindirect
+        )
+{
+    //Secondary buffers inherit the render pass they are executed in, so they must name it up front...
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = renderPass;
+    inheritanceInfo.subpass = renderGraph->getSubpass(scenePass);
+    inheritanceInfo.framebuffer = framebuffer;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    if (vkBeginCommandBuffer(commandbuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failed to record secondary command buffer!");
+    recordDraws(commandbuffer, swapchainextent, meshes, meshcount, frame, uniforms, indirectdraws, recordindirect);
+    if (vkEndCommandBuffer(commandbuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to record secondary command buffer!");
+}
+
+void GraphicsPipeline::recordDraws(
+        VkCommandBuffer & commandbuffer,
+        VkExtent2D & swapchainextent,
+        const Mesh *meshes,
+        size_t meshcount,
+        uint32_t frame,
+        const DrawUniforms *uniforms,
+        const IndirectDrawList *indirectdraws,
+        bool recordindirect,
+        bool depthonly
+        ) const
+{
+    //Meshes pick a variant, the pipeline is only rebound when it changes from one draw to the next...
+    const auto & handles = depthonly ? depthVariantHandles : variantHandles;
+    VkPipeline bound = VK_NULL_HANDLE;
+    auto bindvariant = [&](uint32_t variant){
+        auto pipeline = pipelineStates->getPipeline(handles[variant < handles.size() ? variant : 0]);
+        if (pipeline != bound)
+            vkCmdBindPipeline(commandbuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        bound = pipeline;
+    };
+    bindvariant(0);
+
+    //The viewport, scissor and line width are dynamic state, so they have to be set before drawing...
+    VkViewport viewport = {0.0f, 0.0f, static_cast<float>(swapchainextent.width), static_cast<float>(swapchainextent.height), 0.0f, 1.0f};
+    VkRect2D scissor = {{0, 0}, swapchainextent};
+    vkCmdSetViewport(commandbuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandbuffer, 0, 1, &scissor);
+    vkCmdSetLineWidth(commandbuffer, 1.0f);
+
+    //Each draw picks its object's slot in the uniform ring with a dynamic offset, its colour is pushed...
+    auto binduniforms = [&](uint32_t offset, const DrawConstants & constants){
+        if (!uniforms)
+            return;
+        vkCmdBindDescriptorSets(commandbuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &uniforms->descriptorSet, 1, &offset);
+        vkCmdPushConstants(commandbuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(DrawConstants), &constants);
+    };
+
+    //Pooled meshes are drawn from the GPU written list instead when there is one, split draws only record it once...
+    for (auto i = 0U; i < meshcount; i++){
+        if (!meshes[i].ready || (indirectdraws && meshes[i].pooled))
+            continue;
+        bindvariant(meshes[i].pipeline);
+        binduniforms(uniforms ? uniforms->offsets[i] : 0, meshes[i].constants);
+        meshes[i].record(commandbuffer, frame);
+    }
+
+    //Indirect draws share one set of uniforms, per object data would need indexing by draw...
+    if (indirectdraws && recordindirect){
+        bindvariant(0);
+        binduniforms(uniforms ? uniforms->defaultOffset : 0, DrawConstants{{1.0f, 1.0f, 1.0f, 1.0f}});
+        indirectdraws->record(commandbuffer, frame);
+    }
+}
@@ -2,56 +2,129 @@
 #define GRAPHICSPIPELINE_H
 
 #include "src/utility.h"
+#include "timestampquerypool.h"
+#include "mesh.h"
+#include "indirectdrawlist.h"
+#include "mappedfile.h"
+#include "threadpool.h"
+#include "descriptorlayoutcache.h"
+#include "pipelinestatecache.h"
+#include "rendergraph.h"
+#include <memory>
 
 class GraphicsPipeline
 {
     friend class LogicalDevice;
     friend class SwapChain;
+public:
+    enum DepthMode {
+        NO_DEPTH = 0,
+        DEPTH_TEST = 1,
+        DEPTH_PREPASS = 2,
+        DEPTH_MODE_COUNT = 3
+    };
 private:
     struct Shader final
     {
+        Shader() = default;
         Shader(VkDevice *device, const std::string & filepath, VkShaderStageFlagBits shadertype = VK_SHADER_STAGE_ALL);
         std::string name;
         std::string path;
-        VkShaderStageFlagBits stageFlag;
-        VkShaderModule shader;
+        VkShaderStageFlagBits stageFlag = VK_SHADER_STAGE_ALL;
+        VkShaderModule shader = VK_NULL_HANDLE;
+    };
+    struct DrawUniforms final
+    {
+        VkDescriptorSet descriptorSet;
+        const uint32_t *offsets;
+        uint32_t defaultOffset;
     };
 public:
-    GraphicsPipeline(VkDevice *device);
+    GraphicsPipeline(
+            VkDevice *device,
+            VkPipelineCache pipelinecache = VK_NULL_HANDLE,
+            ThreadPool *threadpool = nullptr,
+            DescriptorLayoutCache *layoutcache = nullptr
+            );
 public:
     GraphicsPipeline() = default;
     ~GraphicsPipeline() = default;
     GraphicsPipeline(const GraphicsPipeline & other) = default;
     GraphicsPipeline & operator=(const GraphicsPipeline & other) = default;
+public:
+    [[nodiscard]] static const char * getDepthModeName(DepthMode depthmode) noexcept;
 private:
-    void initializeFixedFunctions(VkExtent2D & swapchainextent);
-    void createRenderpass(VkFormat &format);
+    [[nodiscard]] static std::vector<std::string> findShaders();
+    [[nodiscard]] static std::vector<Shader> loadShaders(VkDevice *device, const std::vector<std::string> & shadernames, ThreadPool *threadpool = nullptr);
+    [[nodiscard]] GraphicsPipeline rebuild() const;
+    void swapShaders(GraphicsPipeline & other) noexcept;
+    void createPipelines();
+    [[nodiscard]] PipelineDescription describe(const PipelineState & state, bool depthonly = false) const;
+    void requestVariant(const PipelineState & state);
+    [[nodiscard]] std::vector<uint32_t> addVariants(const std::vector<PipelineState> & states);
+    [[nodiscard]] uint32_t getVariantCount() const noexcept;
+    void createRenderpass(VkFormat &format, VkImageLayout finallayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    void setDepthMode(DepthMode depthmode, VkFormat depthformat);
+    [[nodiscard]] DepthMode getDepthMode() const noexcept;
+    [[nodiscard]] VkFormat getDepthFormat() const noexcept;
+    void setSampleCount(VkSampleCountFlagBits samplecount) noexcept;
+    [[nodiscard]] VkSampleCountFlagBits getSampleCount() const noexcept;
     [[nodiscard]] VkRenderPass getRenderPass() const;
-    void createGraphicsPipeline(
-            VkPipelineShaderStageCreateInfo *shaderStages,
-            VkPipelineVertexInputStateCreateInfo * vertexInputInfo,
-            VkPipelineInputAssemblyStateCreateInfo * inputAssembly,
-            VkPipelineTessellationStateCreateInfo * tessellation,
-            VkPipelineViewportStateCreateInfo * viewportState,
-            VkPipelineRasterizationStateCreateInfo * rasterizer,
-            VkPipelineMultisampleStateCreateInfo * multisampling,
-            VkPipelineDepthStencilStateCreateInfo * depthStencil,
-            VkPipelineColorBlendStateCreateInfo * colorBlending,
-            VkPipelineDynamicStateCreateInfo * dynamicState
-            );
+    [[nodiscard]] RenderGraph & getRenderGraph() const;
+    [[nodiscard]] VkPipelineLayout getPipelineLayout() const noexcept;
+    [[nodiscard]] VkDescriptorSetLayout getSetLayout(uint32_t set) const;
     void startRenderPass(
             VkFramebuffer &framebuffer,
             VkExtent2D &swapchainextent,
             VkCommandBuffer &commandbuffer,
-            bool primarybuffer = true
+            const std::vector<Mesh> &meshes,
+            const std::vector<VkCommandBuffer> *secondarybuffers = nullptr,
+            const TimestampQueryPool *timestamps = nullptr,
+            uint32_t frame = 0,
+            const DrawUniforms *uniforms = nullptr,
+            const IndirectDrawList *indirectdraws = nullptr
             );
+    void recordSecondaryCommandBuffer(
+            VkCommandBuffer &commandbuffer,
+            VkFramebuffer &framebuffer,
+            VkExtent2D &swapchainextent,
+            const Mesh *meshes,
+            size_t meshcount,
+            uint32_t frame = 0,
+            const DrawUniforms *uniforms = nullptr,
+            const IndirectDrawList *indirectdraws = nullptr,
+            bool recordindirect = true
+            );
+    void recordDraws(
+            VkCommandBuffer &commandbuffer,
+            VkExtent2D &swapchainextent,
+            const Mesh *meshes,
+            size_t meshcount,
+            uint32_t frame = 0,
+            const DrawUniforms *uniforms = nullptr,
+            const IndirectDrawList *indirectdraws = nullptr,
+            bool recordindirect = true,
+            bool depthonly = false
+            ) const;
     void cleanup(bool destroyshaders = true) noexcept;
+    void cleanupRetired() noexcept;
 private:
     VkDevice *logicalDevice;
+    VkPipelineCache pipelineCache;
     std::vector <Shader> shaders;
+    std::vector <VkDescriptorSetLayout> setLayouts;
     VkRenderPass renderPass;
+    std::shared_ptr <RenderGraph> renderGraph;
+    uint32_t scenePass;
+    uint32_t depthPass;
+    DepthMode depthMode;
+    VkFormat depthFormat;
+    VkSampleCountFlagBits sampleCount;
     VkPipelineLayout pipelineLayout;
-    VkPipeline graphicsPipeline;
+    std::shared_ptr <PipelineStateCache> pipelineStates;
+    std::vector <PipelineState> variants;
+    std::vector <uint32_t> variantHandles;
+    std::vector <uint32_t> depthVariantHandles;
 };
 
 #endif // GRAPHICSPIPELINE_H
@@ -0,0 +1,248 @@
+#include "indirectdrawlist.h"
+
+/*!
+        \class IndirectDrawList
+        \brief The IndirectDrawList class culls and draws static meshes on the GPU.
+
+        Meshes that fit are packed into one shared geometry buffer, vertices first and their indices
+        straight after, so any of them can be drawn from a single vertex and index buffer binding. Once
+        a mesh's upload lands its bounding circle and draw parameters are appended to a host visible
+        object buffer. The object buffer is only ever appended to, so frames in flight never see their
+        part of it change.
+
+        Every frame a compute pass tests each object against the view and writes the survivors out as
+        VkDrawIndexedIndirectCommands, with one list per swapchain image so a frame never overwrites
+        what the previous one is still drawing. With VK_KHR_draw_indirect_count the list is compacted
+        and the GPU also writes the count, which one vkCmdDrawIndexedIndirectCountKHR consumes. Without
+        it every object keeps its slot and culled objects get an instance count of zero, so a single
+        vkCmdDrawIndexedIndirect still covers them all when multiDrawIndirect is enabled.
+*/
+
+IndirectDrawList::IndirectDrawList(
+        VkDevice *device,
+        const std::shared_ptr<DeviceMemoryAllocator> & memoryallocator,
+        DescriptorLayoutCache & layoutcache,
+        const VkPhysicalDeviceLimits & limits,
+        uint32_t computefamily,
+        uint32_t graphicsfamily,
+        bool multidrawindirect,
+        PFN_vkCmdDrawIndexedIndirectCountKHR drawindirectcount,
+        VkPipelineCache pipelinecache
+        )
+    : logicalDevice(device),
+      memoryAllocator(memoryallocator),
+      cullPipelineLoaded(false),
+      descriptorSet(VK_NULL_HANDLE),
+      geometryBuffer(VK_NULL_HANDLE),
+      geometryAllocation(),
+      geometryUsed(0),
+      geometryCount(0),
+      objectBuffer(VK_NULL_HANDLE),
+      objectAllocation(),
+      objectCount(0),
+      drawBuffer(VK_NULL_HANDLE),
+      drawAllocation(),
+      countSize(0),
+      frameStride(0),
+      frameCount(0),
+      minStorageBufferOffsetAlignment((std::max)(limits.minStorageBufferOffsetAlignment, static_cast<VkDeviceSize>(sizeof(uint32_t)))),
+      computeQueueFamilyIndex(computefamily),
+      graphicsQueueFamilyIndex(graphicsfamily),
+      multiDrawIndirect(multidrawindirect && limits.maxDrawIndirectCount > 1),
+      cmdDrawIndexedIndirectCount(drawindirectcount)
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to IndirectDrawList!");
+    if (!memoryallocator)
+        throw std::runtime_error("Null memory allocator passed to IndirectDrawList!");
+
+    //The cull shader is optional, without it meshes in the geometry buffer are drawn one by one...
+    auto shaderpath = fs::path(getShaderDirectory()) / CULL_SHADER_NAME;
+    if (fs::exists(shaderpath)){
+        cullPipeline = ComputePipeline(logicalDevice, shaderpath.u8string(), 3, sizeof(CullParameters), layoutcache, pipelinecache);
+        cullPipelineLoaded = true;
+    }
+
+    //Objects are written by the host and only ever read by the cull pass...
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = INDIRECT_DRAW_MAX_OBJECTS * sizeof(ObjectData);
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(*logicalDevice, &bufferInfo, nullptr, &objectBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create indirect object buffer!");
+    objectAllocation = memoryAllocator->allocateBuffer(objectBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+bool IndirectDrawList::canCull() const noexcept{
+    return cullPipelineLoaded;
+}
+
+bool IndirectDrawList::usesDrawCount() const noexcept{
+    return cmdDrawIndexedIndirectCount != nullptr;
+}
+
+uint32_t IndirectDrawList::getObjectCount() const noexcept{
+    return objectCount;
+}
+
+bool IndirectDrawList::allocateGeometry(VkDeviceSize size, VkDeviceSize & offset){
+    //Meshes start on a whole vertex so the draw's vertexOffset can point at them, indices follow 4 byte aligned...
+    auto start = (geometryUsed + sizeof(Vertex) - 1) / sizeof(Vertex) * sizeof(Vertex);
+    if (start + size > GEOMETRY_POOL_SIZE || geometryCount >= INDIRECT_DRAW_MAX_OBJECTS)
+        return false;
+
+    //Only created once the first mesh needs it...
+    if (geometryBuffer == VK_NULL_HANDLE){
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = GEOMETRY_POOL_SIZE;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(*logicalDevice, &bufferInfo, nullptr, &geometryBuffer) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create geometry buffer!");
+        geometryAllocation = memoryAllocator->allocateBuffer(geometryBuffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+    offset = start;
+    geometryUsed = start + size;
+    geometryCount++;
+    return true;
+}
+
+VkBuffer IndirectDrawList::getGeometryBuffer() const noexcept{
+    return geometryBuffer;
+}
+
+void IndirectDrawList::addObject(const Mesh & mesh){
+    if (objectCount >= INDIRECT_DRAW_MAX_OBJECTS)
+        throw std::runtime_error("Too many objects added to the indirect draw list!");
+
+    //Appended past the count any recorded frame was given, so nothing in flight reads it...
+    auto & object = static_cast<ObjectData *>(objectAllocation.mapped)[objectCount];
+    std::copy(mesh.bounds, mesh.bounds + 4, object.bounds);
+    object.indexCount = mesh.indexCount;
+    object.firstIndex = static_cast<uint32_t>((mesh.bufferOffset + mesh.indexOffset) / sizeof(uint32_t));
+    object.vertexOffset = static_cast<int32_t>(mesh.bufferOffset / sizeof(Vertex));
+    object.padding = 0;
+    objectCount++;
+}
+
+void IndirectDrawList::createDrawBuffers(uint32_t framecount, DescriptorAllocator & descriptorallocator){
+    if (!cullPipelineLoaded || framecount <= frameCount)
+        return;
+    destroyDrawBuffers();
+
+    //Each image's region holds the draw count followed by the commands, both on storage offset boundaries...
+    auto align = [&](VkDeviceSize size){ return (size + minStorageBufferOffsetAlignment - 1) / minStorageBufferOffsetAlignment * minStorageBufferOffsetAlignment; };
+    countSize = align(sizeof(uint32_t));
+    frameStride = align(countSize + INDIRECT_DRAW_MAX_OBJECTS * sizeof(VkDrawIndexedIndirectCommand));
+    frameCount = framecount;
+
+    //Written on the compute family and read by the graphics family's indirect draws...
+    uint32_t families[] = {computeQueueFamilyIndex, graphicsQueueFamilyIndex};
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = frameStride * frameCount;
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    if (computeQueueFamilyIndex != graphicsQueueFamilyIndex){
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = families;
+    }else{
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+    if (vkCreateBuffer(*logicalDevice, &bufferInfo, nullptr, &drawBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create indirect draw buffer!");
+    drawAllocation = memoryAllocator->allocateBuffer(drawBuffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    //Dynamic offsets pick the image's region, so one descriptor set covers them all...
+    std::vector <VkDescriptorBufferInfo> buffers = {
+        {objectBuffer, 0, INDIRECT_DRAW_MAX_OBJECTS * sizeof(ObjectData)},
+        {drawBuffer, 0, countSize},
+        {drawBuffer, countSize, INDIRECT_DRAW_MAX_OBJECTS * sizeof(VkDrawIndexedIndirectCommand)}
+    };
+    if (descriptorSet == VK_NULL_HANDLE)
+        descriptorSet = cullPipeline.allocateDescriptorSet(descriptorallocator, buffers);
+    else
+        cullPipeline.updateDescriptorSet(descriptorSet, buffers);
+}
+
+void IndirectDrawList::destroyDrawBuffers() noexcept{
+    if (drawBuffer != VK_NULL_HANDLE){
+        vkDestroyBuffer(*logicalDevice, drawBuffer, nullptr);
+        memoryAllocator->free(drawAllocation);
+    }
+    drawBuffer = VK_NULL_HANDLE;
+    frameCount = 0;
+}
+
+void IndirectDrawList::recordCull(VkCommandBuffer commandbuffer, uint32_t frame) const{
+    if (drawBuffer == VK_NULL_HANDLE || frame >= frameCount)
+        throw std::runtime_error("Indirect draw buffers haven't been created for this frame!");
+
+    //Compacted lists are appended to, so the count starts from zero...
+    auto offset = frame * frameStride;
+    if (usesDrawCount()){
+        vkCmdFillBuffer(commandbuffer, drawBuffer, offset, countSize, 0);
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = drawBuffer;
+        barrier.offset = offset;
+        barrier.size = countSize;
+        vkCmdPipelineBarrier(commandbuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+    if (!objectCount)
+        return;
+
+    //There's no camera yet, so the view is the whole of clip space...
+    CullParameters parameters = {{-1.0f, -1.0f, 1.0f, 1.0f}, objectCount, usesDrawCount() ? 1U : 0U};
+    auto dynamicoffset = static_cast<uint32_t>(offset);
+    cullPipeline.dispatch(
+                commandbuffer,
+                descriptorSet,
+                {0, dynamicoffset, dynamicoffset},
+                (objectCount + COMPUTE_WORKGROUP_SIZE - 1) / COMPUTE_WORKGROUP_SIZE,
+                &parameters
+                );
+}
+
+void IndirectDrawList::record(VkCommandBuffer commandbuffer, uint32_t frame) const noexcept{
+    if (!objectCount || drawBuffer == VK_NULL_HANDLE || frame >= frameCount)
+        return;
+
+    //Every object shares one binding, each command's firstIndex and vertexOffset find its mesh...
+    VkDeviceSize zero = 0;
+    vkCmdBindVertexBuffers(commandbuffer, 0, 1, &geometryBuffer, &zero);
+    vkCmdBindIndexBuffer(commandbuffer, geometryBuffer, 0, VK_INDEX_TYPE_UINT32);
+    auto offset = frame * frameStride;
+    auto stride = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand));
+    if (usesDrawCount()){
+        cmdDrawIndexedIndirectCount(commandbuffer, drawBuffer, offset + countSize, drawBuffer, offset, INDIRECT_DRAW_MAX_OBJECTS, stride);
+    }else if (multiDrawIndirect){
+        vkCmdDrawIndexedIndirect(commandbuffer, drawBuffer, offset + countSize, objectCount, stride);
+    }else{
+        for (auto i = 0U; i < objectCount; i++)
+            vkCmdDrawIndexedIndirect(commandbuffer, drawBuffer, offset + countSize + i * stride, 1, stride);
+    }
+}
+
+void IndirectDrawList::cleanup() noexcept{
+    destroyDrawBuffers();
+    if (geometryBuffer != VK_NULL_HANDLE){
+        vkDestroyBuffer(*logicalDevice, geometryBuffer, nullptr);
+        memoryAllocator->free(geometryAllocation);
+    }
+    if (objectBuffer != VK_NULL_HANDLE){
+        vkDestroyBuffer(*logicalDevice, objectBuffer, nullptr);
+        memoryAllocator->free(objectAllocation);
+    }
+    if (cullPipelineLoaded)
+        cullPipeline.cleanup();
+    geometryBuffer = VK_NULL_HANDLE;
+    objectBuffer = VK_NULL_HANDLE;
+    cullPipelineLoaded = false;
+}
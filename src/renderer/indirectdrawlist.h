@@ -0,0 +1,83 @@
+#ifndef INDIRECTDRAWLIST_H
+#define INDIRECTDRAWLIST_H
+
+#include "computepipeline.h"
+#include "devicememoryallocator.h"
+#include "mesh.h"
+#include <memory>
+
+class IndirectDrawList final
+{
+    friend class LogicalDevice;
+    friend class GraphicsPipeline;
+private:
+    struct ObjectData final
+    {
+        float bounds[4];
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t padding;
+    };
+    struct CullParameters final
+    {
+        float view[4];
+        uint32_t objectCount;
+        uint32_t compact;
+    };
+public:
+    IndirectDrawList(
+            VkDevice *device,
+            const std::shared_ptr<DeviceMemoryAllocator> & memoryallocator,
+            DescriptorLayoutCache & layoutcache,
+            const VkPhysicalDeviceLimits & limits,
+            uint32_t computefamily,
+            uint32_t graphicsfamily,
+            bool multidrawindirect,
+            PFN_vkCmdDrawIndexedIndirectCountKHR drawindirectcount = nullptr,
+            VkPipelineCache pipelinecache = VK_NULL_HANDLE
+            );
+public:
+    IndirectDrawList() = default;
+    ~IndirectDrawList() = default;
+    IndirectDrawList(const IndirectDrawList & other) = default;
+    IndirectDrawList & operator=(const IndirectDrawList & other) = default;
+public:
+    [[nodiscard]] bool canCull() const noexcept;
+    [[nodiscard]] bool usesDrawCount() const noexcept;
+    [[nodiscard]] uint32_t getObjectCount() const noexcept;
+private:
+    [[nodiscard]] bool allocateGeometry(VkDeviceSize size, VkDeviceSize & offset);
+    [[nodiscard]] VkBuffer getGeometryBuffer() const noexcept;
+    void addObject(const Mesh & mesh);
+    void createDrawBuffers(uint32_t framecount, DescriptorAllocator & descriptorallocator);
+    void destroyDrawBuffers() noexcept;
+    void recordCull(VkCommandBuffer commandbuffer, uint32_t frame) const;
+    void record(VkCommandBuffer commandbuffer, uint32_t frame) const noexcept;
+    void cleanup() noexcept;
+private:
+    VkDevice *logicalDevice;
+    std::shared_ptr <DeviceMemoryAllocator> memoryAllocator;
+    ComputePipeline cullPipeline;
+    bool cullPipelineLoaded;
+    VkDescriptorSet descriptorSet;
+    VkBuffer geometryBuffer;
+    DeviceMemoryAllocator::Allocation geometryAllocation;
+    VkDeviceSize geometryUsed;
+    uint32_t geometryCount;
+    VkBuffer objectBuffer;
+    DeviceMemoryAllocator::Allocation objectAllocation;
+    uint32_t objectCount;
+    VkBuffer drawBuffer;
+    DeviceMemoryAllocator::Allocation drawAllocation;
+    VkDeviceSize countSize;
+    VkDeviceSize frameStride;
+    uint32_t frameCount;
+    VkDeviceSize minStorageBufferOffsetAlignment;
+    uint32_t computeQueueFamilyIndex;
+    uint32_t graphicsQueueFamilyIndex;
+    bool multiDrawIndirect;
+    PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount;
+};
+
+#endif // INDIRECTDRAWLIST_H
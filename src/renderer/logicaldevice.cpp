@@ -1,15 +1,49 @@
 #include "logicaldevice.h"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
 
 LogicalDevice::LogicalDevice(
         VkDevice *device,
+        VkPhysicalDevice physicaldevice,
         const QueueFamilyInfo & graphicsqueue,
         const QueueFamilyInfo & computequeue,
-        VkSwapchainCreateInfoKHR *swapchaincreateinfo
+        const QueueFamilyInfo & transferqueue,
+        VkSwapchainCreateInfoKHR *swapchaincreateinfo,
+        const VkPhysicalDeviceMemoryProperties & memoryproperties,
+        const VkPhysicalDeviceProperties & deviceproperties,
+        uint32_t timestampvalidbits,
+        const VkPhysicalDeviceFeatures & enabledfeatures,
+        bool drawindirectcount
         )
     : logicalDevice(device),
-      swapChain(device),
+      recordingThreads(graphicsqueue.queueCount ? std::make_shared<ThreadPool>() : nullptr),
+      secondarySlotCount(0),
+      recordEveryFrame(false),
+      swapChainStale(false),
+      requestedExtent({0, 0}),
+      gpuDriven(false),
+      computeQueue(VK_NULL_HANDLE),
+      computeCommandPool(VK_NULL_HANDLE),
+      computeStartTime(std::chrono::steady_clock::now()),
+      minStorageBufferOffsetAlignment(deviceproperties.limits.minStorageBufferOffsetAlignment),
+      pipelineCache(device, deviceproperties),
+      descriptorLayouts(std::make_shared<DescriptorLayoutCache>(device)),
+      staticDescriptors(std::make_shared<DescriptorAllocator>(device)),
+      memoryAllocator(std::make_shared<DeviceMemoryAllocator>(device, memoryproperties, deviceproperties.limits)),
+      swapChain(
+          device,
+          physicaldevice,
+          memoryAllocator,
+          pipelineCache.getPipelineCache(),
+          TimestampQueryPool(device, deviceproperties.limits.timestampPeriod, timestampvalidbits),
+          recordingThreads.get(),
+          descriptorLayouts.get()
+          ),
       flag(USING_NONE),
-      graphicsQueueFamilyIndex(graphicsqueue.queueFamilyIndex)
+      graphicsQueueFamilyIndex(graphicsqueue.queueFamilyIndex),
+      transferQueueFamilyIndex(graphicsqueue.queueFamilyIndex),
+      computeQueueFamilyIndex(graphicsqueue.queueFamilyIndex)
 {
     if (!device)
         throw std::runtime_error("Null device passed to LogicalDevice!");
@@ -21,23 +55,92 @@ LogicalDevice::LogicalDevice(
         flag = USING_GRAPHICS_POOL;
     if (computequeue.queueCount)
         flag = (Flag)(flag | USING_COMPUTE_POOL);
+    if (graphicsqueue.queueCount && transferqueue.queueCount)
+        flag = (Flag)(flag | USING_TRANSFER_POOL);
 
     //Obtain handles to all available graphics and compute queues...
-    auto getqueues = [&](std::vector <VkQueue> & queues, const QueueFamilyInfo & queueinfo){
+    auto getqueues = [&](std::vector <VkQueue> & queues, const QueueFamilyInfo & queueinfo, uint32_t firstqueue){
         queues.resize(queueinfo.queueCount);
         for (uint32_t i = 0; i < queueinfo.queueCount; i++)
-            vkGetDeviceQueue(*device, queueinfo.queueFamilyIndex, i, &queues[i]);
+            vkGetDeviceQueue(*device, queueinfo.queueFamilyIndex, firstqueue + i, &queues[i]);
     };
-    getqueues(graphicsQueues, graphicsqueue);
-    //getqueues(computeQueues, computequeue);
+    getqueues(graphicsQueues, graphicsqueue, 0);
+
+    //Compute queues sharing the graphics family were created after the graphics queues...
+    auto sharedfamily = graphicsqueue.queueCount && computequeue.queueFamilyIndex == graphicsqueue.queueFamilyIndex;
+    getqueues(computeQueues, computequeue, sharedfamily ? graphicsqueue.queueCount : 0);
+
+    //Without a queue of its own, compute work is submitted to the graphics queue instead...
+    if (!computeQueues.empty()){
+        computeQueue = computeQueues.front();
+        computeQueueFamilyIndex = computequeue.queueFamilyIndex;
+    }else if (!graphicsQueues.empty()){
+        computeQueue = graphicsQueues.front();
+    }
 
     //Create swapchain and retreive swapchain images...
     if (swapchaincreateinfo)
         swapChain.initializeSwapChain(swapchaincreateinfo);
 
+    //Static meshes share one geometry buffer that a compute pass can cull and draw indirectly...
+    if (flag & USING_GRAPHICS_POOL){
+        auto drawcount = drawindirectcount ? reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(*device, "vkCmdDrawIndexedIndirectCountKHR")) : nullptr;
+        indirectDraws = IndirectDrawList(
+                    device,
+                    memoryAllocator,
+                    *descriptorLayouts,
+                    deviceproperties.limits,
+                    computeQueueFamilyIndex,
+                    graphicsQueueFamilyIndex,
+                    enabledfeatures.multiDrawIndirect == VK_TRUE,
+                    drawcount,
+                    pipelineCache.getPipelineCache()
+                    );
+        uniformRing = UniformRingBuffer(device, memoryAllocator, deviceproperties.limits);
+    }
+
+    //Every other *comp.spv shader gets a pipeline, along with a pool for the per frame compute command buffers...
+    if (computeQueue != VK_NULL_HANDLE){
+        for (auto & shader : fs::directory_iterator(getShaderDirectory())){
+            auto name = shader.path().filename().generic_u8string();
+            if (name.find(".spv") != std::string::npos && name.find(COMPUTE_SHADER_SUBSTRING) != std::string::npos && name != CULL_SHADER_NAME)
+                computePipelines.push_back(ComputePipeline(
+                                               logicalDevice,
+                                               shader.path().generic_u8string(),
+                                               2,
+                                               sizeof(ComputeParameters),
+                                               *descriptorLayouts,
+                                               pipelineCache.getPipelineCache()
+                                               ));
+        }
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = computeQueueFamilyIndex;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        if (vkCreateCommandPool(*logicalDevice, &poolInfo, nullptr, &computeCommandPool) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create compute command pool!");
+        if (flag & USING_GRAPHICS_POOL)
+            createComputeCommandBuffers();
+    }
+
     //Initialise command pools and retreive buffers...
     if (flag & USING_GRAPHICS_POOL){
         createGraphicsCommandBuffers(&graphicsCommandPool);
+        transferQueue = graphicsQueues.front();
+    }
+
+    //Uploads go through a transfer only family when there is one, so they never queue behind rendering...
+    if (flag & USING_TRANSFER_POOL){
+        transferQueueFamilyIndex = transferqueue.queueFamilyIndex;
+        vkGetDeviceQueue(*device, transferQueueFamilyIndex, 0, &transferQueue);
+    }
+    if (flag & USING_GRAPHICS_POOL){
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = transferQueueFamilyIndex;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        if (vkCreateCommandPool(*logicalDevice, &poolInfo, nullptr, &transferCommandPool) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create transfer command pool!");
     }
 }
 
@@ -62,48 +165,790 @@ void LogicalDevice::createGraphicsCommandBuffers(VkCommandPool *commandpool, boo
     if (vkAllocateCommandBuffers(*logicalDevice, &allocInfo, graphicsCommandBuffers.data()) != VK_SUCCESS)
         throw std::runtime_error("Failed to allocate command buffers!");
 
-    //Record command buffers...
-    for (auto & buffer: graphicsCommandBuffers){
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        beginInfo.pInheritanceInfo = nullptr;
-        if (vkBeginCommandBuffer(buffer, &beginInfo) != VK_SUCCESS)
-            throw std::runtime_error("Failed to record command buffer!");
+    //Worker threads record into their own pools, so the pools follow the image count too...
+    createSecondaryCommandPools();
+
+    //Per frame descriptor sets are recycled whenever their image is re-recorded...
+    while (frameDescriptors.size() < graphicsCommandBuffers.size())
+        frameDescriptors.push_back(DescriptorAllocator(logicalDevice));
+
+    //Every image gets its own region of the uniform ring, nothing is in flight to read the old one...
+    uniformRing.createFrames(static_cast<uint32_t>(graphicsCommandBuffers.size()));
+    uniformOffsets.assign(graphicsCommandBuffers.size(), std::vector<uint32_t>());
+
+    //For each framebuffer, record a command buffer that runs its renderpass...
+    graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), false);
+    for (auto i = 0U; i < graphicsCommandBuffers.size(); i++){
+        updateUniforms(i);
+        recordGraphicsCommandBuffer(i);
+    }
+}
+
+void LogicalDevice::recordGraphicsCommandBuffer(uint32_t imageindex){
+    auto start = std::chrono::steady_clock::now();
+
+    //Only called once the image's last submission has retired, so its sets can be reused. One dynamic
+    //uniform buffer descriptor covers the whole ring, the offsets written by updateUniforms pick the slots...
+    frameDescriptors[imageindex].reset();
+    auto & pipeline = swapChain.graphicsPipeline;
+    VkDescriptorBufferInfo bufferInfo = {uniformRing.getBuffer(), 0, sizeof(MeshUniforms)};
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = frameDescriptors[imageindex].allocate(pipeline.getSetLayout(0));
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descriptorWrite.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(*logicalDevice, 1, &descriptorWrite, 0, nullptr);
+    const auto & offsets = uniformOffsets[imageindex];
+    GraphicsPipeline::DrawUniforms uniforms = {descriptorWrite.dstSet, offsets.data() + 1, offsets.front()};
+
+    //Large draw lists are split across the worker threads, one secondary buffer per slot...
+    std::vector <VkCommandBuffer> secondarybuffers;
+    auto slotcount = (std::min)(
+                secondarySlotCount,
+                static_cast<uint32_t>((meshes.size() + MIN_DRAWS_PER_RECORDING_THREAD - 1) / MIN_DRAWS_PER_RECORDING_THREAD)
+                );
+    if (meshes.size() >= PARALLEL_RECORDING_DRAW_THRESHOLD && slotcount > 1){
+        secondarybuffers.resize(slotcount);
+        recordingThreads->parallelFor(slotcount, [&](uint32_t, size_t slot){
+            //Each slot owns its pool, so no two threads ever touch the same one...
+            auto index = imageindex * secondarySlotCount + slot;
+            vkResetCommandPool(*logicalDevice, secondaryCommandPools[index], 0);
+            auto first = meshes.size() * slot / slotcount;
+            auto last = meshes.size() * (slot + 1) / slotcount;
+            GraphicsPipeline::DrawUniforms slotuniforms = {uniforms.descriptorSet, uniforms.offsets + first, uniforms.defaultOffset};
+            swapChain.recordSecondaryCommandBuffer(
+                        secondaryCommandBuffers[index],
+                        imageindex,
+                        meshes.data() + first,
+                        last - first,
+                        &slotuniforms,
+                        gpuDriven ? &indirectDraws : nullptr,
+                        slot == 0
+                        );
+            secondarybuffers[slot] = secondaryCommandBuffers[index];
+        });
+    }
+
+    //The primary buffer is free to reuse for the same reason...
+    auto & buffer = graphicsCommandBuffers[imageindex];
+    vkResetCommandBuffer(buffer, 0);
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    beginInfo.pInheritanceInfo = nullptr;
+    if (vkBeginCommandBuffer(buffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failed to record command buffer!");
+    swapChain.recordCommandBuffer(buffer, imageindex, meshes, &secondarybuffers, &uniforms, gpuDriven ? &indirectDraws : nullptr);
+    graphicsCommandBuffersDirty[imageindex] = false;
+    recordingStatistics.addSample(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+}
+
+void LogicalDevice::updateUniforms(uint32_t imageindex){
+    //Regions that are too small grow to twice what's needed, the old buffer may still be in use by any image...
+    auto required = uniformRing.getAlignedSize(sizeof(MeshUniforms)) * (meshes.size() + 1);
+    if (required > uniformRing.getFrameSize()){
+        vkDeviceWaitIdle(*logicalDevice);
+        uniformRing.createFrames(static_cast<uint32_t>(graphicsCommandBuffers.size()), required * 2);
+        uniformOffsets.assign(graphicsCommandBuffers.size(), std::vector<uint32_t>());
+        graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+    }
+
+    //The image's last submission has retired, so its region of the ring is free to overwrite...
+    uniformRing.beginFrame(imageindex);
+
+    //Slot 0 is identity data for draws with no object of their own, each mesh follows in order. The order
+    //never changes, so the offsets only move when meshes are added and recorded buffers otherwise stay valid...
+    auto & offsets = uniformOffsets[imageindex];
+    auto changed = offsets.size() != meshes.size() + 1;
+    offsets.resize(meshes.size() + 1);
+    auto write = [&](size_t slot, const MeshUniforms & uniforms){
+        auto offset = uniformRing.write(&uniforms, sizeof(MeshUniforms));
+        changed = changed || offsets[slot] != offset;
+        offsets[slot] = offset;
+    };
+    write(0, MeshUniforms{{0.0f, 0.0f, 1.0f, 0.0f}});
+    for (auto i = 0U; i < meshes.size(); i++)
+        write(i + 1, meshes[i].uniforms);
+    if (changed)
+        graphicsCommandBuffersDirty[imageindex] = true;
+}
+
+void LogicalDevice::createSecondaryCommandPools(){
+    destroySecondaryCommandPools();
+
+    //Command pools aren't thread safe, so every image gets a pool per worker thread...
+    secondarySlotCount = recordingThreads->getThreadCount();
+    auto poolcount = graphicsCommandBuffers.size() * secondarySlotCount;
+    secondaryCommandPools.resize(poolcount, VK_NULL_HANDLE);
+    secondaryCommandBuffers.resize(poolcount, VK_NULL_HANDLE);
+    for (auto i = 0U; i < poolcount; i++){
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = graphicsQueueFamilyIndex;
+        if (vkCreateCommandPool(*logicalDevice, &poolInfo, nullptr, &secondaryCommandPools[i]) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create secondary command pool!");
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = secondaryCommandPools[i];
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(*logicalDevice, &allocInfo, &secondaryCommandBuffers[i]) != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate secondary command buffers!");
     }
+}
 
-    //For each framebuffer, bind a command buffer to it and start renderpass...
-    swapChain.startRenderPass(graphicsCommandBuffers);
+void LogicalDevice::destroySecondaryCommandPools() noexcept{
+    //Destroying a pool frees its command buffers with it...
+    for (auto & pool : secondaryCommandPools)
+        if (pool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(*logicalDevice, pool, nullptr);
+    secondaryCommandPools.clear();
+    secondaryCommandBuffers.clear();
 }
-void LogicalDevice::recreateSwapChain(){
-    //May need to destroy frame buffers first...
+
+void LogicalDevice::setRecordingThreadCount(uint32_t threadcount){
+    if (!(flag & USING_GRAPHICS_POOL))
+        throw std::runtime_error("Recording threads need a logical device with graphics queues!");
+
+    //The old pools may still back buffers in flight...
+    vkDeviceWaitIdle(*logicalDevice);
+    recordingThreads = std::make_shared<ThreadPool>(threadcount);
+    createSecondaryCommandPools();
+    graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+}
+
+uint32_t LogicalDevice::getRecordingThreadCount() const noexcept{
+    return recordingThreads ? recordingThreads->getThreadCount() : 0;
+}
+
+void LogicalDevice::setRecordEveryFrame(bool recordeveryframe) noexcept{
+    recordEveryFrame = recordeveryframe;
+}
+
+const FrameStatistics & LogicalDevice::getRecordingStatistics() const noexcept{
+    return recordingStatistics;
+}
+
+void LogicalDevice::setShaderHotReload(bool enable){
+    if (enable == isShaderHotReloadEnabled())
+        return;
+    if (enable)
+        shaderWatcher = std::make_shared<ShaderWatcher>(getShaderDirectory());
+    else
+        shaderWatcher.reset();
+}
+
+bool LogicalDevice::isShaderHotReloadEnabled() const noexcept{
+    return shaderWatcher != nullptr;
+}
+
+void LogicalDevice::setGpuDriven(bool gpudriven){
+    if (gpudriven == gpuDriven)
+        return;
+    if (gpudriven && (!(flag & USING_GRAPHICS_POOL) || !indirectDraws.canCull()))
+        throw std::runtime_error("GPU driven rendering needs a graphics device and the cull.comp.spv shader!");
+    gpuDriven = gpudriven;
+    graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+}
+
+bool LogicalDevice::isGpuDriven() const noexcept{
+    return gpuDriven;
+}
+
+void LogicalDevice::requestSwapChainRecreation(VkExtent2D extent) noexcept{
+    //Only noted here, however many requests arrive before the next frame it's rebuilt once...
+    swapChainStale = true;
+    if (extent.width && extent.height)
+        requestedExtent = extent;
+}
+
+bool LogicalDevice::recreateSwapChain(){
+    //Retired images live until the frames using them retire, so nothing here waits for the device...
+    auto imagecount = swapChain.getSwapChainFramebuffersCount();
+    if (!swapChain.recreateSwapChain(requestedExtent))
+        return false;
+    swapChainStale = false;
+    requestedExtent = {0, 0};
+
+    //Per image resources are still guarded by their image's fence, they just need recording against the new framebuffers...
+    if (swapChain.getSwapChainFramebuffersCount() == imagecount){
+        graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+        return true;
+    }
+
+    //A different image count resizes every per image resource, which can only happen once they're idle...
+    vkDeviceWaitIdle(*logicalDevice);
     vkFreeCommandBuffers(
                 *logicalDevice,
                 graphicsCommandPool,
                 static_cast<uint32_t>(graphicsCommandBuffers.size()),
                 graphicsCommandBuffers.data()
                 );
-    swapChain.recreateSwapChain();
+    if (computeCommandPool != VK_NULL_HANDLE)
+        createComputeCommandBuffers();
     createGraphicsCommandBuffers(&graphicsCommandPool, false);
+    return true;
 }
 
 void LogicalDevice::drawFrame(){
-    //Start drawing...
-    auto result = swapChain.draw(graphicsCommandBuffers, graphicsQueues);
+    //Hand finished uploads over to the graphics queue before this frame is submitted...
+    processUploads();
+
+    //Changed shaders are rebuilt in the background and swapped in between frames, which makes every recorded buffer stale...
+    if (shaderWatcher && !swapChain.isReloadingShaders() && shaderWatcher->takeChanges())
+        swapChain.startShaderReload();
+    if (swapChain.finishShaderReload())
+        graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+
+    //Resizes since the last frame are handled together, a minimised window skips frames until it has an extent again...
+    auto recreated = false;
+    if (swapChainStale){
+        if (!recreateSwapChain())
+            return;
+        recreated = true;
+    }
 
-    //Swapchain is out of date or is suboptimal, try once more...
-    if (result != VK_SUCCESS){
-        recreateSwapChain();
-        swapChain.draw(graphicsCommandBuffers, graphicsQueues);
+    //Swapchain is out of date, recreate it and try once more unless that already happened this frame...
+    uint32_t imageindex;
+    auto result = swapChain.acquireImage(imageindex);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR){
+        swapChainStale = true;
+        if (recreated || !recreateSwapChain())
+            return;
+        result = swapChain.acquireImage(imageindex);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR){
+            swapChainStale = true;
+            return;
+        }
     }
+
+    //The image's previous frame has retired, so its uniforms can be rewritten and a stale command buffer re-recorded now...
+    updateUniforms(imageindex);
+    if (recordEveryFrame || graphicsCommandBuffersDirty[imageindex])
+        recordGraphicsCommandBuffer(imageindex);
+
+    //Compute for this frame overlaps the previous frame's graphics work, only the indirect draws and vertex input wait on it...
+    auto computefinished = submitCompute(imageindex);
+    auto presentresult = swapChain.submitFrame(graphicsCommandBuffers[imageindex], imageindex, graphicsQueues, computefinished, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+
+    //Swapchain is suboptimal or went out of date while presenting, it's rebuilt at the start of the next frame...
+    if (result != VK_SUCCESS || presentresult != VK_SUCCESS)
+        swapChainStale = true;
+}
+
+uint32_t LogicalDevice::addMesh(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices){
+    if (!(flag & USING_GRAPHICS_POOL))
+        throw std::runtime_error("Meshes need a logical device with graphics queues!");
+    if (vertices.empty() || indices.empty())
+        throw std::runtime_error("Empty mesh passed to addMesh!");
+
+    //Vertices first, then the indices, in one buffer...
+    auto vertexsize = static_cast<VkDeviceSize>(vertices.size() * sizeof(Vertex));
+    auto indexoffset = (vertexsize + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t);
+    auto size = indexoffset + static_cast<VkDeviceSize>(indices.size() * sizeof(uint32_t));
+
+    //A bounding circle around the mesh's vertices lets the cull pass reject it...
+    float lower[3] = {vertices.front().position[0], vertices.front().position[1], vertices.front().position[2]};
+    float upper[3] = {lower[0], lower[1], lower[2]};
+    for (const auto & vertex : vertices){
+        for (auto i = 0U; i < 3; i++){
+            lower[i] = (std::min)(lower[i], vertex.position[i]);
+            upper[i] = (std::max)(upper[i], vertex.position[i]);
+        }
+    }
+    float bounds[4] = {(lower[0] + upper[0]) * 0.5f, (lower[1] + upper[1]) * 0.5f, (lower[2] + upper[2]) * 0.5f, 0.0f};
+    for (const auto & vertex : vertices){
+        auto x = vertex.position[0] - bounds[0], y = vertex.position[1] - bounds[1], z = vertex.position[2] - bounds[2];
+        bounds[3] = (std::max)(bounds[3], std::sqrt(x * x + y * y + z * z));
+    }
+    auto createbuffer = [&](VkBufferUsageFlags usage){
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer buffer;
+        if (vkCreateBuffer(*logicalDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create buffer!");
+        return buffer;
+    };
+
+    //Fill a host visible staging buffer...
+    PendingUpload upload = {};
+    upload.stagingBuffer = createbuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    upload.stagingAllocation = memoryAllocator->allocateBuffer(upload.stagingBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    std::memcpy(upload.stagingAllocation.mapped, vertices.data(), static_cast<size_t>(vertexsize));
+    std::memcpy(static_cast<char *>(upload.stagingAllocation.mapped) + indexoffset, indices.data(), indices.size() * sizeof(uint32_t));
+    memoryAllocator->flush(upload.stagingAllocation);
+
+    //The mesh itself lives in device local memory and isn't drawn until the copy has landed. It goes in the
+    //shared geometry buffer while there's room, so the GPU driven path can draw it, or a buffer of its own...
+    VkBuffer buffer;
+    if (indirectDraws.allocateGeometry(size, upload.offset)){
+        buffer = indirectDraws.getGeometryBuffer();
+        meshes.push_back(Mesh(buffer, DeviceMemoryAllocator::Allocation(), indexoffset, static_cast<uint32_t>(indices.size()), 0, upload.offset));
+        meshes.back().pooled = true;
+    }else{
+        buffer = createbuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+        meshes.push_back(Mesh(buffer, memoryAllocator->allocateBuffer(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), indexoffset, static_cast<uint32_t>(indices.size())));
+        upload.offset = 0;
+    }
+    std::copy(bounds, bounds + 4, meshes.back().bounds);
+    upload.size = size;
+    upload.mesh = static_cast<uint32_t>(meshes.size() - 1);
+
+    //Record the copy...
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = transferCommandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(*logicalDevice, &allocInfo, &upload.transferCommandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate transfer command buffer!");
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(upload.transferCommandBuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failed to begin recording command buffer!");
+    VkBufferCopy region = {0, upload.offset, size};
+    vkCmdCopyBuffer(upload.transferCommandBuffer, upload.stagingBuffer, buffer, 1, &region);
+
+    //On another family this is the release half of an ownership transfer, otherwise a plain barrier...
+    auto ownershiptransfer = transferQueueFamilyIndex != graphicsQueueFamilyIndex;
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = ownershiptransfer ? 0 : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    barrier.srcQueueFamilyIndex = ownershiptransfer ? transferQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = ownershiptransfer ? graphicsQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = upload.offset;
+    barrier.size = size;
+    vkCmdPipelineBarrier(
+                upload.transferCommandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                ownershiptransfer ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                0, 0, nullptr, 1, &barrier, 0, nullptr
+                );
+    if (vkEndCommandBuffer(upload.transferCommandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to record transfer command buffer!");
+
+    //Submit without waiting, drawFrame picks the upload up once its fence signals...
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateSemaphore(*logicalDevice, &semaphoreInfo, nullptr, &upload.transferFinished) != VK_SUCCESS ||
+            vkCreateFence(*logicalDevice, &fenceInfo, nullptr, &upload.fence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create upload synchronisation objects!");
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &upload.transferCommandBuffer;
+    submitInfo.signalSemaphoreCount = ownershiptransfer ? 1 : 0;
+    submitInfo.pSignalSemaphores = &upload.transferFinished;
+    if (vkQueueSubmit(transferQueue, 1, &submitInfo, upload.fence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit mesh upload!");
+    pendingUploads.push_back(upload);
+    return upload.mesh;
+}
+
+uint32_t LogicalDevice::addComputeMesh(const std::string & shadername, uint32_t vertexcount, uint32_t indexcount){
+    if (!(flag & USING_GRAPHICS_POOL) || computeCommandPool == VK_NULL_HANDLE)
+        throw std::runtime_error("Compute meshes need a logical device with graphics and compute queues!");
+    if (!vertexcount || !indexcount)
+        throw std::runtime_error("Empty mesh passed to addComputeMesh!");
+    auto pipeline = std::find_if(computePipelines.begin(), computePipelines.end(), [&](const ComputePipeline & computepipeline){
+        return computepipeline.getName() == shadername;
+    });
+    if (pipeline == computePipelines.end())
+        throw std::runtime_error(std::string("No compute shader named ") + shadername + std::string("!"));
+
+    //The mesh is written on the GPU every frame, so there's nothing to upload...
+    ComputeMesh computemesh = {};
+    computemesh.pipeline = static_cast<uint32_t>(pipeline - computePipelines.begin());
+    computemesh.mesh = static_cast<uint32_t>(meshes.size());
+    computemesh.descriptorSet = VK_NULL_HANDLE;
+    computemesh.vertexCount = vertexcount;
+    computemesh.indexCount = indexcount;
+    meshes.push_back(Mesh());
+    meshes.back().buffer = VK_NULL_HANDLE;
+    createComputeMeshBuffer(computemesh);
+    computeMeshes.push_back(computemesh);
+    graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+    return computemesh.mesh;
+}
+
+void LogicalDevice::createComputeMeshBuffer(ComputeMesh & computemesh){
+    //Each swapchain image gets its own copy of the vertices and indices, so compute for the next frame
+    //never writes what the previous frame is still drawing. Copies must start on a storage buffer offset boundary...
+    auto alignment = (std::max)(minStorageBufferOffsetAlignment, static_cast<VkDeviceSize>(sizeof(uint32_t)));
+    auto align = [&](VkDeviceSize size){ return (size + alignment - 1) / alignment * alignment; };
+    auto vertexsize = align(computemesh.vertexCount * sizeof(Vertex));
+    auto indexsize = align(computemesh.indexCount * sizeof(uint32_t));
+    computemesh.frameCount = static_cast<uint32_t>(swapChain.getSwapChainFramebuffersCount());
+
+    //Shared between the compute and graphics families rather than transferring ownership twice a frame...
+    uint32_t families[] = {computeQueueFamilyIndex, graphicsQueueFamilyIndex};
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = (vertexsize + indexsize) * computemesh.frameCount;
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    if (computeQueueFamilyIndex != graphicsQueueFamilyIndex){
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = families;
+    }else{
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+    VkBuffer buffer;
+    if (vkCreateBuffer(*logicalDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create compute mesh buffer!");
+
+    //Replace the old buffer if the swapchain grew, keeping the mesh's uniforms, constants and variant...
+    auto & mesh = meshes[computemesh.mesh];
+    auto replaced = Mesh(buffer, memoryAllocator->allocateBuffer(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), vertexsize, computemesh.indexCount, vertexsize + indexsize);
+    if (mesh.buffer != VK_NULL_HANDLE){
+        vkDestroyBuffer(*logicalDevice, mesh.buffer, nullptr);
+        memoryAllocator->free(mesh.allocation);
+        replaced.uniforms = mesh.uniforms;
+        replaced.constants = mesh.constants;
+        replaced.pipeline = mesh.pipeline;
+    }
+    mesh = replaced;
+    mesh.ready = true;
+
+    //Dynamic offsets pick the frame's copy, so one descriptor set covers them all...
+    std::vector <VkDescriptorBufferInfo> buffers = {
+        {buffer, 0, vertexsize},
+        {buffer, vertexsize, indexsize}
+    };
+    auto & pipeline = computePipelines[computemesh.pipeline];
+    if (computemesh.descriptorSet == VK_NULL_HANDLE)
+        computemesh.descriptorSet = pipeline.allocateDescriptorSet(*staticDescriptors, buffers);
+    else
+        pipeline.updateDescriptorSet(computemesh.descriptorSet, buffers);
+}
+
+void LogicalDevice::createComputeCommandBuffers(){
+    destroyComputeCommandBuffers();
+
+    //One command buffer and semaphore per swapchain image, both are free again once the image's fence has signalled...
+    computeCommandBuffers.resize(swapChain.getSwapChainFramebuffersCount());
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = computeCommandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(computeCommandBuffers.size());
+    if (vkAllocateCommandBuffers(*logicalDevice, &allocInfo, computeCommandBuffers.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate compute command buffers!");
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    computeFinishedSemaphores.resize(computeCommandBuffers.size(), VK_NULL_HANDLE);
+    for (auto & semaphore : computeFinishedSemaphores){
+        if (vkCreateSemaphore(*logicalDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create compute semaphore!");
+    }
+
+    //Compute meshes and the indirect draw lists need a copy for every image...
+    for (auto & computemesh : computeMeshes){
+        if (computemesh.frameCount < computeCommandBuffers.size())
+            createComputeMeshBuffer(computemesh);
+    }
+    indirectDraws.createDrawBuffers(static_cast<uint32_t>(computeCommandBuffers.size()), *staticDescriptors);
+}
+
+void LogicalDevice::destroyComputeCommandBuffers() noexcept{
+    if (!computeCommandBuffers.empty())
+        vkFreeCommandBuffers(*logicalDevice, computeCommandPool, static_cast<uint32_t>(computeCommandBuffers.size()), computeCommandBuffers.data());
+    for (auto semaphore : computeFinishedSemaphores)
+        vkDestroySemaphore(*logicalDevice, semaphore, nullptr);
+    computeCommandBuffers.clear();
+    computeFinishedSemaphores.clear();
+}
+
+VkSemaphore LogicalDevice::submitCompute(uint32_t imageindex){
+    if (computeMeshes.empty() && !gpuDriven)
+        return VK_NULL_HANDLE;
+
+    //The graphics submission that waited on this buffer's last run has retired, so it can be reset...
+    auto & buffer = computeCommandBuffers[imageindex];
+    vkResetCommandBuffer(buffer, 0);
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(buffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failed to record compute command buffer!");
+    auto time = std::chrono::duration<float>(std::chrono::steady_clock::now() - computeStartTime).count();
+    for (const auto & computemesh : computeMeshes){
+        auto offset = static_cast<uint32_t>(imageindex * meshes[computemesh.mesh].frameStride);
+        ComputeParameters parameters = {time, computemesh.vertexCount, computemesh.indexCount};
+        computePipelines[computemesh.pipeline].dispatch(
+                    buffer,
+                    computemesh.descriptorSet,
+                    {offset, offset},
+                    (computemesh.vertexCount + COMPUTE_WORKGROUP_SIZE - 1) / COMPUTE_WORKGROUP_SIZE,
+                    &parameters
+                    );
+    }
+    if (gpuDriven)
+        indirectDraws.recordCull(buffer, imageindex);
+    if (vkEndCommandBuffer(buffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to record compute command buffer!");
+
+    //No fence, the frame's graphics submission waits on the semaphore and its fence covers both...
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &buffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &computeFinishedSemaphores[imageindex];
+    if (vkQueueSubmit(computeQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit compute work!");
+    return computeFinishedSemaphores[imageindex];
+}
+
+void LogicalDevice::processUploads(){
+    for (auto i = 0U; i < pendingUploads.size();){
+        auto & upload = pendingUploads[i];
+        if (vkGetFenceStatus(*logicalDevice, upload.fence) != VK_SUCCESS){
+            i++;
+            continue;
+        }
+
+        //The copy has landed; on another family the graphics queue still has to acquire the buffer...
+        if (!upload.acquiring && transferQueueFamilyIndex != graphicsQueueFamilyIndex){
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = graphicsCommandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(*logicalDevice, &allocInfo, &upload.acquireCommandBuffer) != VK_SUCCESS)
+                throw std::runtime_error("Failed to allocate acquire command buffer!");
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            if (vkBeginCommandBuffer(upload.acquireCommandBuffer, &beginInfo) != VK_SUCCESS)
+                throw std::runtime_error("Failed to begin recording command buffer!");
+            VkBufferMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+            barrier.srcQueueFamilyIndex = transferQueueFamilyIndex;
+            barrier.dstQueueFamilyIndex = graphicsQueueFamilyIndex;
+            barrier.buffer = meshes[upload.mesh].buffer;
+            barrier.offset = upload.offset;
+            barrier.size = upload.size;
+            vkCmdPipelineBarrier(
+                        upload.acquireCommandBuffer,
+                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                        0, 0, nullptr, 1, &barrier, 0, nullptr
+                        );
+            if (vkEndCommandBuffer(upload.acquireCommandBuffer) != VK_SUCCESS)
+                throw std::runtime_error("Failed to record acquire command buffer!");
+
+            //Frames submitted after this are ordered behind the acquire on the same queue...
+            vkResetFences(*logicalDevice, 1, &upload.fence);
+            VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            VkSubmitInfo submitInfo = {};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &upload.transferFinished;
+            submitInfo.pWaitDstStageMask = &waitStage;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &upload.acquireCommandBuffer;
+            if (vkQueueSubmit(graphicsQueues.front(), 1, &submitInfo, upload.fence) != VK_SUCCESS)
+                throw std::runtime_error("Failed to submit mesh acquire!");
+            upload.acquiring = true;
+            setMeshReady(upload.mesh);
+            i++;
+            continue;
+        }
+
+        //Everything has retired, the mesh is drawable and the staging resources can go...
+        if (!meshes[upload.mesh].ready)
+            setMeshReady(upload.mesh);
+        destroyUpload(upload);
+        pendingUploads.erase(pendingUploads.begin() + i);
+    }
+}
+
+void LogicalDevice::setMeshReady(uint32_t mesh){
+    //Pooled meshes also join the GPU driven draw list...
+    meshes[mesh].ready = true;
+    if (meshes[mesh].pooled)
+        indirectDraws.addObject(meshes[mesh]);
+    graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+}
+
+void LogicalDevice::setMeshUniforms(uint32_t mesh, const MeshUniforms & uniforms){
+    if (mesh >= meshes.size())
+        throw std::runtime_error("Invalid mesh index!");
+
+    //Picked up by the next frame's copy into the ring, nothing needs re-recording...
+    meshes[mesh].uniforms = uniforms;
+}
+
+void LogicalDevice::setMeshConstants(uint32_t mesh, const DrawConstants & constants){
+    if (mesh >= meshes.size())
+        throw std::runtime_error("Invalid mesh index!");
+
+    //Push constants are baked into the recorded buffers...
+    meshes[mesh].constants = constants;
+    graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+}
+
+std::vector<uint32_t> LogicalDevice::addPipelineVariants(const std::vector<PipelineState> & states){
+    if (!(flag & USING_GRAPHICS_POOL))
+        throw std::runtime_error("Pipeline variants need a logical device with graphics queues!");
+
+    //A reload in progress was copied without the new variants, so it's settled first...
+    if (swapChain.finishShaderReload(true))
+        graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+    return swapChain.graphicsPipeline.addVariants(states);
+}
+
+void LogicalDevice::setMeshPipeline(uint32_t mesh, uint32_t variant){
+    if (mesh >= meshes.size())
+        throw std::runtime_error("Invalid mesh index!");
+    if (variant >= swapChain.graphicsPipeline.getVariantCount())
+        throw std::runtime_error("Invalid pipeline variant!");
+    meshes[mesh].pipeline = variant;
+    graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+}
+
+void LogicalDevice::setDepthMode(GraphicsPipeline::DepthMode depthmode, VkFormat depthformat){
+    if (!(flag & USING_GRAPHICS_POOL))
+        throw std::runtime_error("Depth testing needs a logical device with graphics queues!");
+    swapChain.setDepthMode(depthmode, depthformat);
+    graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+}
+
+GraphicsPipeline::DepthMode LogicalDevice::getDepthMode() const noexcept{
+    return swapChain.graphicsPipeline.getDepthMode();
+}
+
+VkFormat LogicalDevice::getDepthFormat() const noexcept{
+    return swapChain.graphicsPipeline.getDepthFormat();
+}
+
+void LogicalDevice::setSampleCount(VkSampleCountFlagBits samplecount){
+    if (!(flag & USING_GRAPHICS_POOL))
+        throw std::runtime_error("Multisampling needs a logical device with graphics queues!");
+    swapChain.setSampleCount(samplecount);
+    graphicsCommandBuffersDirty.assign(graphicsCommandBuffers.size(), true);
+}
+
+VkSampleCountFlagBits LogicalDevice::getSampleCount() const noexcept{
+    return swapChain.graphicsPipeline.getSampleCount();
+}
+
+VkSampleCountFlags LogicalDevice::getSupportedSampleCounts() const{
+    return swapChain.getSupportedSampleCounts();
+}
+
+RenderGraph::MemoryStatistics LogicalDevice::getTransientMemoryStatistics() const{
+    if (!(flag & USING_GRAPHICS_POOL))
+        throw std::runtime_error("Only logical devices with graphics queues have transient attachments!");
+    return swapChain.graphicsPipeline.getRenderGraph().getMemoryStatistics();
+}
+
+std::unique_ptr<RenderGraph> LogicalDevice::createRenderGraph() const{
+    //The caller cleans the graph up before this device goes...
+    return std::make_unique<RenderGraph>(logicalDevice);
+}
+
+void LogicalDevice::destroyUpload(const PendingUpload & upload) noexcept{
+    vkDestroyBuffer(*logicalDevice, upload.stagingBuffer, nullptr);
+    memoryAllocator->free(upload.stagingAllocation);
+    vkFreeCommandBuffers(*logicalDevice, transferCommandPool, 1, &upload.transferCommandBuffer);
+    if (upload.acquireCommandBuffer != VK_NULL_HANDLE)
+        vkFreeCommandBuffers(*logicalDevice, graphicsCommandPool, 1, &upload.acquireCommandBuffer);
+    vkDestroySemaphore(*logicalDevice, upload.transferFinished, nullptr);
+    vkDestroyFence(*logicalDevice, upload.fence, nullptr);
+}
+
+void LogicalDevice::setFramesInFlight(uint32_t framesinflight){
+    swapChain.setFramesInFlight(framesinflight);
+}
+
+uint32_t LogicalDevice::getFramesInFlight() const noexcept{
+    return swapChain.getFramesInFlight();
+}
+
+void LogicalDevice::setPresentMode(VkPresentModeKHR presentmode, uint32_t imagecount) noexcept{
+    //Applied by the next frame's recreation, like a resize...
+    if (swapChain.setPresentMode(presentmode, imagecount))
+        swapChainStale = true;
+}
+
+const FrameStatistics & LogicalDevice::getPresentStatistics() const noexcept{
+    return swapChain.presentStatistics;
+}
+
+const FrameStatistics & LogicalDevice::getFenceWaitStatistics() const noexcept{
+    return swapChain.fenceWaitStatistics;
+}
+
+const TimestampQueryPool & LogicalDevice::getTimestampQueryPool() const noexcept{
+    return swapChain.timestampQueryPool;
+}
+
+bool LogicalDevice::wasPipelineCacheLoaded() const noexcept{
+    return pipelineCache.wasLoadedFromDisk();
+}
+
+std::vector<DeviceMemoryAllocator::HeapStatistics> LogicalDevice::getMemoryStatistics() const{
+    return memoryAllocator->getHeapStatistics();
+}
+
+void LogicalDevice::resetStatistics(size_t windowsize){
+    swapChain.timestampQueryPool.resetStatistics(windowsize);
+    swapChain.presentStatistics.reset(windowsize);
+    swapChain.fenceWaitStatistics.reset(windowsize);
+    swapChain.presented = false;
+    recordingStatistics.reset(windowsize);
 }
 
 void LogicalDevice::cleanup() noexcept{
+    //Nothing can be destroyed while the GPU may still be using it...
+    shaderWatcher.reset();
+    vkDeviceWaitIdle(*logicalDevice);
+    for (const auto & upload : pendingUploads)
+        destroyUpload(upload);
+    for (const auto & mesh : meshes){
+        if (!mesh.pooled)
+            vkDestroyBuffer(*logicalDevice, mesh.buffer, nullptr);
+    }
+    if (flag & USING_GRAPHICS_POOL){
+        indirectDraws.cleanup();
+        uniformRing.cleanup();
+        vkDestroyCommandPool(*logicalDevice, transferCommandPool, nullptr);
+    }
     swapChain.cleanup();
+    pipelineCache.cleanup();
+    for (auto & allocator : frameDescriptors)
+        allocator.cleanup();
+    if (memoryAllocator)
+        memoryAllocator->cleanup();
+    destroySecondaryCommandPools();
     if (flag & USING_GRAPHICS_POOL)
         vkDestroyCommandPool(*logicalDevice, graphicsCommandPool, nullptr);
-    /*if (flag & USING_COMPUTE_POOL)
-        vkDestroyCommandPool(*logicalDevice, computeCommandPool, nullptr);*/
+    if (computeCommandPool != VK_NULL_HANDLE){
+        destroyComputeCommandBuffers();
+        vkDestroyCommandPool(*logicalDevice, computeCommandPool, nullptr);
+    }
+    for (auto & pipeline : computePipelines)
+        pipeline.cleanup();
+
+    //Layouts go last, once every pipeline layout and set made from them is gone...
+    if (staticDescriptors)
+        staticDescriptors->cleanup();
+    if (descriptorLayouts)
+        descriptorLayouts->cleanup();
 }
 
 
@@ -2,6 +2,14 @@
 #define LOGICALDEVICE_H
 
 #include "swapchain.h"
+#include "pipelinecache.h"
+#include "threadpool.h"
+#include "framestatistics.h"
+#include "computepipeline.h"
+#include "shaderwatcher.h"
+#include "indirectdrawlist.h"
+#include "uniformringbuffer.h"
+#include <chrono>
 #include "src/utility.h"
 
 class LogicalDevice final
@@ -11,14 +19,50 @@ private:
     enum Flag {
         USING_GRAPHICS_POOL = 0b00000001,
         USING_COMPUTE_POOL = 0b00000010,
+        USING_TRANSFER_POOL = 0b00000100,
         USING_NONE = 0b00000000
     };
+    struct PendingUpload final
+    {
+        uint32_t mesh;
+        VkBuffer stagingBuffer;
+        DeviceMemoryAllocator::Allocation stagingAllocation;
+        VkCommandBuffer transferCommandBuffer;
+        VkCommandBuffer acquireCommandBuffer;
+        VkSemaphore transferFinished;
+        VkFence fence;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        bool acquiring;
+    };
+    struct ComputeMesh final
+    {
+        uint32_t pipeline;
+        uint32_t mesh;
+        VkDescriptorSet descriptorSet;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t frameCount;
+    };
+    struct ComputeParameters final
+    {
+        float time;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+    };
 public:
     LogicalDevice(
             VkDevice *device,
+            VkPhysicalDevice physicaldevice,
             const QueueFamilyInfo & graphicsqueue,
             const QueueFamilyInfo & computequeue,
-            VkSwapchainCreateInfoKHR *swapchaincreateinfo
+            const QueueFamilyInfo & transferqueue,
+            VkSwapchainCreateInfoKHR *swapchaincreateinfo,
+            const VkPhysicalDeviceMemoryProperties & memoryproperties,
+            const VkPhysicalDeviceProperties & deviceproperties,
+            uint32_t timestampvalidbits,
+            const VkPhysicalDeviceFeatures & enabledfeatures,
+            bool drawindirectcount
             );
 public:
     LogicalDevice() = default;
@@ -29,20 +73,94 @@ private:
     void createGraphicsCommandBuffers(VkCommandPool *commandpool,
             bool createcommandpool = true
             );
-    void recreateSwapChain();
+    void recordGraphicsCommandBuffer(uint32_t imageindex);
+    void updateUniforms(uint32_t imageindex);
+    void createSecondaryCommandPools();
+    void destroySecondaryCommandPools() noexcept;
+    void setRecordingThreadCount(uint32_t threadcount);
+    [[nodiscard]] uint32_t getRecordingThreadCount() const noexcept;
+    void setRecordEveryFrame(bool recordeveryframe) noexcept;
+    [[nodiscard]] const FrameStatistics & getRecordingStatistics() const noexcept;
+    void setShaderHotReload(bool enable);
+    [[nodiscard]] bool isShaderHotReloadEnabled() const noexcept;
+    void setGpuDriven(bool gpudriven);
+    [[nodiscard]] bool isGpuDriven() const noexcept;
+    void requestSwapChainRecreation(VkExtent2D extent) noexcept;
+    [[nodiscard]] bool recreateSwapChain();
     void drawFrame();
+    [[nodiscard]] uint32_t addMesh(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices);
+    void processUploads();
+    void setMeshReady(uint32_t mesh);
+    void setMeshUniforms(uint32_t mesh, const MeshUniforms & uniforms);
+    void setMeshConstants(uint32_t mesh, const DrawConstants & constants);
+    [[nodiscard]] std::vector<uint32_t> addPipelineVariants(const std::vector<PipelineState> & states);
+    void setMeshPipeline(uint32_t mesh, uint32_t variant);
+    void setDepthMode(GraphicsPipeline::DepthMode depthmode, VkFormat depthformat = VK_FORMAT_UNDEFINED);
+    [[nodiscard]] GraphicsPipeline::DepthMode getDepthMode() const noexcept;
+    [[nodiscard]] VkFormat getDepthFormat() const noexcept;
+    void setSampleCount(VkSampleCountFlagBits samplecount);
+    [[nodiscard]] VkSampleCountFlagBits getSampleCount() const noexcept;
+    [[nodiscard]] VkSampleCountFlags getSupportedSampleCounts() const;
+    [[nodiscard]] RenderGraph::MemoryStatistics getTransientMemoryStatistics() const;
+    [[nodiscard]] std::unique_ptr<RenderGraph> createRenderGraph() const;
+    [[nodiscard]] uint32_t addComputeMesh(const std::string & shadername, uint32_t vertexcount, uint32_t indexcount);
+    void createComputeMeshBuffer(ComputeMesh & computemesh);
+    void createComputeCommandBuffers();
+    void destroyComputeCommandBuffers() noexcept;
+    [[nodiscard]] VkSemaphore submitCompute(uint32_t imageindex);
+    void destroyUpload(const PendingUpload & upload) noexcept;
+    void setFramesInFlight(uint32_t framesinflight);
+    [[nodiscard]] uint32_t getFramesInFlight() const noexcept;
+    void setPresentMode(VkPresentModeKHR presentmode, uint32_t imagecount) noexcept;
+    [[nodiscard]] const FrameStatistics & getPresentStatistics() const noexcept;
+    [[nodiscard]] const FrameStatistics & getFenceWaitStatistics() const noexcept;
+    [[nodiscard]] const TimestampQueryPool & getTimestampQueryPool() const noexcept;
+    [[nodiscard]] bool wasPipelineCacheLoaded() const noexcept;
+    [[nodiscard]] std::vector<DeviceMemoryAllocator::HeapStatistics> getMemoryStatistics() const;
+    void resetStatistics(size_t windowsize);
     void cleanup() noexcept;
 private:
     VkDevice *logicalDevice;
     std::vector <VkQueue> graphicsQueues;
     VkCommandPool graphicsCommandPool;
     std::vector <VkCommandBuffer> graphicsCommandBuffers;
+    std::vector <bool> graphicsCommandBuffersDirty;
+    std::shared_ptr <ThreadPool> recordingThreads;
+    std::vector <VkCommandPool> secondaryCommandPools;
+    std::vector <VkCommandBuffer> secondaryCommandBuffers;
+    uint32_t secondarySlotCount;
+    FrameStatistics recordingStatistics;
+    bool recordEveryFrame;
+    bool swapChainStale;
+    VkExtent2D requestedExtent;
+    std::shared_ptr <ShaderWatcher> shaderWatcher;
+    VkQueue transferQueue;
+    VkCommandPool transferCommandPool;
+    std::vector <Mesh> meshes;
+    std::vector <PendingUpload> pendingUploads;
+    IndirectDrawList indirectDraws;
+    bool gpuDriven;
+    UniformRingBuffer uniformRing;
+    std::vector <std::vector<uint32_t>> uniformOffsets;
+    std::vector <VkQueue> computeQueues;
+    VkQueue computeQueue;
+    VkCommandPool computeCommandPool;
+    std::vector <VkCommandBuffer> computeCommandBuffers;
+    std::vector <VkSemaphore> computeFinishedSemaphores;
+    std::vector <ComputePipeline> computePipelines;
+    std::vector <ComputeMesh> computeMeshes;
+    std::chrono::steady_clock::time_point computeStartTime;
+    VkDeviceSize minStorageBufferOffsetAlignment;
+    PipelineCache pipelineCache;
+    std::shared_ptr <DescriptorLayoutCache> descriptorLayouts;
+    std::shared_ptr <DescriptorAllocator> staticDescriptors;
+    std::vector <DescriptorAllocator> frameDescriptors;
+    std::shared_ptr <DeviceMemoryAllocator> memoryAllocator;
     SwapChain swapChain;
     Flag flag;
     uint32_t graphicsQueueFamilyIndex;
-    /*std::vector <VkQueue> computeQueues;
-    VkCommandPool computeCommandPool;
-    std::vector <VkCommandBuffer> computeCommandBuffers;*/
+    uint32_t transferQueueFamilyIndex;
+    uint32_t computeQueueFamilyIndex;
 };
 
 #endif // LOGICALDEVICE_H
@@ -0,0 +1,100 @@
+#include "mappedfile.h"
+#include <stdexcept>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*!
+        \class MappedFile
+        \brief The MappedFile class maps a whole file read only into memory for as long as it lives.
+
+        The data is page aligned, so SPIR-V words can be handed to vkCreateShaderModule straight from
+        the mapping without copying them into a buffer first. Empty files map to a null pointer and a
+        size of zero.
+*/
+
+MappedFile::MappedFile(const std::string & filepath)
+    : data(nullptr),
+      size(0),
+#ifdef _WIN32
+      file(INVALID_HANDLE_VALUE),
+      mapping(nullptr)
+#else
+      descriptor(-1)
+#endif
+{
+#ifdef _WIN32
+    file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to open file to map!");
+    LARGE_INTEGER filesize;
+    if (!GetFileSizeEx(file, &filesize)){
+        cleanup();
+        throw std::runtime_error("Failed to get size of file to map!");
+    }
+    size = static_cast<size_t>(filesize.QuadPart);
+    if (!size)
+        return;
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+        data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    descriptor = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+        throw std::runtime_error("Failed to open file to map!");
+    struct stat filestatus;
+    if (fstat(descriptor, &filestatus) != 0){
+        cleanup();
+        throw std::runtime_error("Failed to get size of file to map!");
+    }
+    size = static_cast<size_t>(filestatus.st_size);
+    if (!size)
+        return;
+    auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (address != MAP_FAILED){
+        data = static_cast<const char*>(address);
+
+        //The whole file is about to be read, so start paging it in now...
+        madvise(address, size, MADV_WILLNEED);
+    }
+#endif
+    if (!data){
+        cleanup();
+        throw std::runtime_error("Failed to map file!");
+    }
+}
+
+MappedFile::~MappedFile(){
+    cleanup();
+}
+
+const char * MappedFile::getData() const noexcept{
+    return data;
+}
+
+size_t MappedFile::getSize() const noexcept{
+    return size;
+}
+
+void MappedFile::cleanup() noexcept{
+#ifdef _WIN32
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (data)
+        munmap(const_cast<char*>(data), size);
+    if (descriptor >= 0)
+        close(descriptor);
+    descriptor = -1;
+#endif
+    data = nullptr;
+}
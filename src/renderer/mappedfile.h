@@ -0,0 +1,36 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+#include <string>
+#include <cstddef>
+
+class MappedFile final
+{
+public:
+    MappedFile(const std::string & filepath);
+    ~MappedFile();
+public:
+    MappedFile(const MappedFile & other) = delete;
+    MappedFile & operator=(const MappedFile & other) = delete;
+    MappedFile(const MappedFile && other) = delete;
+    MappedFile & operator=(const MappedFile && other) = delete;
+public:
+    [[nodiscard]] const char * getData() const noexcept;
+    [[nodiscard]] size_t getSize() const noexcept;
+private:
+    void cleanup() noexcept;
+private:
+    const char *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int descriptor;
+#endif
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,77 @@
+#include "mesh.h"
+#include <cstddef>
+
+/*!
+        \class Mesh
+        \brief The Mesh class is an indexed triangle list living in one device local buffer.
+
+        Vertices sit at the start of the buffer and 32 bit indices follow them at indexOffset, so a mesh
+        needs one allocation and one copy to upload. A mesh isn't drawn until ready is set, which happens
+        once its upload has been handed over to the graphics queue.
+
+        Meshes written by the GPU every frame, such as compute generated ones, keep one copy of their vertices
+        and indices per swapchain image. frameStride is the distance between those copies, and record() draws
+        the copy belonging to the frame it is given.
+
+        Static meshes may instead be packed into a buffer shared with other meshes, starting at bufferOffset.
+        Pooled meshes keep a bounding circle (centre xyz, radius) so the GPU driven path can cull them.
+
+        uniforms is per object data that may change every frame, an xy offset and a scale, and is copied into
+        the uniform ring buffer each frame. constants is a colour that is pushed when the draw is recorded,
+        so changing it means re-recording. pipeline picks the graphics pipeline variant the mesh is drawn with,
+        variant 0 being the default state.
+*/
+
+VkVertexInputBindingDescription Vertex::getBindingDescription() noexcept{
+    VkVertexInputBindingDescription bindingDescription = {};
+    bindingDescription.binding = 0;
+    bindingDescription.stride = sizeof(Vertex);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    return bindingDescription;
+}
+
+std::array<VkVertexInputAttributeDescription, 2> Vertex::getAttributeDescriptions() noexcept{
+    std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions = {};
+    attributeDescriptions[0].binding = 0;
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attributeDescriptions[0].offset = offsetof(Vertex, position);
+    attributeDescriptions[1].binding = 0;
+    attributeDescriptions[1].location = 1;
+    attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attributeDescriptions[1].offset = offsetof(Vertex, color);
+    return attributeDescriptions;
+}
+
+Mesh::Mesh(
+        VkBuffer meshbuffer,
+        const DeviceMemoryAllocator::Allocation & meshallocation,
+        VkDeviceSize indexoffset,
+        uint32_t indexcount,
+        VkDeviceSize framestride,
+        VkDeviceSize bufferoffset
+        )
+    : buffer(meshbuffer),
+      allocation(meshallocation),
+      indexOffset(indexoffset),
+      indexCount(indexcount),
+      frameStride(framestride),
+      bufferOffset(bufferoffset),
+      bounds{0.0f, 0.0f, 0.0f, 0.0f},
+      uniforms{{0.0f, 0.0f, 1.0f, 0.0f}},
+      constants{{1.0f, 1.0f, 1.0f, 1.0f}},
+      pipeline(0),
+      pooled(false),
+      ready(false)
+{
+    //
+}
+
+void Mesh::record(VkCommandBuffer commandbuffer, uint32_t frame) const noexcept{
+    if (!ready)
+        return;
+    VkDeviceSize offset = bufferOffset + frame * frameStride;
+    vkCmdBindVertexBuffers(commandbuffer, 0, 1, &buffer, &offset);
+    vkCmdBindIndexBuffer(commandbuffer, buffer, offset + indexOffset, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexed(commandbuffer, indexCount, 1, 0, 0, 0);
+}
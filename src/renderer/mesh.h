@@ -0,0 +1,59 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include "devicememoryallocator.h"
+#include "src/utility.h"
+
+struct Vertex final
+{
+    float position[3];
+    float color[3];
+
+    [[nodiscard]] static VkVertexInputBindingDescription getBindingDescription() noexcept;
+    [[nodiscard]] static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() noexcept;
+};
+
+struct MeshUniforms final
+{
+    float transform[4];
+};
+
+struct DrawConstants final
+{
+    float color[4];
+};
+
+class Mesh final
+{
+public:
+    Mesh(
+            VkBuffer meshbuffer,
+            const DeviceMemoryAllocator::Allocation & meshallocation,
+            VkDeviceSize indexoffset,
+            uint32_t indexcount,
+            VkDeviceSize framestride = 0,
+            VkDeviceSize bufferoffset = 0
+            );
+public:
+    Mesh() = default;
+    ~Mesh() = default;
+    Mesh(const Mesh & other) = default;
+    Mesh & operator=(const Mesh & other) = default;
+public:
+    void record(VkCommandBuffer commandbuffer, uint32_t frame = 0) const noexcept;
+public:
+    VkBuffer buffer;
+    DeviceMemoryAllocator::Allocation allocation;
+    VkDeviceSize indexOffset;
+    uint32_t indexCount;
+    VkDeviceSize frameStride;
+    VkDeviceSize bufferOffset;
+    float bounds[4];
+    MeshUniforms uniforms;
+    DrawConstants constants;
+    uint32_t pipeline;
+    bool pooled;
+    bool ready;
+};
+
+#endif // MESH_H
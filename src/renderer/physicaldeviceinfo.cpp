@@ -8,8 +8,8 @@
         \reentrant
 
         PhysicalDeviceInfo manages a physical device and stores it's supported features (such as geometry and tessellation shaders),
-        memory properties and device properties (such as vendor strings). It also crudely determines a score for the device by querying
-        it's limits which can be used to pick the strongest physical device to render on.
+        memory properties and device properties (such as vendor strings). Its score is filled in by a DeviceScorer and is used to pick
+        the strongest physical device to render on.
 */
 
 PhysicalDeviceInfo::PhysicalDeviceInfo(VkPhysicalDevice * device, VkInstance *instance)
@@ -30,122 +30,16 @@ PhysicalDeviceInfo::PhysicalDeviceInfo(VkPhysicalDevice * device, VkInstance *in
     vkGetPhysicalDeviceQueueFamilyProperties(*physicalDevice, &queuefamilypropertycount, nullptr);
     deviceQueueFamilyProperties.resize(queuefamilypropertycount);
     vkGetPhysicalDeviceQueueFamilyProperties(*physicalDevice, &queuefamilypropertycount, &deviceQueueFamilyProperties[0]);
+    uint32_t extensioncount = 0;
+    vkEnumerateDeviceExtensionProperties(*physicalDevice, nullptr, &extensioncount, nullptr);
+    extensionProperties.resize(extensioncount);
+    if (extensioncount && vkEnumerateDeviceExtensionProperties(*physicalDevice, nullptr, &extensioncount, extensionProperties.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failed to enumerate device extensions!");
+}
 
-    //Evaluate device score by tallying limits...
-    deviceScore += deviceProperties.limits.maxImageDimension1D;
-    deviceScore += deviceProperties.limits.maxImageDimension2D;
-    deviceScore += deviceProperties.limits.maxImageDimension3D;
-    deviceScore += deviceProperties.limits.maxImageDimensionCube;
-    deviceScore += deviceProperties.limits.maxImageArrayLayers;
-    deviceScore += deviceProperties.limits.maxTexelBufferElements;
-    deviceScore += deviceProperties.limits.maxUniformBufferRange;
-    deviceScore += deviceProperties.limits.maxStorageBufferRange;
-    deviceScore += deviceProperties.limits.maxPushConstantsSize;
-    deviceScore += deviceProperties.limits.maxMemoryAllocationCount;
-    deviceScore += deviceProperties.limits.maxSamplerAllocationCount;
-    //deviceScore += deviceProperties.limits.bufferImageGranularity;
-    //deviceScore += deviceProperties.limits.sparseAddressSpaceSize;
-    deviceScore += deviceProperties.limits.maxBoundDescriptorSets;
-    deviceScore += deviceProperties.limits.maxPerStageDescriptorSamplers;
-    deviceScore += deviceProperties.limits.maxPerStageDescriptorUniformBuffers;
-    deviceScore += deviceProperties.limits.maxPerStageDescriptorStorageBuffers;
-    deviceScore += deviceProperties.limits.maxPerStageDescriptorSampledImages;
-    deviceScore += deviceProperties.limits.maxPerStageDescriptorStorageImages;
-    deviceScore += deviceProperties.limits.maxPerStageDescriptorInputAttachments;
-    deviceScore += deviceProperties.limits.maxPerStageResources;
-    deviceScore += deviceProperties.limits.maxDescriptorSetSamplers;
-    deviceScore += deviceProperties.limits.maxDescriptorSetUniformBuffers;
-    deviceScore += deviceProperties.limits.maxDescriptorSetUniformBuffersDynamic;
-    deviceScore += deviceProperties.limits.maxDescriptorSetStorageBuffers;
-    deviceScore += deviceProperties.limits.maxDescriptorSetStorageBuffersDynamic;
-    deviceScore += deviceProperties.limits.maxDescriptorSetSampledImages;
-    deviceScore += deviceProperties.limits.maxDescriptorSetStorageImages;
-    deviceScore += deviceProperties.limits.maxDescriptorSetInputAttachments;
-    deviceScore += deviceProperties.limits.maxVertexInputAttributes;
-    deviceScore += deviceProperties.limits.maxVertexInputBindings;
-    deviceScore += deviceProperties.limits.maxVertexInputAttributeOffset;
-    deviceScore += deviceProperties.limits.maxVertexInputBindingStride;
-    deviceScore += deviceProperties.limits.maxVertexOutputComponents;
-    deviceScore += deviceProperties.limits.maxTessellationGenerationLevel;
-    deviceScore += deviceProperties.limits.maxTessellationPatchSize;
-    deviceScore += deviceProperties.limits.maxTessellationControlPerVertexInputComponents;
-    deviceScore += deviceProperties.limits.maxTessellationControlPerVertexOutputComponents;
-    deviceScore += deviceProperties.limits.maxTessellationControlPerPatchOutputComponents;
-    deviceScore += deviceProperties.limits.maxTessellationControlTotalOutputComponents;
-    deviceScore += deviceProperties.limits.maxTessellationEvaluationInputComponents;
-    deviceScore += deviceProperties.limits.maxTessellationEvaluationOutputComponents;
-    deviceScore += deviceProperties.limits.maxGeometryShaderInvocations;
-    deviceScore += deviceProperties.limits.maxGeometryInputComponents;
-    deviceScore += deviceProperties.limits.maxGeometryOutputComponents;
-    deviceScore += deviceProperties.limits.maxGeometryOutputVertices;
-    deviceScore += deviceProperties.limits.maxGeometryTotalOutputComponents;
-    deviceScore += deviceProperties.limits.maxFragmentInputComponents;
-    deviceScore += deviceProperties.limits.maxFragmentOutputAttachments;
-    deviceScore += deviceProperties.limits.maxFragmentDualSrcAttachments;
-    deviceScore += deviceProperties.limits.maxFragmentCombinedOutputResources;
-    deviceScore += deviceProperties.limits.maxComputeSharedMemorySize;
-    deviceScore += deviceProperties.limits.maxComputeWorkGroupCount[0];
-    deviceScore += deviceProperties.limits.maxComputeWorkGroupCount[1];
-    deviceScore += deviceProperties.limits.maxComputeWorkGroupCount[2];
-    deviceScore += deviceProperties.limits.maxComputeWorkGroupInvocations;
-    deviceScore += deviceProperties.limits.maxComputeWorkGroupSize[0];
-    deviceScore += deviceProperties.limits.maxComputeWorkGroupSize[1];
-    deviceScore += deviceProperties.limits.maxComputeWorkGroupSize[2];
-    deviceScore += deviceProperties.limits.subPixelPrecisionBits;
-    deviceScore += deviceProperties.limits.subTexelPrecisionBits;
-    deviceScore += deviceProperties.limits.mipmapPrecisionBits;
-    deviceScore += deviceProperties.limits.maxDrawIndexedIndexValue;
-    deviceScore += deviceProperties.limits.maxDrawIndirectCount;
-    //deviceScore += deviceProperties.limits.maxSamplerLodBias;
-    //deviceScore += deviceProperties.limits.maxSamplerAnisotropy;
-    deviceScore += deviceProperties.limits.maxViewports;
-    deviceScore += deviceProperties.limits.maxViewportDimensions[0];
-    deviceScore += deviceProperties.limits.maxViewportDimensions[1];
-    //deviceScore += deviceProperties.limits.viewportBoundsRange[0];
-    //deviceScore += deviceProperties.limits.viewportBoundsRange[1];
-    deviceScore += deviceProperties.limits.viewportSubPixelBits;
-    //deviceScore += deviceProperties.limits.minMemoryMapAlignment;
-    //deviceScore += deviceProperties.limits.minTexelBufferOffsetAlignment;
-    //deviceScore += deviceProperties.limits.minUniformBufferOffsetAlignment;
-    //deviceScore += deviceProperties.limits.minStorageBufferOffsetAlignment;
-    //deviceScore += deviceProperties.limits.minTexelOffset;
-    deviceScore += deviceProperties.limits.maxTexelOffset;
-    //deviceScore += deviceProperties.limits.minTexelGatherOffset;
-    deviceScore += deviceProperties.limits.maxTexelGatherOffset;
-    //deviceScore += deviceProperties.limits.minInterpolationOffset;
-    //deviceScore += deviceProperties.limits.maxInterpolationOffset;
-    deviceScore += deviceProperties.limits.subPixelInterpolationOffsetBits;
-    deviceScore += deviceProperties.limits.maxFramebufferWidth;
-    deviceScore += deviceProperties.limits.maxFramebufferHeight;
-    deviceScore += deviceProperties.limits.maxFramebufferLayers;
-    //deviceScore += deviceProperties.limits.framebufferColorSampleCounts;
-    //deviceScore += deviceProperties.limits.framebufferDepthSampleCounts;
-    //deviceScore += deviceProperties.limits.framebufferStencilSampleCounts;
-    //deviceScore += deviceProperties.limits.framebufferNoAttachmentsSampleCounts;
-    deviceScore += deviceProperties.limits.maxColorAttachments;
-    //deviceScore += deviceProperties.limits.sampledImageColorSampleCounts;
-    //deviceScore += deviceProperties.limits.sampledImageIntegerSampleCounts;
-    //deviceScore += deviceProperties.limits.sampledImageDepthSampleCounts;
-    //deviceScore += deviceProperties.limits.sampledImageStencilSampleCounts;
-    //deviceScore += deviceProperties.limits.storageImageSampleCounts;
-    deviceScore += deviceProperties.limits.maxSampleMaskWords;
-    //deviceScore += deviceProperties.limits.timestampComputeAndGraphics;
-    //deviceScore += deviceProperties.limits.timestampPeriod;
-    deviceScore += deviceProperties.limits.maxClipDistances;
-    deviceScore += deviceProperties.limits.maxCullDistances;
-    deviceScore += deviceProperties.limits.maxCombinedClipAndCullDistances;
-    deviceScore += deviceProperties.limits.discreteQueuePriorities;
-    //deviceScore += deviceProperties.limits.pointSizeRange[0];
-    //deviceScore += deviceProperties.limits.pointSizeRange[1];
-    //deviceScore += deviceProperties.limits.lineWidthRange[0];
-    //deviceScore += deviceProperties.limits.lineWidthRange[1];
-    //deviceScore += deviceProperties.limits.pointSizeGranularity;
-    //deviceScore += deviceProperties.limits.lineWidthGranularity;
-    //deviceScore += deviceProperties.limits.strictLines;
-    //deviceScore += deviceProperties.limits.standardSampleLocations;
-    //deviceScore += deviceProperties.limits.optimalBufferCopyOffsetAlignment;
-    //deviceScore += deviceProperties.limits.optimalBufferCopyRowPitchAlignment;
-    //deviceScore += deviceProperties.limits.nonCoherentAtomSize;
+void PhysicalDeviceInfo::scoreDevice(const DeviceScorer & scorer){
+    //Measured, or read back from a previous run's measurement...
+    deviceScore = scorer.getScore(*physicalDevice, deviceProperties, deviceMemoryProperties, deviceQueueFamilyProperties);
 }
 
 void PhysicalDeviceInfo::addLogicalDevice(VkDeviceCreateInfo * devicecreateinfo, VkSurfaceKHR & surface, uint32_t graphicsqueuecount, uint32_t computequeuecount, VkSwapchainCreateInfoKHR *swapchaincreateinfo){
@@ -159,39 +53,61 @@ void PhysicalDeviceInfo::addLogicalDevice(VkDeviceCreateInfo * devicecreateinfo,
     if (missingfeatures != "")
         throw std::runtime_error(missingfeatures);
 
+    //Logical devices keep a pointer to their VkDevice, so the vector is sized once and never reallocates...
+    if (logicalDevices.size() >= MAX_NUM_LOGICAL_DEVICES_PER_PHYSICAL_DEVICE_ALLOWED)
+        throw std::runtime_error("This physical device already has the maximum number of logical devices!");
+    logicalDevices.reserve(MAX_NUM_LOGICAL_DEVICES_PER_PHYSICAL_DEVICE_ALLOWED);
+    logicalDeviceInfos.reserve(MAX_NUM_LOGICAL_DEVICES_PER_PHYSICAL_DEVICE_ALLOWED);
+
     //Create logical device and store it's creation info...
     logicalDevices.resize(logicalDevices.size() + 1);
-    if (vkCreateDevice(*physicalDevice, devicecreateinfo, nullptr, &logicalDevices.back()) != VK_SUCCESS)
+    if (vkCreateDevice(*physicalDevice, devicecreateinfo, nullptr, &logicalDevices.back()) != VK_SUCCESS){
+        logicalDevices.pop_back();
         throw std::runtime_error("Failed to create logical device!");
+    }
 
-    //Use different queue families for graphics and compute...
+    //Use different queue families for graphics and compute where possible...
     auto graphicsqueueinfo = getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT);
-    int graphicsindex;
-    graphicsqueueinfo.queueCount ? graphicsindex = static_cast<int>(graphicsqueueinfo.queueFamilyIndex) : graphicsindex = -1;
-    auto computequeueinfo = getQueueFamilyIndex(VK_QUEUE_COMPUTE_BIT, graphicsindex);
+    auto computequeueinfo = getComputeQueueFamilyIndex(graphicsqueuecount, computequeuecount);
 
-    //If graphics queues are requested check for presentation support...
-    if (graphicsqueuecount > 0){
+    //A transfer only family (usually a DMA engine) takes uploads off the graphics queue if there is one...
+    auto transferqueueinfo = getQueueFamilyIndex(VK_QUEUE_TRANSFER_BIT, -1, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+
+    //If graphics queues are requested check for presentation support (headless devices never present)...
+    if (graphicsqueuecount > 0 && surface != VK_NULL_HANDLE){
         VkBool32 presentsupport = false;
         if (vkGetPhysicalDeviceSurfaceSupportKHR(*physicalDevice, graphicsqueueinfo.queueFamilyIndex, surface, &presentsupport) != VK_SUCCESS)
             throw std::runtime_error("The physical device does not support presentation!");
     }
 
+    //Indirect draws can take their count from the GPU if the extension was enabled...
+    auto drawindirectcount = false;
+    for (auto i = 0U; i < devicecreateinfo->enabledExtensionCount; i++){
+        if (!strcmp(devicecreateinfo->ppEnabledExtensionNames[i], VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+            drawindirectcount = true;
+    }
+
     //Set requested number of queues and initialise device info...
     logicalDeviceInfos.push_back(
                 LogicalDevice(
                     &logicalDevices.back(),
+                    *physicalDevice,
                     QueueFamilyInfo(graphicsqueueinfo.queueFamilyIndex, graphicsqueuecount),
-                    QueueFamilyInfo(computequeueinfo.queueFamilyIndex, computequeuecount),
-                    swapchaincreateinfo
+                    computequeueinfo,
+                    QueueFamilyInfo(transferqueueinfo.queueFamilyIndex, transferqueueinfo.queueCount ? 1 : 0),
+                    swapchaincreateinfo,
+                    deviceMemoryProperties,
+                    deviceProperties,
+                    graphicsqueueinfo.queueCount ? deviceQueueFamilyProperties[graphicsqueueinfo.queueFamilyIndex].timestampValidBits : 0,
+                    *devicecreateinfo->pEnabledFeatures,
+                    drawindirectcount
                     )
                 );
 }
 
-void PhysicalDeviceInfo::recreateSwapChain(uint32_t logicaldeviceindex) noexcept{
-    //Wait for the device to finish it's pending tasks before recreating the swapchain...
-    vkDeviceWaitIdle(logicalDevices[logicaldeviceindex]);
-    logicalDeviceInfos[logicaldeviceindex].recreateSwapChain();
+void PhysicalDeviceInfo::recreateSwapChain(uint32_t logicaldeviceindex, VkExtent2D extent) noexcept{
+    //Frames in flight keep the old swapchain alive, so there's no need to wait for the device...
+    logicalDeviceInfos[logicaldeviceindex].requestSwapChainRecreation(extent);
 }
 
 void PhysicalDeviceInfo::draw(uint32_t logicaldeviceindex){
@@ -199,6 +115,192 @@ void PhysicalDeviceInfo::draw(uint32_t logicaldeviceindex){
     logicalDeviceInfos[logicaldeviceindex].drawFrame();
 }
 
+uint32_t PhysicalDeviceInfo::addMesh(uint32_t logicaldeviceindex, const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].addMesh(vertices, indices);
+}
+
+uint32_t PhysicalDeviceInfo::addComputeMesh(uint32_t logicaldeviceindex, const std::string & shadername, uint32_t vertexcount, uint32_t indexcount){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].addComputeMesh(shadername, vertexcount, indexcount);
+}
+
+void PhysicalDeviceInfo::setMeshUniforms(uint32_t logicaldeviceindex, uint32_t mesh, const MeshUniforms & uniforms){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setMeshUniforms(mesh, uniforms);
+}
+
+void PhysicalDeviceInfo::setMeshConstants(uint32_t logicaldeviceindex, uint32_t mesh, const DrawConstants & constants){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setMeshConstants(mesh, constants);
+}
+
+std::vector<uint32_t> PhysicalDeviceInfo::addPipelineVariants(uint32_t logicaldeviceindex, const std::vector<PipelineState> & states){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].addPipelineVariants(states);
+}
+
+void PhysicalDeviceInfo::setMeshPipeline(uint32_t logicaldeviceindex, uint32_t mesh, uint32_t variant){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setMeshPipeline(mesh, variant);
+}
+
+void PhysicalDeviceInfo::setDepthMode(uint32_t logicaldeviceindex, GraphicsPipeline::DepthMode depthmode, VkFormat depthformat){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setDepthMode(depthmode, depthformat);
+}
+
+GraphicsPipeline::DepthMode PhysicalDeviceInfo::getDepthMode(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getDepthMode();
+}
+
+VkFormat PhysicalDeviceInfo::getDepthFormat(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getDepthFormat();
+}
+
+void PhysicalDeviceInfo::setSampleCount(uint32_t logicaldeviceindex, VkSampleCountFlagBits samplecount){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setSampleCount(samplecount);
+}
+
+VkSampleCountFlagBits PhysicalDeviceInfo::getSampleCount(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getSampleCount();
+}
+
+VkSampleCountFlags PhysicalDeviceInfo::getSupportedSampleCounts(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getSupportedSampleCounts();
+}
+
+RenderGraph::MemoryStatistics PhysicalDeviceInfo::getTransientMemoryStatistics(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getTransientMemoryStatistics();
+}
+
+std::unique_ptr<RenderGraph> PhysicalDeviceInfo::createRenderGraph(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].createRenderGraph();
+}
+
+void PhysicalDeviceInfo::setFramesInFlight(uint32_t logicaldeviceindex, uint32_t framesinflight){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setFramesInFlight(framesinflight);
+}
+
+uint32_t PhysicalDeviceInfo::getFramesInFlight(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getFramesInFlight();
+}
+
+void PhysicalDeviceInfo::setPresentMode(uint32_t logicaldeviceindex, VkPresentModeKHR presentmode, uint32_t imagecount){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setPresentMode(presentmode, imagecount);
+}
+
+const FrameStatistics & PhysicalDeviceInfo::getPresentStatistics(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getPresentStatistics();
+}
+
+const FrameStatistics & PhysicalDeviceInfo::getFenceWaitStatistics(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getFenceWaitStatistics();
+}
+
+const TimestampQueryPool & PhysicalDeviceInfo::getTimestampQueryPool(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getTimestampQueryPool();
+}
+
+void PhysicalDeviceInfo::resetStatistics(uint32_t logicaldeviceindex, size_t windowsize){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].resetStatistics(windowsize);
+}
+
+void PhysicalDeviceInfo::setRecordingThreadCount(uint32_t logicaldeviceindex, uint32_t threadcount){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setRecordingThreadCount(threadcount);
+}
+
+uint32_t PhysicalDeviceInfo::getRecordingThreadCount(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getRecordingThreadCount();
+}
+
+void PhysicalDeviceInfo::setRecordEveryFrame(uint32_t logicaldeviceindex, bool recordeveryframe){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setRecordEveryFrame(recordeveryframe);
+}
+
+void PhysicalDeviceInfo::setShaderHotReload(uint32_t logicaldeviceindex, bool enable){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setShaderHotReload(enable);
+}
+
+bool PhysicalDeviceInfo::isShaderHotReloadEnabled(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].isShaderHotReloadEnabled();
+}
+
+void PhysicalDeviceInfo::setGpuDriven(uint32_t logicaldeviceindex, bool gpudriven){
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    logicalDeviceInfos[logicaldeviceindex].setGpuDriven(gpudriven);
+}
+
+bool PhysicalDeviceInfo::isGpuDriven(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].isGpuDriven();
+}
+
+const FrameStatistics & PhysicalDeviceInfo::getRecordingStatistics(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getRecordingStatistics();
+}
+
+bool PhysicalDeviceInfo::wasPipelineCacheLoaded(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].wasPipelineCacheLoaded();
+}
+
+std::vector<DeviceMemoryAllocator::HeapStatistics> PhysicalDeviceInfo::getMemoryStatistics(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return logicalDeviceInfos[logicaldeviceindex].getMemoryStatistics();
+}
+
 std::string PhysicalDeviceInfo::checkQueueProperties(VkQueueFlags requiredflags) const{
     std::string missingqueueproperties;
     VkQueueFlags supportedflags = 0;
@@ -216,16 +318,41 @@ std::string PhysicalDeviceInfo::checkQueueProperties(VkQueueFlags requiredflags)
     return missingqueueproperties;
 }
 
-QueueFamilyInfo PhysicalDeviceInfo::getQueueFamilyIndex(VkQueueFlags requiredflags, int indextoignore) const{
+bool PhysicalDeviceInfo::supportsExtension(const char *extension) const noexcept{
+    for (const auto & properties : extensionProperties){
+        if (!strcmp(properties.extensionName, extension))
+            return true;
+    }
+    return false;
+}
+
+QueueFamilyInfo PhysicalDeviceInfo::getQueueFamilyIndex(VkQueueFlags requiredflags, int indextoignore, VkQueueFlags excludedflags) const{
     uint32_t index = 0;
     for (const auto & queueproperties : deviceQueueFamilyProperties){
-        if ((requiredflags == (requiredflags & queueproperties.queueFlags)) && static_cast<uint32_t>(indextoignore) != index)
+        if ((requiredflags == (requiredflags & queueproperties.queueFlags)) && !(excludedflags & queueproperties.queueFlags) && static_cast<uint32_t>(indextoignore) != index)
             return QueueFamilyInfo(index, queueproperties.queueCount);
         index++;
     }
     return QueueFamilyInfo(0, 0);
 }
 
+QueueFamilyInfo PhysicalDeviceInfo::getComputeQueueFamilyIndex(uint32_t graphicsqueuecount, uint32_t computequeuecount) const{
+    //Prefer a compute only family, which is where async compute actually runs alongside graphics...
+    auto graphicsqueueinfo = getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT);
+    auto computeonlyinfo = getQueueFamilyIndex(VK_QUEUE_COMPUTE_BIT, -1, VK_QUEUE_GRAPHICS_BIT);
+    if (computeonlyinfo.queueCount)
+        return QueueFamilyInfo(computeonlyinfo.queueFamilyIndex, (std::min)(computequeuecount, computeonlyinfo.queueCount));
+    auto computequeueinfo = getQueueFamilyIndex(VK_QUEUE_COMPUTE_BIT, graphicsqueueinfo.queueCount ? static_cast<int>(graphicsqueueinfo.queueFamilyIndex) : -1);
+    if (computequeueinfo.queueCount)
+        return QueueFamilyInfo(computequeueinfo.queueFamilyIndex, (std::min)(computequeuecount, computequeueinfo.queueCount));
+
+    //Otherwise take whatever queues the graphics family has left, which may be none...
+    if (!graphicsqueueinfo.queueCount || !(deviceQueueFamilyProperties[graphicsqueueinfo.queueFamilyIndex].queueFlags & VK_QUEUE_COMPUTE_BIT))
+        return QueueFamilyInfo(0, 0);
+    auto sparequeues = graphicsqueueinfo.queueCount > graphicsqueuecount ? graphicsqueueinfo.queueCount - graphicsqueuecount : 0;
+    return QueueFamilyInfo(graphicsqueueinfo.queueFamilyIndex, (std::min)(computequeuecount, sparequeues));
+}
+
 std::string PhysicalDeviceInfo::checkFeatures(const VkPhysicalDeviceFeatures * requiredfeatures) const{
     std::string missingfeatures;
     auto checkfeature = [&](VkBool32 supported, VkBool32 required, const std::string & featurename){
@@ -296,11 +423,10 @@ void PhysicalDeviceInfo::cleanup() noexcept{
         device.cleanup();
 
     //Try to finish any current tasks...
-    auto result = VK_RESULT_RANGE_SIZE;
     for (auto device : logicalDevices){
-        result = vkDeviceWaitIdle(device);
-        if (result != VK_SUCCESS)
+        if (vkDeviceWaitIdle(device) != VK_SUCCESS){
             //TO DO: log("VkLogicalDevice failed to complete it's tasks when being destructed!");
+        }
         vkDestroyDevice(device, nullptr);
     }
 }
@@ -308,3 +434,9 @@ void PhysicalDeviceInfo::cleanup() noexcept{
 uint32_t PhysicalDeviceInfo::getLogicalDeviceCount() const noexcept{
     return static_cast<uint32_t>(logicalDevices.size());
 }
+
+bool PhysicalDeviceInfo::hasGraphicsQueues(uint32_t logicaldeviceindex) const{
+    if (logicaldeviceindex >= logicalDeviceInfos.size())
+        throw std::runtime_error("Invalid logical device index!");
+    return !logicalDeviceInfos[logicaldeviceindex].graphicsQueues.empty();
+}
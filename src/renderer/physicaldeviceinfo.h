@@ -6,11 +6,13 @@
 #include <string>
 
 #include "logicaldevice.h"
+#include "devicescorer.h"
 #include "src/utility.h"
 
 class PhysicalDeviceInfo final
 {
     friend class VulkanRenderer;
+    friend class RenderThread;
 public:
     PhysicalDeviceInfo(VkPhysicalDevice * device, VkInstance *instance);
 public:
@@ -19,6 +21,7 @@ public:
     PhysicalDeviceInfo(const PhysicalDeviceInfo & other) = default;
     PhysicalDeviceInfo & operator=(const PhysicalDeviceInfo & other) = default;
 private:
+    void scoreDevice(const DeviceScorer & scorer);
     void addLogicalDevice(
             VkDeviceCreateInfo *devicecreateinfo,
             VkSurfaceKHR &surface,
@@ -27,12 +30,46 @@ private:
             VkSwapchainCreateInfoKHR * swapchaincreateinfo
             );
     void draw(uint32_t logicaldeviceindex);
-    void recreateSwapChain(uint32_t logicaldeviceindex) noexcept;
+    [[nodiscard]] uint32_t addMesh(uint32_t logicaldeviceindex, const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices);
+    [[nodiscard]] uint32_t addComputeMesh(uint32_t logicaldeviceindex, const std::string & shadername, uint32_t vertexcount, uint32_t indexcount);
+    void setMeshUniforms(uint32_t logicaldeviceindex, uint32_t mesh, const MeshUniforms & uniforms);
+    void setMeshConstants(uint32_t logicaldeviceindex, uint32_t mesh, const DrawConstants & constants);
+    [[nodiscard]] std::vector<uint32_t> addPipelineVariants(uint32_t logicaldeviceindex, const std::vector<PipelineState> & states);
+    void setMeshPipeline(uint32_t logicaldeviceindex, uint32_t mesh, uint32_t variant);
+    void setDepthMode(uint32_t logicaldeviceindex, GraphicsPipeline::DepthMode depthmode, VkFormat depthformat);
+    [[nodiscard]] GraphicsPipeline::DepthMode getDepthMode(uint32_t logicaldeviceindex) const;
+    [[nodiscard]] VkFormat getDepthFormat(uint32_t logicaldeviceindex) const;
+    void setSampleCount(uint32_t logicaldeviceindex, VkSampleCountFlagBits samplecount);
+    [[nodiscard]] VkSampleCountFlagBits getSampleCount(uint32_t logicaldeviceindex) const;
+    [[nodiscard]] VkSampleCountFlags getSupportedSampleCounts(uint32_t logicaldeviceindex) const;
+    [[nodiscard]] RenderGraph::MemoryStatistics getTransientMemoryStatistics(uint32_t logicaldeviceindex) const;
+    [[nodiscard]] std::unique_ptr<RenderGraph> createRenderGraph(uint32_t logicaldeviceindex) const;
+    void recreateSwapChain(uint32_t logicaldeviceindex, VkExtent2D extent) noexcept;
+    void setFramesInFlight(uint32_t logicaldeviceindex, uint32_t framesinflight);
+    [[nodiscard]] uint32_t getFramesInFlight(uint32_t logicaldeviceindex) const;
+    void setPresentMode(uint32_t logicaldeviceindex, VkPresentModeKHR presentmode, uint32_t imagecount);
+    [[nodiscard]] const FrameStatistics & getPresentStatistics(uint32_t logicaldeviceindex) const;
+    [[nodiscard]] const FrameStatistics & getFenceWaitStatistics(uint32_t logicaldeviceindex) const;
+    [[nodiscard]] const TimestampQueryPool & getTimestampQueryPool(uint32_t logicaldeviceindex) const;
+    void resetStatistics(uint32_t logicaldeviceindex, size_t windowsize);
+    void setRecordingThreadCount(uint32_t logicaldeviceindex, uint32_t threadcount);
+    [[nodiscard]] uint32_t getRecordingThreadCount(uint32_t logicaldeviceindex) const;
+    void setRecordEveryFrame(uint32_t logicaldeviceindex, bool recordeveryframe);
+    void setShaderHotReload(uint32_t logicaldeviceindex, bool enable);
+    [[nodiscard]] bool isShaderHotReloadEnabled(uint32_t logicaldeviceindex) const;
+    void setGpuDriven(uint32_t logicaldeviceindex, bool gpudriven);
+    [[nodiscard]] bool isGpuDriven(uint32_t logicaldeviceindex) const;
+    [[nodiscard]] const FrameStatistics & getRecordingStatistics(uint32_t logicaldeviceindex) const;
+    [[nodiscard]] bool wasPipelineCacheLoaded(uint32_t logicaldeviceindex) const;
+    [[nodiscard]] std::vector<DeviceMemoryAllocator::HeapStatistics> getMemoryStatistics(uint32_t logicaldeviceindex) const;
     [[nodiscard]] constexpr uint64_t getDeviceScore() const noexcept{ return deviceScore; }
-    [[nodiscard]] QueueFamilyInfo getQueueFamilyIndex(VkQueueFlags requiredflags, int indextoignore = -1) const;
+    [[nodiscard]] QueueFamilyInfo getQueueFamilyIndex(VkQueueFlags requiredflags, int indextoignore = -1, VkQueueFlags excludedflags = 0) const;
+    [[nodiscard]] QueueFamilyInfo getComputeQueueFamilyIndex(uint32_t graphicsqueuecount, uint32_t computequeuecount) const;
     [[nodiscard]] std::string checkFeatures(const VkPhysicalDeviceFeatures *requiredfeatures) const;
     [[nodiscard]] std::string checkQueueProperties(VkQueueFlags requiredflags) const;
+    [[nodiscard]] bool supportsExtension(const char *extension) const noexcept;
     [[nodiscard]] uint32_t getLogicalDeviceCount() const noexcept;
+    [[nodiscard]] bool hasGraphicsQueues(uint32_t logicaldeviceindex) const;
     void cleanup() noexcept;
 private:
     VkInstance *vulkanInstance;
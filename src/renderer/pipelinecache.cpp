@@ -0,0 +1,137 @@
+#include "pipelinecache.h"
+
+/*!
+        \class PipelineCache
+        \brief The PipelineCache class keeps a VkPipelineCache on disk between runs.
+
+        There is one cache per logical device, shared by every pipeline created on it. The file is named
+        after the device's pipelineCacheUUID and starts with a small header of our own holding the driver
+        version, because the header Vulkan writes doesn't include it. When the cache is loaded, that header
+        and the Vulkan header's vendor ID, device ID and UUID must all match the current device, or the
+        file is ignored and the cache starts empty. The cache is written back to disk when the logical
+        device is cleaned up. A temporary file is renamed over the old one, so a crash can't leave a
+        half-written cache behind. Benchmarks point every cache at a directory of their own with
+        setCacheDirectory(), so timing a cold start doesn't throw away the caches a real run left.
+*/
+
+fs::path PipelineCache::cacheDirectory;
+
+PipelineCache::PipelineCache(VkDevice *device, const VkPhysicalDeviceProperties & deviceproperties)
+    : logicalDevice(device),
+      deviceProperties(deviceproperties),
+      pipelineCache(VK_NULL_HANDLE),
+      loadedFromDisk(false)
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to PipelineCache!");
+
+    //Seed the cache with whatever a previous run on this device and driver left behind...
+    auto data = loadCacheData();
+    loadedFromDisk = !data.empty();
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+    if (vkCreatePipelineCache(*logicalDevice, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS){
+        //A driver may still reject data it wrote itself, start cold rather than fail...
+        loadedFromDisk = false;
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = nullptr;
+        if (vkCreatePipelineCache(*logicalDevice, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create pipeline cache!");
+    }
+}
+
+VkPipelineCache PipelineCache::getPipelineCache() const noexcept{
+    return pipelineCache;
+}
+
+bool PipelineCache::wasLoadedFromDisk() const noexcept{
+    return loadedFromDisk;
+}
+
+void PipelineCache::save() const{
+    size_t datasize = 0;
+    if (vkGetPipelineCacheData(*logicalDevice, pipelineCache, &datasize, nullptr) != VK_SUCCESS)
+        throw std::runtime_error("Failed to get pipeline cache size!");
+    std::vector<char> data(datasize);
+    if (datasize && vkGetPipelineCacheData(*logicalDevice, pipelineCache, &datasize, data.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failed to get pipeline cache data!");
+
+    auto path = getCachePath();
+    fs::create_directories(path.parent_path());
+    auto temporarypath = path;
+    temporarypath += ".tmp";
+    {
+        std::ofstream file(temporarypath.u8string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open pipeline cache file!");
+        FileHeader header = {PIPELINE_CACHE_FILE_MAGIC, deviceProperties.driverVersion, static_cast<uint64_t>(datasize)};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(data.data(), static_cast<std::streamsize>(datasize));
+        if (!file)
+            throw std::runtime_error("Failed to write pipeline cache file!");
+    }
+    fs::rename(temporarypath, path);
+}
+
+void PipelineCache::setCacheDirectory(const fs::path & directory){
+    //Only caches created after this see the new directory, an empty path goes back to the default...
+    cacheDirectory = directory;
+}
+
+fs::path PipelineCache::getCachePath() const{
+    //Cache files sit next to the logs, one per pipelineCacheUUID...
+    static const char digits[] = "0123456789abcdef";
+    std::string name = "pipeline_";
+    for (auto byte : deviceProperties.pipelineCacheUUID){
+        name += digits[byte >> 4];
+        name += digits[byte & 0x0F];
+    }
+    name += ".bin";
+    if (!cacheDirectory.empty())
+        return cacheDirectory / name;
+    return fs::current_path().parent_path() / PIPELINE_CACHE_DIRECTORY / name;
+}
+
+std::vector<char> PipelineCache::loadCacheData() const{
+    std::ifstream file(getCachePath().u8string(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        return std::vector<char>();
+
+    //Our header first, a new driver may not understand an old driver's cache...
+    FileHeader header = {};
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        return std::vector<char>();
+    if (header.magic != PIPELINE_CACHE_FILE_MAGIC || header.driverVersion != deviceProperties.driverVersion)
+        return std::vector<char>();
+
+    //Then the header Vulkan wrote, which is headerSize, headerVersion, vendorID, deviceID, pipelineCacheUUID...
+    const size_t vulkanheadersize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+    if (header.dataSize < vulkanheadersize)
+        return std::vector<char>();
+    std::vector<char> data(static_cast<size_t>(header.dataSize));
+    if (!file.read(data.data(), static_cast<std::streamsize>(data.size())))
+        return std::vector<char>();
+    uint32_t vulkanheader[4];
+    std::memcpy(vulkanheader, data.data(), sizeof(vulkanheader));
+    if (vulkanheader[0] < vulkanheadersize ||
+            vulkanheader[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            vulkanheader[2] != deviceProperties.vendorID ||
+            vulkanheader[3] != deviceProperties.deviceID ||
+            std::memcmp(data.data() + sizeof(vulkanheader), deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        return std::vector<char>();
+    return data;
+}
+
+void PipelineCache::cleanup() noexcept{
+    if (pipelineCache == VK_NULL_HANDLE)
+        return;
+    try {
+        save();
+    } catch (...) {
+        //Losing the cache only costs the next run a cold start...
+    }
+    vkDestroyPipelineCache(*logicalDevice, pipelineCache, nullptr);
+    pipelineCache = VK_NULL_HANDLE;
+}
@@ -0,0 +1,40 @@
+#ifndef PIPELINECACHE_H
+#define PIPELINECACHE_H
+
+#include "src/utility.h"
+
+class PipelineCache final
+{
+    friend class LogicalDevice;
+private:
+    struct FileHeader final
+    {
+        uint32_t magic;
+        uint32_t driverVersion;
+        uint64_t dataSize;
+    };
+public:
+    PipelineCache(VkDevice *device, const VkPhysicalDeviceProperties & deviceproperties);
+public:
+    PipelineCache() = default;
+    ~PipelineCache() = default;
+    PipelineCache(const PipelineCache & other) = default;
+    PipelineCache & operator=(const PipelineCache & other) = default;
+public:
+    [[nodiscard]] VkPipelineCache getPipelineCache() const noexcept;
+    [[nodiscard]] bool wasLoadedFromDisk() const noexcept;
+    void save() const;
+    static void setCacheDirectory(const fs::path & directory);
+private:
+    [[nodiscard]] fs::path getCachePath() const;
+    [[nodiscard]] std::vector<char> loadCacheData() const;
+    void cleanup() noexcept;
+private:
+    VkDevice *logicalDevice;
+    VkPhysicalDeviceProperties deviceProperties;
+    VkPipelineCache pipelineCache;
+    bool loadedFromDisk;
+    static fs::path cacheDirectory;
+};
+
+#endif // PIPELINECACHE_H
@@ -0,0 +1,245 @@
+#include "pipelinestatecache.h"
+#include <algorithm>
+#include <functional>
+
+/*!
+        \class PipelineStateCache
+        \brief The PipelineStateCache class creates one graphics pipeline per distinct PipelineDescription.
+
+        A description covers everything baked into a pipeline: the shader modules, the vertex layout, the
+        raster, blend and depth state, the specialization constants, the colour attachment count, the sample
+        count, the pipeline layout and the render pass. Asking for a description that was asked for before
+        returns the same handle, so variants that turn out identical share one pipeline. New descriptions
+        are only queued by request(). createPending() then
+        builds everything queued with a single vkCreateGraphicsPipelines call through the pipeline cache,
+        which lets the driver compile them together.
+
+        Handles are indices, so getPipeline() is an array lookup that's safe to call from any number of
+        recording threads at once. request(), createPending() and cleanup() must not run while recording.
+        The viewport, scissor and line width are always dynamic, so pipelines don't depend on the extent.
+        Render passes are compared by handle rather than by compatibility. cleanup() destroys every
+        pipeline and forgets every description, ready for a new render pass or new shaders.
+*/
+
+bool PipelineState::operator==(const PipelineState & other) const noexcept{
+    return topology == other.topology && polygonMode == other.polygonMode && cullMode == other.cullMode &&
+            frontFace == other.frontFace && blendEnable == other.blendEnable && depthTestEnable == other.depthTestEnable &&
+            depthWriteEnable == other.depthWriteEnable && depthCompareOp == other.depthCompareOp && specialization == other.specialization;
+}
+
+bool PipelineDescription::operator==(const PipelineDescription & other) const noexcept{
+    if (shaderCount != other.shaderCount || vertexStride != other.vertexStride || vertexAttributeCount != other.vertexAttributeCount ||
+            !(state == other.state) || colorAttachmentCount != other.colorAttachmentCount || samples != other.samples || layout != other.layout || renderPass != other.renderPass || subpass != other.subpass)
+        return false;
+    if (!std::equal(shaders.begin(), shaders.begin() + shaderCount, other.shaders.begin()) ||
+            !std::equal(stages.begin(), stages.begin() + shaderCount, other.stages.begin()))
+        return false;
+    return std::equal(vertexAttributes.begin(), vertexAttributes.begin() + vertexAttributeCount, other.vertexAttributes.begin(), [](const VkVertexInputAttributeDescription & a, const VkVertexInputAttributeDescription & b){
+        return a.location == b.location && a.binding == b.binding && a.format == b.format && a.offset == b.offset;
+    });
+}
+
+size_t PipelineStateCache::DescriptionHash::operator()(const PipelineDescription & description) const noexcept{
+    //Only the used part of each array is mixed in, the rest may hold anything...
+    size_t hash = description.shaderCount;
+    auto mix = [&](uint64_t value){
+        hash ^= std::hash<uint64_t>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+    for (auto i = 0U; i < description.shaderCount; i++){
+        mix(reinterpret_cast<uint64_t>(description.shaders[i]));
+        mix(static_cast<uint64_t>(description.stages[i]));
+    }
+    mix(description.vertexStride);
+    for (auto i = 0U; i < description.vertexAttributeCount; i++){
+        const auto & attribute = description.vertexAttributes[i];
+        mix(static_cast<uint64_t>(attribute.location) | static_cast<uint64_t>(attribute.binding) << 16 | static_cast<uint64_t>(attribute.format) << 32);
+        mix(attribute.offset);
+    }
+    const auto & state = description.state;
+    mix(static_cast<uint64_t>(state.topology) | static_cast<uint64_t>(state.polygonMode) << 8 | static_cast<uint64_t>(state.cullMode) << 16 |
+        static_cast<uint64_t>(state.frontFace) << 24 | static_cast<uint64_t>(state.blendEnable) << 32 | static_cast<uint64_t>(state.depthTestEnable) << 33 |
+        static_cast<uint64_t>(state.depthWriteEnable) << 34 | static_cast<uint64_t>(state.depthCompareOp) << 40 | static_cast<uint64_t>(description.samples) << 48);
+    mix(state.specialization.getHash());
+    mix(description.colorAttachmentCount);
+    mix(reinterpret_cast<uint64_t>(description.layout));
+    mix(reinterpret_cast<uint64_t>(description.renderPass));
+    mix(description.subpass);
+    return hash;
+}
+
+PipelineStateCache::PipelineStateCache(VkDevice *device, VkPipelineCache pipelinecache)
+    : logicalDevice(device),
+      pipelineCache(pipelinecache)
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to PipelineStateCache!");
+}
+
+uint32_t PipelineStateCache::request(const PipelineDescription & description){
+    if (!description.shaderCount || description.shaderCount > PIPELINE_MAX_SHADER_STAGES || description.vertexAttributeCount > PIPELINE_MAX_VERTEX_ATTRIBUTES)
+        throw std::runtime_error("Invalid pipeline description!");
+    auto existing = handles.find(description);
+    if (existing != handles.end())
+        return existing->second;
+
+    //Created along with everything else requested before the next createPending()...
+    auto handle = static_cast<uint32_t>(descriptions.size());
+    handles.emplace(description, handle);
+    descriptions.push_back(description);
+    pipelines.push_back(VK_NULL_HANDLE);
+    pending.push_back(handle);
+    return handle;
+}
+
+void PipelineStateCache::createPending(){
+    if (pending.empty())
+        return;
+
+    //Every create info points into these, so they are sized up front and never reallocated...
+    auto count = pending.size();
+    std::vector <VkPipelineShaderStageCreateInfo> shaderStages(count * PIPELINE_MAX_SHADER_STAGES);
+    std::vector <VkSpecializationInfo> specializations(count);
+    std::vector <VkVertexInputBindingDescription> bindings(count);
+    std::vector <VkPipelineVertexInputStateCreateInfo> vertexInputs(count);
+    std::vector <VkPipelineInputAssemblyStateCreateInfo> inputAssemblies(count);
+    std::vector <VkPipelineRasterizationStateCreateInfo> rasterizers(count);
+    std::vector <VkPipelineMultisampleStateCreateInfo> multisamplings(count);
+    std::vector <VkPipelineDepthStencilStateCreateInfo> depthStencils(count);
+    std::vector <VkPipelineColorBlendAttachmentState> colorBlendAttachments(count);
+    std::vector <VkPipelineColorBlendStateCreateInfo> colorBlendings(count);
+    std::vector <VkGraphicsPipelineCreateInfo> pipelineInfos(count);
+
+    //Shared by every pipeline...
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+    VkDynamicState dynamicStates[] = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+        VK_DYNAMIC_STATE_LINE_WIDTH
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 3;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    for (auto i = 0U; i < count; i++){
+        const auto & description = descriptions[pending[i]];
+        //Every stage gets the same constants, a stage ignores ids it doesn't declare...
+        auto stages = shaderStages.data() + i * PIPELINE_MAX_SHADER_STAGES;
+        specializations[i] = description.state.specialization.getInfo();
+        for (auto j = 0U; j < description.shaderCount; j++){
+            stages[j].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stages[j].stage = description.stages[j];
+            stages[j].module = description.shaders[j];
+            stages[j].pName = "main";
+            stages[j].pSpecializationInfo = specializations[i].mapEntryCount ? &specializations[i] : nullptr;
+        }
+
+        bindings[i] = {0, description.vertexStride, VK_VERTEX_INPUT_RATE_VERTEX};
+        vertexInputs[i].sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputs[i].vertexBindingDescriptionCount = description.vertexStride ? 1 : 0;
+        vertexInputs[i].pVertexBindingDescriptions = &bindings[i];
+        vertexInputs[i].vertexAttributeDescriptionCount = description.vertexAttributeCount;
+        vertexInputs[i].pVertexAttributeDescriptions = description.vertexAttributes.data();
+
+        inputAssemblies[i].sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssemblies[i].topology = description.state.topology;
+        inputAssemblies[i].primitiveRestartEnable = VK_FALSE;
+
+        rasterizers[i].sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizers[i].depthClampEnable = VK_FALSE;
+        rasterizers[i].rasterizerDiscardEnable = VK_FALSE;
+        rasterizers[i].polygonMode = description.state.polygonMode;
+        rasterizers[i].lineWidth = 1.0f;
+        rasterizers[i].cullMode = description.state.cullMode;
+        rasterizers[i].frontFace = description.state.frontFace;
+        rasterizers[i].depthBiasEnable = VK_FALSE;
+
+        multisamplings[i].sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisamplings[i].sampleShadingEnable = VK_FALSE;
+        multisamplings[i].rasterizationSamples = description.samples;
+        multisamplings[i].minSampleShading = 1.0f;
+
+        //Ignored by subpasses without a depth attachment...
+        depthStencils[i].sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencils[i].depthTestEnable = description.state.depthTestEnable;
+        depthStencils[i].depthWriteEnable = description.state.depthWriteEnable;
+        depthStencils[i].depthCompareOp = description.state.depthCompareOp;
+        depthStencils[i].depthBoundsTestEnable = VK_FALSE;
+        depthStencils[i].stencilTestEnable = VK_FALSE;
+        depthStencils[i].minDepthBounds = 0.0f;
+        depthStencils[i].maxDepthBounds = 1.0f;
+
+        auto & attachment = colorBlendAttachments[i];
+        attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        attachment.blendEnable = description.state.blendEnable;
+        attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        attachment.colorBlendOp = VK_BLEND_OP_ADD;
+        attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+        colorBlendings[i].sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlendings[i].logicOpEnable = VK_FALSE;
+        colorBlendings[i].logicOp = VK_LOGIC_OP_COPY;
+        colorBlendings[i].attachmentCount = description.colorAttachmentCount;
+        colorBlendings[i].pAttachments = &attachment;
+
+        auto & pipelineInfo = pipelineInfos[i];
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = description.shaderCount;
+        pipelineInfo.pStages = stages;
+        pipelineInfo.pVertexInputState = &vertexInputs[i];
+        pipelineInfo.pInputAssemblyState = &inputAssemblies[i];
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizers[i];
+        pipelineInfo.pMultisampleState = &multisamplings[i];
+        pipelineInfo.pDepthStencilState = &depthStencils[i];
+        pipelineInfo.pColorBlendState = &colorBlendings[i];
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.layout = description.layout;
+        pipelineInfo.renderPass = description.renderPass;
+        pipelineInfo.subpass = description.subpass;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineInfo.basePipelineIndex = -1;
+    }
+
+    //One call for the whole batch, failed pipelines come back null and stay pending...
+    std::vector <VkPipeline> created(count, VK_NULL_HANDLE);
+    auto result = vkCreateGraphicsPipelines(*logicalDevice, pipelineCache, static_cast<uint32_t>(count), pipelineInfos.data(), nullptr, created.data());
+    std::vector <uint32_t> failed;
+    for (auto i = 0U; i < count; i++){
+        if (result == VK_SUCCESS && created[i] != VK_NULL_HANDLE)
+            pipelines[pending[i]] = created[i];
+        else if (created[i] != VK_NULL_HANDLE)
+            vkDestroyPipeline(*logicalDevice, created[i], nullptr);
+        if (pipelines[pending[i]] == VK_NULL_HANDLE)
+            failed.push_back(pending[i]);
+    }
+    pending = failed;
+    if (result != VK_SUCCESS)
+        throw std::runtime_error("Failed to create graphics pipelines!");
+}
+
+VkPipeline PipelineStateCache::getPipeline(uint32_t handle) const noexcept{
+    return handle < pipelines.size() ? pipelines[handle] : VK_NULL_HANDLE;
+}
+
+size_t PipelineStateCache::getPipelineCount() const noexcept{
+    return pipelines.size();
+}
+
+size_t PipelineStateCache::getPendingCount() const noexcept{
+    return pending.size();
+}
+
+void PipelineStateCache::cleanup() noexcept{
+    for (auto pipeline : pipelines)
+        vkDestroyPipeline(*logicalDevice, pipeline, nullptr);
+    handles.clear();
+    descriptions.clear();
+    pipelines.clear();
+    pending.clear();
+}
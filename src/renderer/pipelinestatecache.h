@@ -0,0 +1,75 @@
+#ifndef PIPELINESTATECACHE_H
+#define PIPELINESTATECACHE_H
+
+#include "src/utility.h"
+#include "specializationconstants.h"
+#include <unordered_map>
+
+#define PIPELINE_MAX_SHADER_STAGES 5
+#define PIPELINE_MAX_VERTEX_ATTRIBUTES 8
+
+struct PipelineState final
+{
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+    VkBool32 blendEnable = VK_TRUE;
+    VkBool32 depthTestEnable = VK_FALSE;
+    VkBool32 depthWriteEnable = VK_FALSE;
+    VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+    SpecializationConstants specialization;
+
+    [[nodiscard]] bool operator==(const PipelineState & other) const noexcept;
+};
+
+struct PipelineDescription final
+{
+    std::array <VkShaderModule, PIPELINE_MAX_SHADER_STAGES> shaders;
+    std::array <VkShaderStageFlagBits, PIPELINE_MAX_SHADER_STAGES> stages;
+    uint32_t shaderCount;
+    uint32_t vertexStride;
+    std::array <VkVertexInputAttributeDescription, PIPELINE_MAX_VERTEX_ATTRIBUTES> vertexAttributes;
+    uint32_t vertexAttributeCount;
+    PipelineState state;
+    uint32_t colorAttachmentCount;
+    VkSampleCountFlagBits samples;
+    VkPipelineLayout layout;
+    VkRenderPass renderPass;
+    uint32_t subpass;
+
+    [[nodiscard]] bool operator==(const PipelineDescription & other) const noexcept;
+};
+
+class PipelineStateCache final
+{
+private:
+    struct DescriptionHash final
+    {
+        [[nodiscard]] size_t operator()(const PipelineDescription & description) const noexcept;
+    };
+public:
+    PipelineStateCache(VkDevice *device, VkPipelineCache pipelinecache = VK_NULL_HANDLE);
+public:
+    ~PipelineStateCache() = default;
+    PipelineStateCache(const PipelineStateCache & other) = delete;
+    PipelineStateCache & operator=(const PipelineStateCache & other) = delete;
+    PipelineStateCache(const PipelineStateCache && other) = delete;
+    PipelineStateCache & operator=(const PipelineStateCache && other) = delete;
+public:
+    [[nodiscard]] uint32_t request(const PipelineDescription & description);
+    void createPending();
+    [[nodiscard]] VkPipeline getPipeline(uint32_t handle) const noexcept;
+    [[nodiscard]] size_t getPipelineCount() const noexcept;
+    [[nodiscard]] size_t getPendingCount() const noexcept;
+    void cleanup() noexcept;
+private:
+    VkDevice *logicalDevice;
+    VkPipelineCache pipelineCache;
+    std::unordered_map <PipelineDescription, uint32_t, DescriptionHash> handles;
+    std::vector <PipelineDescription> descriptions;
+    std::vector <VkPipeline> pipelines;
+    std::vector <uint32_t> pending;
+};
+
+#endif // PIPELINESTATECACHE_H
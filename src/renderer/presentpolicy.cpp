@@ -0,0 +1,101 @@
+#include "presentpolicy.h"
+#include <algorithm>
+#include <thread>
+
+/*!
+        \class PresentPolicy
+        \brief The PresentPolicy class picks the present mode, image count and frames in flight for a latency or throughput goal.
+
+        MAX_THROUGHPUT prefers MAILBOX, then IMMEDIATE, with one image more than the surface minimum and
+        DEFAULT_FRAMES_IN_FLIGHT. LOW_LATENCY prefers MAILBOX with the minimum image count and a single frame
+        in flight, so the CPU waits on the previous frame's fence before it starts the next one. PACED_FIFO
+        uses FIFO, which every surface supports, and can cap the frame rate below the display's.
+
+        limitFrameRate() is a CPU frame limiter. With a target it sleeps until the next frame is due and
+        returns how long it waited; the schedule advances by whole intervals, so a late frame doesn't push
+        every later one back. Without a target, or for the other modes, it returns straight away.
+*/
+
+PresentPolicy::PresentPolicy(Mode policymode, double targetfps)
+    : mode(policymode),
+      targetFps(targetfps),
+      limiterStarted(false)
+{
+    if (policymode < 0 || policymode >= MODE_COUNT)
+        throw std::runtime_error("Invalid present policy!");
+    if (targetfps < 0.0)
+        throw std::runtime_error("Present policy target frame rate must not be negative!");
+}
+
+VkPresentModeKHR PresentPolicy::choosePresentMode(const std::vector<VkPresentModeKHR> & availablepresentmodes) const noexcept{
+    //FIFO is the only mode every surface has to support...
+    auto available = [&](VkPresentModeKHR presentmode){
+        return std::find(availablepresentmodes.begin(), availablepresentmodes.end(), presentmode) != availablepresentmodes.end();
+    };
+    switch (mode){
+    case MAX_THROUGHPUT:
+        if (available(VK_PRESENT_MODE_MAILBOX_KHR))
+            return VK_PRESENT_MODE_MAILBOX_KHR;
+        if (available(VK_PRESENT_MODE_IMMEDIATE_KHR))
+            return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        break;
+    case LOW_LATENCY:
+        if (available(VK_PRESENT_MODE_MAILBOX_KHR))
+            return VK_PRESENT_MODE_MAILBOX_KHR;
+        break;
+    default:
+        break;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+uint32_t PresentPolicy::chooseImageCount(const VkSurfaceCapabilitiesKHR & capabilities) const noexcept{
+    //A shorter queue means less latency, a spare image keeps the GPU from waiting on the display...
+    auto imagecount = mode == LOW_LATENCY ? capabilities.minImageCount : capabilities.minImageCount + 1;
+    if (capabilities.maxImageCount > 0)
+        imagecount = (std::min)(imagecount, capabilities.maxImageCount);
+    return imagecount;
+}
+
+uint32_t PresentPolicy::getFramesInFlight() const noexcept{
+    return mode == LOW_LATENCY ? 1 : DEFAULT_FRAMES_IN_FLIGHT;
+}
+
+uint64_t PresentPolicy::limitFrameRate(){
+    if (mode != PACED_FIFO || targetFps <= 0.0)
+        return 0;
+
+    //The first frame sets the schedule...
+    auto now = std::chrono::steady_clock::now();
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+    if (!limiterStarted || now > nextFrame + interval){
+        limiterStarted = true;
+        nextFrame = now + interval;
+        return 0;
+    }
+    std::this_thread::sleep_until(nextFrame);
+    auto waited = std::chrono::steady_clock::now() - now;
+    nextFrame += interval;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+}
+
+PresentPolicy::Mode PresentPolicy::getMode() const noexcept{
+    return mode;
+}
+
+double PresentPolicy::getTargetFps() const noexcept{
+    return targetFps;
+}
+
+const char * PresentPolicy::getModeName(Mode policymode) noexcept{
+    switch (policymode){
+    case MAX_THROUGHPUT:
+        return "max_throughput";
+    case LOW_LATENCY:
+        return "low_latency";
+    case PACED_FIFO:
+        return "paced_fifo";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef PRESENTPOLICY_H
+#define PRESENTPOLICY_H
+
+#include "src/utility.h"
+#include <chrono>
+
+class PresentPolicy final
+{
+public:
+    enum Mode {
+        MAX_THROUGHPUT = 0,
+        LOW_LATENCY = 1,
+        PACED_FIFO = 2,
+        MODE_COUNT = 3
+    };
+public:
+    PresentPolicy(Mode policymode = MAX_THROUGHPUT, double targetfps = 0.0);
+public:
+    ~PresentPolicy() = default;
+    PresentPolicy(const PresentPolicy & other) = default;
+    PresentPolicy & operator=(const PresentPolicy & other) = default;
+public:
+    [[nodiscard]] VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR> & availablepresentmodes) const noexcept;
+    [[nodiscard]] uint32_t chooseImageCount(const VkSurfaceCapabilitiesKHR & capabilities) const noexcept;
+    [[nodiscard]] uint32_t getFramesInFlight() const noexcept;
+    [[nodiscard]] uint64_t limitFrameRate();
+    [[nodiscard]] Mode getMode() const noexcept;
+    [[nodiscard]] double getTargetFps() const noexcept;
+    [[nodiscard]] static const char * getModeName(Mode policymode) noexcept;
+private:
+    Mode mode;
+    double targetFps;
+    std::chrono::steady_clock::time_point nextFrame;
+    bool limiterStarted;
+};
+
+#endif // PRESENTPOLICY_H
@@ -0,0 +1,712 @@
+#include "rendergraph.h"
+#include <algorithm>
+
+/*!
+        \class RenderGraph
+        \brief The RenderGraph class builds a frame's render pass from passes that declare what they read and write.
+
+        Attachments are either external, the swapchain or offscreen image a frame ends up in, or transient,
+        images that only live inside the render pass. Passes name the attachments they write as colour or
+        depth, the ones they test depth against without writing, and the ones they read back as input
+        attachments. compile() then works the render pass out from those declarations:
+
+        Passes whose writes never reach the output attachment are culled. Every pass that survives becomes a
+        subpass of one VkRenderPass, in the order they were added, so a tiler can keep the whole frame on chip.
+        Each attachment gets the layout its use needs in every subpass and is cleared on its first use, and
+        subpasses between two uses that don't reference it preserve it.
+        Dependencies only cover real hazards, a read or write after a write and a write after a read, with the
+        stages and access of the two uses involved. Render pass dependencies are the pipeline barriers of a
+        subpass, nothing else is recorded between them.
+
+        Transient attachments are never stored, so they are created with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT
+        and placed in lazily allocated memory where the device has it. Transients whose subpass lifetimes don't
+        overlap share a slot, and a slot is backed by one allocation that its images alias. Reads of an
+        attachment through a sampler would need the pass split in two with a barrier between them and aren't
+        supported, input attachments cover reads at the same pixel.
+*/
+
+RenderGraph::RenderGraph(VkDevice *device)
+    : logicalDevice(device),
+      output(-1),
+      compiled(false),
+      renderPass(VK_NULL_HANDLE),
+      preserveCount(0),
+      memoryStatistics()
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to RenderGraph!");
+}
+
+uint32_t RenderGraph::addExternalAttachment(const std::string & name, VkFormat format, VkImageLayout finallayout){
+    if (compiled)
+        throw std::runtime_error("Render graph can't change once it's compiled!");
+    for (const auto & attachment : attachments)
+        if (attachment.external)
+            throw std::runtime_error("Render graph only supports one external attachment!");
+
+    //The image comes from outside, the render pass leaves it in whatever layout its next user wants...
+    Attachment attachment = {};
+    attachment.name = name;
+    attachment.format = format;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.type = COLOR_ATTACHMENT;
+    attachment.external = true;
+    attachment.finalLayout = finallayout;
+    attachment.clearValue.color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    attachments.push_back(attachment);
+    return static_cast<uint32_t>(attachments.size() - 1);
+}
+
+uint32_t RenderGraph::addTransientAttachment(const std::string & name, VkFormat format, AttachmentType type, VkSampleCountFlagBits samples){
+    if (compiled)
+        throw std::runtime_error("Render graph can't change once it's compiled!");
+    Attachment attachment = {};
+    attachment.name = name;
+    attachment.format = format;
+    attachment.samples = samples;
+    attachment.type = type;
+    attachment.external = false;
+    attachment.finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (type == DEPTH_ATTACHMENT)
+        attachment.clearValue.depthStencil = {1.0f, 0};
+    else
+        attachment.clearValue.color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    attachments.push_back(attachment);
+    return static_cast<uint32_t>(attachments.size() - 1);
+}
+
+uint32_t RenderGraph::addPass(const std::string & name){
+    if (compiled)
+        throw std::runtime_error("Render graph can't change once it's compiled!");
+    Pass pass = {};
+    pass.name = name;
+    pass.depthAttachment = -1;
+    pass.depthWrite = false;
+    passes.push_back(pass);
+    return static_cast<uint32_t>(passes.size() - 1);
+}
+
+void RenderGraph::writeColor(uint32_t pass, uint32_t attachment, int32_t resolveattachment){
+    auto & target = getPass(pass);
+    target.colorWrites.push_back(checkAttachment(attachment, COLOR_ATTACHMENT));
+
+    //Resolves go from a multisampled attachment to a single sampled one at the end of the subpass...
+    if (resolveattachment >= 0){
+        (void)checkAttachment(static_cast<uint32_t>(resolveattachment), COLOR_ATTACHMENT);
+        if (attachments[attachment].samples == VK_SAMPLE_COUNT_1_BIT || attachments[resolveattachment].samples != VK_SAMPLE_COUNT_1_BIT)
+            throw std::runtime_error("Render graph resolves need a multisampled source and a single sampled target!");
+    }
+    target.resolveWrites.push_back(resolveattachment);
+}
+
+void RenderGraph::writeDepth(uint32_t pass, uint32_t attachment){
+    auto & target = getPass(pass);
+    if (target.depthAttachment >= 0)
+        throw std::runtime_error("Render graph passes only have one depth attachment!");
+    target.depthAttachment = static_cast<int32_t>(checkAttachment(attachment, DEPTH_ATTACHMENT));
+    target.depthWrite = true;
+}
+
+void RenderGraph::readDepth(uint32_t pass, uint32_t attachment){
+    auto & target = getPass(pass);
+    if (target.depthAttachment >= 0)
+        throw std::runtime_error("Render graph passes only have one depth attachment!");
+    target.depthAttachment = static_cast<int32_t>(checkAttachment(attachment, DEPTH_ATTACHMENT));
+    target.depthWrite = false;
+}
+
+void RenderGraph::readInput(uint32_t pass, uint32_t attachment){
+    auto & target = getPass(pass);
+    if (attachment >= attachments.size())
+        throw std::runtime_error("Render graph has no such attachment!");
+    target.inputReads.push_back(attachment);
+}
+
+void RenderGraph::setOutput(uint32_t attachment){
+    if (attachment >= attachments.size())
+        throw std::runtime_error("Render graph has no such attachment!");
+    output = static_cast<int32_t>(attachment);
+}
+
+void RenderGraph::compile(){
+    if (compiled)
+        throw std::runtime_error("Render graph is already compiled!");
+    if (output < 0)
+        throw std::runtime_error("Render graph has no output attachment!");
+
+    //Walk back from the output, a pass lives if it writes something a later live pass or the output needs...
+    std::vector <bool> needed(attachments.size(), false);
+    std::vector <bool> live(passes.size(), false);
+    needed[static_cast<uint32_t>(output)] = true;
+    for (auto i = passes.size(); i-- > 0;){
+        auto usages = getUsages(passes[i]);
+        for (const auto & usage : usages)
+            if (getAccess(usage.second, attachments[usage.first].type).write && needed[usage.first])
+                live[i] = true;
+        if (!live[i])
+            continue;
+
+        //Later passes load what earlier ones wrote, so everything a live pass touches is needed before it...
+        for (const auto & usage : usages)
+            needed[usage.first] = true;
+    }
+    subpassIndices.assign(passes.size(), -1);
+    auto subpasscount = 0U;
+    for (auto i = 0U; i < passes.size(); i++)
+        if (live[i])
+            subpassIndices[i] = static_cast<int32_t>(subpasscount++);
+    if (!subpasscount)
+        throw std::runtime_error("Render graph has no pass that writes its output!");
+
+    //Track the last writer and the readers since then of every attachment, a dependency is only needed
+    //where one of the two uses writes...
+    struct Hazard final
+    {
+        int32_t writer;
+        Access write;
+        std::vector <std::pair<uint32_t, VkPipelineStageFlags>> readers;
+    };
+    std::vector <Hazard> hazards(attachments.size(), Hazard{-1, {}, {}});
+    lifetimes.assign(attachments.size(), Lifetime{-1, -1, COLOR_WRITE, {}, {}, 0});
+    dependencies.clear();
+    for (auto i = 0U; i < passes.size(); i++){
+        if (!live[i])
+            continue;
+        auto subpass = static_cast<uint32_t>(subpassIndices[i]);
+        auto samples = getSamples(i);
+        for (const auto & usage : getUsages(passes[i])){
+            const auto & attachment = attachments[usage.first];
+            auto access = getAccess(usage.second, attachment.type);
+            if (usage.second != RESOLVE_WRITE && usage.second != INPUT_READ && attachment.samples != samples)
+                throw std::runtime_error("Render graph pass " + passes[i].name + " mixes sample counts!");
+
+            auto & hazard = hazards[usage.first];
+            if (hazard.writer >= 0 && static_cast<uint32_t>(hazard.writer) != subpass)
+                addDependency(static_cast<uint32_t>(hazard.writer), subpass, hazard.write.stages, hazard.write.access, access.stages, access.access);
+            if (access.write){
+                for (const auto & reader : hazard.readers)
+                    if (reader.first != subpass)
+                        addDependency(reader.first, subpass, reader.second, 0, access.stages, access.access);
+                hazard.readers.clear();
+                hazard.writer = static_cast<int32_t>(subpass);
+                hazard.write = access;
+            }else{
+                hazard.readers.emplace_back(subpass, access.stages);
+            }
+
+            auto & lifetime = lifetimes[usage.first];
+            if (lifetime.firstSubpass < 0){
+                if (!access.write)
+                    throw std::runtime_error("Render graph attachment " + attachment.name + " is read before it's written!");
+                lifetime.firstSubpass = static_cast<int32_t>(subpass);
+                lifetime.firstUsage = usage.second;
+                lifetime.first = access;
+            }
+            lifetime.lastSubpass = static_cast<int32_t>(subpass);
+            lifetime.last = access;
+            lifetime.imageUsage |= usage.second == INPUT_READ ? VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT :
+                                   attachment.type == DEPTH_ATTACHMENT ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        }
+    }
+
+    //Transients that are done before another starts can share its memory. The handover is a write after
+    //write on that memory, so the slot's previous user gets a dependency on the next one...
+    std::vector <uint32_t> transients;
+    for (auto i = 0U; i < attachments.size(); i++)
+        if (!attachments[i].external && lifetimes[i].firstSubpass >= 0)
+            transients.push_back(i);
+    std::stable_sort(transients.begin(), transients.end(), [&](uint32_t a, uint32_t b){
+        return lifetimes[a].firstSubpass < lifetimes[b].firstSubpass;
+    });
+    std::vector <std::vector<uint32_t>> slots;
+    aliasSlots.assign(attachments.size(), -1);
+    for (auto transient : transients){
+        const auto & lifetime = lifetimes[transient];
+        auto slot = std::find_if(slots.begin(), slots.end(), [&](const std::vector<uint32_t> & members){
+            return lifetimes[members.back()].lastSubpass < lifetime.firstSubpass;
+        });
+        if (slot != slots.end()){
+            const auto & previous = lifetimes[slot->back()];
+            addDependency(
+                        static_cast<uint32_t>(previous.lastSubpass),
+                        static_cast<uint32_t>(lifetime.firstSubpass),
+                        previous.last.stages,
+                        previous.last.write ? previous.last.access : 0,
+                        lifetime.first.stages,
+                        lifetime.first.access
+                        );
+            slot->push_back(transient);
+        }else{
+            slots.push_back({transient});
+            slot = slots.end() - 1;
+        }
+        aliasSlots[transient] = static_cast<int32_t>(slot - slots.begin());
+    }
+    memoryStatistics.transientCount = static_cast<uint32_t>(transients.size());
+    memoryStatistics.aliasSlotCount = static_cast<uint32_t>(slots.size());
+
+    //The external image is handed over by the acquire semaphore, which is waited on at colour output, and
+    //left for presentation or a transfer. Transients are only reused by the next frame, whose first use
+    //has to wait for this frame's last use of anything in the same slot...
+    for (auto i = 0U; i < attachments.size(); i++){
+        const auto & lifetime = lifetimes[i];
+        if (lifetime.firstSubpass < 0)
+            continue;
+        auto first = static_cast<uint32_t>(lifetime.firstSubpass);
+        if (attachments[i].external){
+            addDependency(VK_SUBPASS_EXTERNAL, first, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, lifetime.first.stages, lifetime.first.access);
+            const auto & hazard = hazards[i];
+            if (attachments[i].finalLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+                addDependency(static_cast<uint32_t>(hazard.writer), VK_SUBPASS_EXTERNAL, hazard.write.stages, hazard.write.access, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+            else
+                addDependency(static_cast<uint32_t>(hazard.writer), VK_SUBPASS_EXTERNAL, hazard.write.stages, hazard.write.access, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+        }else{
+            VkPipelineStageFlags stages = 0;
+            VkAccessFlags access = 0;
+            for (auto member : slots[static_cast<uint32_t>(aliasSlots[i])]){
+                stages |= lifetimes[member].last.stages;
+                access |= lifetimes[member].last.write ? lifetimes[member].last.access : 0;
+            }
+            addDependency(VK_SUBPASS_EXTERNAL, first, stages, access, lifetime.first.stages, lifetime.first.access);
+        }
+    }
+
+    //Culled attachments don't make it into the render pass, the rest keep the order they were added in...
+    std::vector <VkAttachmentDescription> descriptions;
+    attachmentIndices.assign(attachments.size(), -1);
+    usedAttachments.clear();
+    clearValues.clear();
+    for (auto i = 0U; i < attachments.size(); i++){
+        const auto & attachment = attachments[i];
+        const auto & lifetime = lifetimes[i];
+        if (lifetime.firstSubpass < 0)
+            continue;
+        attachmentIndices[i] = static_cast<int32_t>(descriptions.size());
+        usedAttachments.push_back(i);
+        clearValues.push_back(attachment.clearValue);
+
+        //A resolve overwrites every pixel, there's nothing to clear...
+        VkAttachmentDescription description = {};
+        description.flags = !attachment.external && slots[static_cast<uint32_t>(aliasSlots[i])].size() > 1 ? VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT : 0;
+        description.format = attachment.format;
+        description.samples = attachment.samples;
+        description.loadOp = lifetime.firstUsage == RESOLVE_WRITE ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_CLEAR;
+        description.storeOp = attachment.external ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.stencilLoadOp = attachment.type == DEPTH_ATTACHMENT && hasStencil(attachment.format) ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        description.finalLayout = attachment.external ? attachment.finalLayout : lifetime.last.layout;
+        descriptions.push_back(description);
+    }
+
+    //References are filled in before any subpass points at them...
+    std::vector <std::vector<VkAttachmentReference>> colorReferences(subpasscount);
+    std::vector <std::vector<VkAttachmentReference>> resolveReferences(subpasscount);
+    std::vector <std::vector<VkAttachmentReference>> inputReferences(subpasscount);
+    std::vector <VkAttachmentReference> depthReferences(subpasscount);
+    std::vector <std::vector<uint32_t>> preserveReferences(subpasscount);
+    std::vector <std::vector<bool>> referenced(subpasscount, std::vector<bool>(attachments.size(), false));
+    std::vector <VkSubpassDescription> subpasses(subpasscount);
+    for (auto i = 0U; i < passes.size(); i++){
+        if (!live[i])
+            continue;
+        const auto & pass = passes[i];
+        auto subpass = static_cast<uint32_t>(subpassIndices[i]);
+        for (const auto & usage : getUsages(pass))
+            referenced[subpass][usage.first] = true;
+        auto resolves = false;
+        for (auto j = 0U; j < pass.colorWrites.size(); j++){
+            colorReferences[subpass].push_back({static_cast<uint32_t>(attachmentIndices[pass.colorWrites[j]]), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+            auto resolve = pass.resolveWrites[j];
+            resolves |= resolve >= 0;
+            resolveReferences[subpass].push_back(resolve >= 0 ?
+                        VkAttachmentReference{static_cast<uint32_t>(attachmentIndices[static_cast<uint32_t>(resolve)]), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL} :
+                        VkAttachmentReference{VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED});
+        }
+        if (!resolves)
+            resolveReferences[subpass].clear();
+        for (auto input : pass.inputReads)
+            inputReferences[subpass].push_back({static_cast<uint32_t>(attachmentIndices[input]), getAccess(INPUT_READ, attachments[input].type).layout});
+        if (pass.depthAttachment >= 0)
+            depthReferences[subpass] = {
+                static_cast<uint32_t>(attachmentIndices[static_cast<uint32_t>(pass.depthAttachment)]),
+                getAccess(pass.depthWrite ? DEPTH_WRITE : DEPTH_READ, DEPTH_ATTACHMENT).layout
+            };
+
+        auto & description = subpasses[subpass];
+        description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        description.colorAttachmentCount = static_cast<uint32_t>(colorReferences[subpass].size());
+        description.pColorAttachments = colorReferences[subpass].empty() ? nullptr : colorReferences[subpass].data();
+        description.pResolveAttachments = resolveReferences[subpass].empty() ? nullptr : resolveReferences[subpass].data();
+        description.inputAttachmentCount = static_cast<uint32_t>(inputReferences[subpass].size());
+        description.pInputAttachments = inputReferences[subpass].empty() ? nullptr : inputReferences[subpass].data();
+        description.pDepthStencilAttachment = pass.depthAttachment >= 0 ? &depthReferences[subpass] : nullptr;
+    }
+
+    //An attachment's contents only get through a subpass that doesn't reference it if that subpass preserves
+    //it, which every subpass between its first and last use has to...
+    preserveCount = 0;
+    for (auto i : usedAttachments){
+        const auto & lifetime = lifetimes[i];
+        for (auto subpass = lifetime.firstSubpass + 1; subpass < lifetime.lastSubpass; subpass++){
+            if (referenced[static_cast<uint32_t>(subpass)][i])
+                continue;
+            preserveReferences[static_cast<uint32_t>(subpass)].push_back(static_cast<uint32_t>(attachmentIndices[i]));
+            preserveCount++;
+        }
+    }
+    for (auto subpass = 0U; subpass < subpasscount; subpass++){
+        subpasses[subpass].preserveAttachmentCount = static_cast<uint32_t>(preserveReferences[subpass].size());
+        subpasses[subpass].pPreserveAttachments = preserveReferences[subpass].empty() ? nullptr : preserveReferences[subpass].data();
+    }
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+    renderPassInfo.pAttachments = descriptions.data();
+    renderPassInfo.subpassCount = subpasscount;
+    renderPassInfo.pSubpasses = subpasses.data();
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.empty() ? nullptr : dependencies.data();
+    if (vkCreateRenderPass(*logicalDevice, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create render pass!");
+    compiled = true;
+}
+
+void RenderGraph::createAttachments(VkExtent2D extent, const std::shared_ptr<DeviceMemoryAllocator> & memoryallocator){
+    if (!compiled)
+        throw std::runtime_error("Render graph must be compiled before its attachments are created!");
+    if (!memoryallocator)
+        throw std::runtime_error("Null memory allocator passed to RenderGraph!");
+
+    //Attachments still in use by earlier frames have to be released before this is called...
+    destroyAttachments();
+    memoryAllocator = memoryallocator;
+    images.assign(attachments.size(), VK_NULL_HANDLE);
+    views.assign(attachments.size(), VK_NULL_HANDLE);
+    memoryStatistics.requestedBytes = 0;
+    memoryStatistics.allocatedBytes = 0;
+    memoryStatistics.lazilyAllocatedBytes = 0;
+    memoryStatistics.storedBytesPerFrame = 0;
+    memoryStatistics.discardedColorBytesPerFrame = 0;
+    memoryStatistics.discardedDepthBytesPerFrame = 0;
+    std::vector <VkMemoryRequirements> requirements(attachments.size());
+    for (auto i : usedAttachments){
+        //Only the external attachment is stored, every sample of a transient would have been written out otherwise...
+        auto bytes = getTexelSize(attachments[i].format) * attachments[i].samples * extent.width * extent.height;
+        if (attachments[i].external)
+            memoryStatistics.storedBytesPerFrame += bytes;
+        else if (attachments[i].type == DEPTH_ATTACHMENT)
+            memoryStatistics.discardedDepthBytesPerFrame += bytes;
+        else
+            memoryStatistics.discardedColorBytesPerFrame += bytes;
+        if (attachments[i].external)
+            continue;
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = attachments[i].format;
+        imageInfo.extent = {extent.width, extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = attachments[i].samples;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = lifetimes[i].imageUsage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (vkCreateImage(*logicalDevice, &imageInfo, nullptr, &images[i]) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create transient attachment " + attachments[i].name + "!");
+        vkGetImageMemoryRequirements(*logicalDevice, images[i], &requirements[i]);
+        memoryStatistics.requestedBytes += requirements[i].size;
+    }
+
+    //Members of a slot share an allocation as long as there's a memory type they can all live in...
+    for (auto slot = 0U; slot < memoryStatistics.aliasSlotCount; slot++){
+        std::vector <std::pair<VkMemoryRequirements, std::vector<uint32_t>>> groups;
+        for (auto i : usedAttachments){
+            if (aliasSlots[i] != static_cast<int32_t>(slot))
+                continue;
+            auto group = std::find_if(groups.begin(), groups.end(), [&](const std::pair<VkMemoryRequirements, std::vector<uint32_t>> & candidate){
+                return (candidate.first.memoryTypeBits & requirements[i].memoryTypeBits) != 0;
+            });
+            if (group == groups.end()){
+                groups.push_back({requirements[i], {i}});
+                continue;
+            }
+            group->first.size = (std::max)(group->first.size, requirements[i].size);
+            group->first.alignment = (std::max)(group->first.alignment, requirements[i].alignment);
+            group->first.memoryTypeBits &= requirements[i].memoryTypeBits;
+            group->second.push_back(i);
+        }
+        for (const auto & group : groups){
+            allocations.push_back(memoryAllocator->allocate(group.first, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, DeviceMemoryAllocator::OPTIMAL_RESOURCE, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT));
+            memoryStatistics.allocatedBytes += group.first.size;
+            if (memoryAllocator->getMemoryTypeFlags(allocations.back().memoryType) & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+                memoryStatistics.lazilyAllocatedBytes += group.first.size;
+            for (auto i : group.second)
+                if (vkBindImageMemory(*logicalDevice, images[i], allocations.back().memory, allocations.back().offset) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to bind transient attachment memory!");
+        }
+    }
+
+    for (auto i : usedAttachments){
+        if (attachments[i].external)
+            continue;
+        VkImageViewCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        createInfo.image = images[i];
+        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        createInfo.format = attachments[i].format;
+        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        if (attachments[i].type == DEPTH_ATTACHMENT)
+            createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | (hasStencil(attachments[i].format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+        else
+            createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        createInfo.subresourceRange.baseMipLevel = 0;
+        createInfo.subresourceRange.levelCount = 1;
+        createInfo.subresourceRange.baseArrayLayer = 0;
+        createInfo.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(*logicalDevice, &createInfo, nullptr, &views[i]) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create transient attachment view!");
+    }
+}
+
+void RenderGraph::releaseAttachments(
+        std::vector<VkImage> & retiredimages,
+        std::vector<VkImageView> & retiredviews,
+        std::vector<DeviceMemoryAllocator::Allocation> & retiredallocations
+        ) noexcept
+{
+    //Whoever takes them destroys them once the frames using them have retired...
+    for (auto image : images)
+        if (image != VK_NULL_HANDLE)
+            retiredimages.push_back(image);
+    for (auto view : views)
+        if (view != VK_NULL_HANDLE)
+            retiredviews.push_back(view);
+    retiredallocations.insert(retiredallocations.end(), allocations.begin(), allocations.end());
+    images.clear();
+    views.clear();
+    allocations.clear();
+}
+
+std::vector<VkImageView> RenderGraph::getFramebufferAttachments(VkImageView externalview) const{
+    std::vector <VkImageView> framebufferattachments;
+    for (auto i : usedAttachments){
+        if (attachments[i].external){
+            framebufferattachments.push_back(externalview);
+            continue;
+        }
+        if (i >= views.size() || views[i] == VK_NULL_HANDLE)
+            throw std::runtime_error("Render graph attachments haven't been created!");
+        framebufferattachments.push_back(views[i]);
+    }
+    return framebufferattachments;
+}
+
+const std::vector<VkClearValue> & RenderGraph::getClearValues() const noexcept{
+    return clearValues;
+}
+
+VkRenderPass RenderGraph::getRenderPass() const noexcept{
+    return renderPass;
+}
+
+uint32_t RenderGraph::getSubpassCount() const noexcept{
+    return static_cast<uint32_t>(std::count_if(subpassIndices.begin(), subpassIndices.end(), [](int32_t subpass){
+        return subpass >= 0;
+    }));
+}
+
+uint32_t RenderGraph::getSubpass(uint32_t pass) const{
+    if (pass >= subpassIndices.size() || subpassIndices[pass] < 0)
+        throw std::runtime_error("Render graph pass wasn't compiled into a subpass!");
+    return static_cast<uint32_t>(subpassIndices[pass]);
+}
+
+VkSampleCountFlagBits RenderGraph::getSamples(uint32_t pass) const{
+    if (pass >= passes.size())
+        throw std::runtime_error("Render graph has no such pass!");
+
+    //Colour and depth attachments of a subpass all share one sample count, pipelines in it must match...
+    const auto & target = passes[pass];
+    if (!target.colorWrites.empty())
+        return attachments[target.colorWrites.front()].samples;
+    if (target.depthAttachment >= 0)
+        return attachments[static_cast<uint32_t>(target.depthAttachment)].samples;
+    return VK_SAMPLE_COUNT_1_BIT;
+}
+
+bool RenderGraph::isCulled(uint32_t pass) const{
+    if (!compiled || pass >= passes.size())
+        throw std::runtime_error("Render graph pass wasn't compiled!");
+    return subpassIndices[pass] < 0;
+}
+
+size_t RenderGraph::getDependencyCount() const noexcept{
+    return dependencies.size();
+}
+
+size_t RenderGraph::getPreserveCount() const noexcept{
+    return preserveCount;
+}
+
+const RenderGraph::MemoryStatistics & RenderGraph::getMemoryStatistics() const noexcept{
+    //Lazily allocated bytes are only reserved, a tiler may never back them with physical memory...
+    return memoryStatistics;
+}
+
+void RenderGraph::cleanup() noexcept{
+    destroyAttachments();
+    if (renderPass != VK_NULL_HANDLE)
+        vkDestroyRenderPass(*logicalDevice, renderPass, nullptr);
+    renderPass = VK_NULL_HANDLE;
+    compiled = false;
+}
+
+bool RenderGraph::hasStencil(VkFormat format) noexcept{
+    return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+VkDeviceSize RenderGraph::getTexelSize(VkFormat format) noexcept{
+    //Bytes per sample of the formats attachments are made from, anything else isn't counted...
+    switch (format){
+    case VK_FORMAT_R5G6B5_UNORM_PACK16:
+    case VK_FORMAT_B5G6R5_UNORM_PACK16:
+    case VK_FORMAT_D16_UNORM:
+        return 2;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+        return 3;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+    case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT:
+        return 4;
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return 5;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+        return 8;
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+RenderGraph::Access RenderGraph::getAccess(Usage usage, AttachmentType type) noexcept{
+    switch (usage){
+    case COLOR_WRITE:
+        return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true};
+    case RESOLVE_WRITE:
+        return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true};
+    case DEPTH_WRITE:
+        return {
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            true
+        };
+    case DEPTH_READ:
+        return {
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+            false
+        };
+    case INPUT_READ:
+    default:
+        return {
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+            type == DEPTH_ATTACHMENT ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            false
+        };
+    }
+}
+
+std::vector<std::pair<uint32_t, RenderGraph::Usage>> RenderGraph::getUsages(const Pass & pass) const{
+    //An attachment has one layout per subpass, so it can't be read as an input where it's also drawn to...
+    std::vector <std::pair<uint32_t, Usage>> usages;
+    for (auto i = 0U; i < pass.colorWrites.size(); i++){
+        usages.emplace_back(pass.colorWrites[i], COLOR_WRITE);
+        if (pass.resolveWrites[i] >= 0)
+            usages.emplace_back(static_cast<uint32_t>(pass.resolveWrites[i]), RESOLVE_WRITE);
+    }
+    if (pass.depthAttachment >= 0)
+        usages.emplace_back(static_cast<uint32_t>(pass.depthAttachment), pass.depthWrite ? DEPTH_WRITE : DEPTH_READ);
+    for (auto input : pass.inputReads){
+        for (const auto & usage : usages)
+            if (usage.first == input)
+                throw std::runtime_error("Render graph pass " + pass.name + " reads an attachment it draws to!");
+        usages.emplace_back(input, INPUT_READ);
+    }
+    return usages;
+}
+
+uint32_t RenderGraph::checkAttachment(uint32_t attachment, AttachmentType type) const{
+    if (attachment >= attachments.size())
+        throw std::runtime_error("Render graph has no such attachment!");
+    if (attachments[attachment].type != type)
+        throw std::runtime_error("Render graph attachment " + attachments[attachment].name + " is the wrong type for this use!");
+    return attachment;
+}
+
+RenderGraph::Pass & RenderGraph::getPass(uint32_t pass){
+    if (compiled)
+        throw std::runtime_error("Render graph can't change once it's compiled!");
+    if (pass >= passes.size())
+        throw std::runtime_error("Render graph has no such pass!");
+    return passes[pass];
+}
+
+void RenderGraph::addDependency(
+        uint32_t srcsubpass,
+        uint32_t dstsubpass,
+        VkPipelineStageFlags srcstages,
+        VkAccessFlags srcaccess,
+        VkPipelineStageFlags dststages,
+        VkAccessFlags dstaccess
+        )
+{
+    //Hazards between the same two subpasses share one dependency...
+    auto dependency = std::find_if(dependencies.begin(), dependencies.end(), [&](const VkSubpassDependency & candidate){
+        return candidate.srcSubpass == srcsubpass && candidate.dstSubpass == dstsubpass;
+    });
+    if (dependency == dependencies.end()){
+        VkSubpassDependency created = {};
+        created.srcSubpass = srcsubpass;
+        created.dstSubpass = dstsubpass;
+
+        //Attachment hazards inside the pass are all at the same pixel, so tilers needn't flush between subpasses...
+        created.dependencyFlags = srcsubpass != VK_SUBPASS_EXTERNAL && dstsubpass != VK_SUBPASS_EXTERNAL ? VK_DEPENDENCY_BY_REGION_BIT : 0;
+        dependencies.push_back(created);
+        dependency = dependencies.end() - 1;
+    }
+    dependency->srcStageMask |= srcstages;
+    dependency->srcAccessMask |= srcaccess;
+    dependency->dstStageMask |= dststages;
+    dependency->dstAccessMask |= dstaccess;
+}
+
+void RenderGraph::destroyAttachments() noexcept{
+    for (auto view : views)
+        if (view != VK_NULL_HANDLE)
+            vkDestroyImageView(*logicalDevice, view, nullptr);
+    for (auto image : images)
+        if (image != VK_NULL_HANDLE)
+            vkDestroyImage(*logicalDevice, image, nullptr);
+    for (const auto & allocation : allocations)
+        memoryAllocator->free(allocation);
+    views.clear();
+    images.clear();
+    allocations.clear();
+}
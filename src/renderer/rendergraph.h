@@ -0,0 +1,147 @@
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include "devicememoryallocator.h"
+#include "src/utility.h"
+#include <memory>
+
+class RenderGraph final
+{
+public:
+    enum AttachmentType {
+        COLOR_ATTACHMENT = 0,
+        DEPTH_ATTACHMENT = 1
+    };
+    struct MemoryStatistics final
+    {
+        VkDeviceSize requestedBytes;
+        VkDeviceSize allocatedBytes;
+        VkDeviceSize lazilyAllocatedBytes;
+        uint32_t transientCount;
+        uint32_t aliasSlotCount;
+        VkDeviceSize storedBytesPerFrame;
+        VkDeviceSize discardedColorBytesPerFrame;
+        VkDeviceSize discardedDepthBytesPerFrame;
+    };
+private:
+    enum Usage {
+        COLOR_WRITE = 0,
+        RESOLVE_WRITE = 1,
+        DEPTH_WRITE = 2,
+        DEPTH_READ = 3,
+        INPUT_READ = 4
+    };
+    struct Attachment final
+    {
+        std::string name;
+        VkFormat format;
+        VkSampleCountFlagBits samples;
+        AttachmentType type;
+        bool external;
+        VkImageLayout finalLayout;
+        VkClearValue clearValue;
+    };
+    struct Pass final
+    {
+        std::string name;
+        std::vector <uint32_t> colorWrites;
+        std::vector <int32_t> resolveWrites;
+        std::vector <uint32_t> inputReads;
+        int32_t depthAttachment;
+        bool depthWrite;
+    };
+    struct Access final
+    {
+        VkPipelineStageFlags stages;
+        VkAccessFlags access;
+        VkImageLayout layout;
+        bool write;
+    };
+    struct Lifetime final
+    {
+        int32_t firstSubpass;
+        int32_t lastSubpass;
+        Usage firstUsage;
+        Access first;
+        Access last;
+        VkImageUsageFlags imageUsage;
+    };
+public:
+    RenderGraph(VkDevice *device);
+public:
+    ~RenderGraph() = default;
+    RenderGraph(const RenderGraph & other) = delete;
+    RenderGraph & operator=(const RenderGraph & other) = delete;
+    RenderGraph(const RenderGraph && other) = delete;
+    RenderGraph & operator=(const RenderGraph && other) = delete;
+public:
+    [[nodiscard]] uint32_t addExternalAttachment(const std::string & name, VkFormat format, VkImageLayout finallayout);
+    [[nodiscard]] uint32_t addTransientAttachment(
+            const std::string & name,
+            VkFormat format,
+            AttachmentType type,
+            VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT
+            );
+    [[nodiscard]] uint32_t addPass(const std::string & name);
+    void writeColor(uint32_t pass, uint32_t attachment, int32_t resolveattachment = -1);
+    void writeDepth(uint32_t pass, uint32_t attachment);
+    void readDepth(uint32_t pass, uint32_t attachment);
+    void readInput(uint32_t pass, uint32_t attachment);
+    void setOutput(uint32_t attachment);
+    void compile();
+    void createAttachments(VkExtent2D extent, const std::shared_ptr<DeviceMemoryAllocator> & memoryallocator);
+    void releaseAttachments(
+            std::vector<VkImage> & retiredimages,
+            std::vector<VkImageView> & retiredviews,
+            std::vector<DeviceMemoryAllocator::Allocation> & retiredallocations
+            ) noexcept;
+    [[nodiscard]] std::vector<VkImageView> getFramebufferAttachments(VkImageView externalview) const;
+    [[nodiscard]] const std::vector<VkClearValue> & getClearValues() const noexcept;
+    [[nodiscard]] VkRenderPass getRenderPass() const noexcept;
+    [[nodiscard]] uint32_t getSubpassCount() const noexcept;
+    [[nodiscard]] uint32_t getSubpass(uint32_t pass) const;
+    [[nodiscard]] VkSampleCountFlagBits getSamples(uint32_t pass) const;
+    [[nodiscard]] bool isCulled(uint32_t pass) const;
+    [[nodiscard]] size_t getDependencyCount() const noexcept;
+    [[nodiscard]] size_t getPreserveCount() const noexcept;
+    [[nodiscard]] const MemoryStatistics & getMemoryStatistics() const noexcept;
+    void cleanup() noexcept;
+private:
+    [[nodiscard]] static bool hasStencil(VkFormat format) noexcept;
+    [[nodiscard]] static VkDeviceSize getTexelSize(VkFormat format) noexcept;
+    [[nodiscard]] static Access getAccess(Usage usage, AttachmentType type) noexcept;
+    [[nodiscard]] std::vector<std::pair<uint32_t, Usage>> getUsages(const Pass & pass) const;
+    [[nodiscard]] uint32_t checkAttachment(uint32_t attachment, AttachmentType type) const;
+    [[nodiscard]] Pass & getPass(uint32_t pass);
+    void addDependency(
+            uint32_t srcsubpass,
+            uint32_t dstsubpass,
+            VkPipelineStageFlags srcstages,
+            VkAccessFlags srcaccess,
+            VkPipelineStageFlags dststages,
+            VkAccessFlags dstaccess
+            );
+    void destroyAttachments() noexcept;
+private:
+    VkDevice *logicalDevice;
+    std::shared_ptr <DeviceMemoryAllocator> memoryAllocator;
+    std::vector <Attachment> attachments;
+    std::vector <Pass> passes;
+    int32_t output;
+    bool compiled;
+    std::vector <int32_t> subpassIndices;
+    std::vector <int32_t> attachmentIndices;
+    std::vector <uint32_t> usedAttachments;
+    std::vector <Lifetime> lifetimes;
+    std::vector <int32_t> aliasSlots;
+    std::vector <VkSubpassDependency> dependencies;
+    std::vector <VkClearValue> clearValues;
+    VkRenderPass renderPass;
+    size_t preserveCount;
+    std::vector <VkImage> images;
+    std::vector <VkImageView> views;
+    std::vector <DeviceMemoryAllocator::Allocation> allocations;
+    MemoryStatistics memoryStatistics;
+};
+
+#endif // RENDERGRAPH_H
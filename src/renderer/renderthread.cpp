@@ -0,0 +1,70 @@
+#include "renderthread.h"
+
+/*!
+        \class RenderThread
+        \brief The RenderThread class drives one logical device's render loop on a thread of its own.
+
+        The thread draws frames back to back until it is stopped, so each device it runs is throttled only
+        by its own frames in flight. Logical devices share nothing but the physical device, so threads
+        driving different devices never wait on each other. Nothing else may touch the device while its
+        thread runs. The first exception thrown by a frame ends the loop and is rethrown by stop().
+*/
+
+RenderThread::RenderThread(PhysicalDeviceInfo *physicaldeviceinfo, uint32_t logicaldeviceindex)
+    : physicalDeviceInfo(physicaldeviceinfo),
+      logicalDeviceIndex(logicaldeviceindex),
+      stopping(false),
+      running(true),
+      frameCount(0),
+      error(nullptr)
+{
+    if (!physicaldeviceinfo)
+        throw std::runtime_error("Null physical device passed to RenderThread!");
+    if (logicaldeviceindex >= physicaldeviceinfo->getLogicalDeviceCount())
+        throw std::runtime_error("Invalid logical device index!");
+    thread = std::thread(&RenderThread::renderLoop, this);
+}
+
+RenderThread::~RenderThread(){
+    try {
+        stop();
+    } catch (...) {
+        //Whoever wanted the error should have stopped the thread themselves...
+    }
+}
+
+void RenderThread::stop(){
+    stopping.store(true, std::memory_order_relaxed);
+    if (thread.joinable())
+        thread.join();
+    if (error){
+        auto rethrown = error;
+        error = nullptr;
+        std::rethrow_exception(rethrown);
+    }
+}
+
+bool RenderThread::isRunning() const noexcept{
+    return running.load(std::memory_order_acquire);
+}
+
+uint64_t RenderThread::getFrameCount() const noexcept{
+    return frameCount.load(std::memory_order_relaxed);
+}
+
+uint32_t RenderThread::getLogicalDeviceIndex() const noexcept{
+    return logicalDeviceIndex;
+}
+
+void RenderThread::renderLoop() noexcept{
+    try {
+        while (!stopping.load(std::memory_order_relaxed)){
+            physicalDeviceInfo->draw(logicalDeviceIndex);
+            frameCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    } catch (...) {
+        //Read by stop() once the thread has been joined...
+        error = std::current_exception();
+    }
+    running.store(false, std::memory_order_release);
+}
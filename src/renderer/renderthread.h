@@ -0,0 +1,36 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include "physicaldeviceinfo.h"
+#include <atomic>
+#include <thread>
+#include <exception>
+
+class RenderThread final
+{
+public:
+    RenderThread(PhysicalDeviceInfo *physicaldeviceinfo, uint32_t logicaldeviceindex);
+    ~RenderThread();
+public:
+    RenderThread(const RenderThread & other) = delete;
+    RenderThread & operator=(const RenderThread & other) = delete;
+    RenderThread(const RenderThread && other) = delete;
+    RenderThread & operator=(const RenderThread && other) = delete;
+public:
+    void stop();
+    [[nodiscard]] bool isRunning() const noexcept;
+    [[nodiscard]] uint64_t getFrameCount() const noexcept;
+    [[nodiscard]] uint32_t getLogicalDeviceIndex() const noexcept;
+private:
+    void renderLoop() noexcept;
+private:
+    PhysicalDeviceInfo *physicalDeviceInfo;
+    uint32_t logicalDeviceIndex;
+    std::atomic <bool> stopping;
+    std::atomic <bool> running;
+    std::atomic <uint64_t> frameCount;
+    std::exception_ptr error;
+    std::thread thread;
+};
+
+#endif // RENDERTHREAD_H
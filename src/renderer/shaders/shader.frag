@@ -3,8 +3,18 @@
 
 layout(location = 0) in vec3 fragColor;
 
+//Pushed with every draw, must match DrawConstants...
+layout(push_constant) uniform Draw{
+    vec4 color;
+} draw;
+
+//Variants without the tint skip the pushed color, set through PipelineState::specialization...
+layout(constant_id = 0) const bool TINT = true;
+
 layout(location = 0) out vec4 outColor;
 
 void main(){
     outColor = vec4(fragColor, 1.0);
+    if (TINT)
+        outColor *= draw.color;
 }
@@ -1,25 +1,22 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
+//Invariant so the depth pre-pass and the colour pass agree exactly on depth...
 out gl_PerVertex{
-    vec4 gl_Position;
+    invariant vec4 gl_Position;
 };
 
-layout(location = 0) out vec3 fragColor;
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+//Per object data from the uniform ring, xy offset and scale...
+layout(set = 0, binding = 0) uniform Object{
+    vec4 transform;
+} object;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+layout(location = 0) out vec3 fragColor;
 
 void main(){
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    gl_Position = vec4(inPosition.xy * object.transform.z + object.transform.xy, inPosition.z, 1.0);
+    fragColor = inColor;
 }
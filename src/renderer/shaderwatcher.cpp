@@ -0,0 +1,151 @@
+#include "shaderwatcher.h"
+#include "src/utility.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+/*!
+        \class ShaderWatcher
+        \brief The ShaderWatcher class notices when compiled shaders in a directory change.
+
+        A background thread waits on inotify where it is available and falls back to polling the
+        directory's modification times every SHADER_WATCH_INTERVAL_MS otherwise. Only graphics .spv
+        files are watched. takeChanges() reports a change once the directory has been quiet for
+        SHADER_RELOAD_DEBOUNCE_MS, so a shader compiler writing a file in several steps only
+        triggers one reload.
+*/
+
+ShaderWatcher::ShaderWatcher(const std::string & shaderdirectory)
+    : directory(shaderdirectory),
+      stopping(false),
+      changeGeneration(0),
+      lastChangeTime(0),
+      consumedGeneration(0),
+      notifyDescriptor(-1),
+      watchDescriptor(-1)
+{
+    if (!fs::is_directory(directory))
+        throw std::runtime_error("Shader directory to watch does not exist!");
+
+#ifdef __linux__
+    //Prefer being told about changes over polling for them...
+    notifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyDescriptor >= 0){
+        watchDescriptor = inotify_add_watch(notifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+        if (watchDescriptor < 0){
+            close(notifyDescriptor);
+            notifyDescriptor = -1;
+        }
+    }
+#endif
+
+    //Remember what the directory looks like now so the first poll doesn't report every file...
+    if (notifyDescriptor < 0)
+        (void)scanDirectory();
+    watcher = std::thread(&ShaderWatcher::watchLoop, this);
+}
+
+ShaderWatcher::~ShaderWatcher(){
+    stopping = true;
+    if (watcher.joinable())
+        watcher.join();
+#ifdef __linux__
+    if (notifyDescriptor >= 0){
+        inotify_rm_watch(notifyDescriptor, watchDescriptor);
+        close(notifyDescriptor);
+    }
+#endif
+}
+
+bool ShaderWatcher::takeChanges() noexcept{
+    auto generation = changeGeneration.load(std::memory_order_acquire);
+    if (generation == consumedGeneration)
+        return false;
+
+    //Wait for the directory to settle before reporting it...
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (now - lastChangeTime.load(std::memory_order_acquire) < SHADER_RELOAD_DEBOUNCE_MS)
+        return false;
+    consumedGeneration = generation;
+    return true;
+}
+
+bool ShaderWatcher::isUsingNotifications() const noexcept{
+    return notifyDescriptor >= 0;
+}
+
+void ShaderWatcher::watchLoop(){
+    while (!stopping){
+        auto changed = false;
+        if (notifyDescriptor >= 0){
+            changed = waitForNotifications();
+        }else{
+            std::this_thread::sleep_for(std::chrono::milliseconds(SHADER_WATCH_INTERVAL_MS));
+            changed = scanDirectory();
+        }
+        if (changed)
+            markChanged();
+    }
+}
+
+bool ShaderWatcher::waitForNotifications(){
+#ifdef __linux__
+    //Wake up regularly so the destructor never waits long to join...
+    pollfd descriptor = {notifyDescriptor, POLLIN, 0};
+    if (poll(&descriptor, 1, SHADER_WATCH_INTERVAL_MS) <= 0)
+        return false;
+
+    //Read every queued event, the buffer must be aligned for inotify_event...
+    alignas(inotify_event) char buffer[4096];
+    auto changed = false;
+    for (;;){
+        auto length = read(notifyDescriptor, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+        for (auto offset = 0L; offset < length;){
+            auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if ((event->mask & IN_Q_OVERFLOW) || (event->len && isWatchedShader(event->name)))
+                changed = true;
+            offset += static_cast<long>(sizeof(inotify_event) + event->len);
+        }
+    }
+    return changed;
+#else
+    return false;
+#endif
+}
+
+bool ShaderWatcher::scanDirectory(){
+    //Files may come and go while we look, so errors just skip the entry until the next scan...
+    std::error_code error;
+    std::map <std::string, std::pair<int64_t, uintmax_t>> stamps;
+    for (auto it = fs::directory_iterator(directory, error); !error && it != fs::directory_iterator(); it.increment(error)){
+        auto name = it->path().filename().u8string();
+        if (!isWatchedShader(name))
+            continue;
+        auto time = fs::last_write_time(it->path(), error);
+        auto size = fs::file_size(it->path(), error);
+        if (error){
+            error.clear();
+            continue;
+        }
+        stamps[name] = std::make_pair(static_cast<int64_t>(time.time_since_epoch().count()), size);
+    }
+    if (error || stamps == fileStamps)
+        return false;
+    fileStamps.swap(stamps);
+    return true;
+}
+
+void ShaderWatcher::markChanged() noexcept{
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    lastChangeTime.store(now, std::memory_order_release);
+    changeGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool ShaderWatcher::isWatchedShader(const std::string & filename){
+    //Compute pipelines are built separately and aren't reloaded...
+    return filename.find(".spv") != std::string::npos && filename.find(COMPUTE_SHADER_SUBSTRING) == std::string::npos;
+}
@@ -0,0 +1,42 @@
+#ifndef SHADERWATCHER_H
+#define SHADERWATCHER_H
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <map>
+#include <string>
+#include <cstdint>
+
+class ShaderWatcher final
+{
+public:
+    ShaderWatcher(const std::string & shaderdirectory);
+    ~ShaderWatcher();
+public:
+    ShaderWatcher(const ShaderWatcher & other) = delete;
+    ShaderWatcher & operator=(const ShaderWatcher & other) = delete;
+    ShaderWatcher(const ShaderWatcher && other) = delete;
+    ShaderWatcher & operator=(const ShaderWatcher && other) = delete;
+public:
+    [[nodiscard]] bool takeChanges() noexcept;
+    [[nodiscard]] bool isUsingNotifications() const noexcept;
+private:
+    void watchLoop();
+    [[nodiscard]] bool waitForNotifications();
+    [[nodiscard]] bool scanDirectory();
+    void markChanged() noexcept;
+    [[nodiscard]] static bool isWatchedShader(const std::string & filename);
+private:
+    std::string directory;
+    std::thread watcher;
+    std::atomic <bool> stopping;
+    std::atomic <uint64_t> changeGeneration;
+    std::atomic <int64_t> lastChangeTime;
+    uint64_t consumedGeneration;
+    std::map <std::string, std::pair<int64_t, uintmax_t>> fileStamps;
+    int notifyDescriptor;
+    int watchDescriptor;
+};
+
+#endif // SHADERWATCHER_H
@@ -0,0 +1,102 @@
+#include "specializationconstants.h"
+#include <functional>
+
+/*!
+        \class SpecializationConstants
+        \brief The SpecializationConstants class holds typed values for a shader's constant_id constants.
+
+        Every value is a 32 bit word, which covers the int, uint, float and bool constants GLSL declares with
+        constant_id. Bools are stored as VkBool32. Entries are kept sorted by constant id and setting an id
+        twice replaces its value, so two sets holding the same values compare and hash equal whatever order
+        they were filled in. That is what lets them be part of a pipeline cache key.
+
+        The data lives inside the object with a fixed capacity, so copying a set never allocates. getInfo()
+        points into the object and is only valid for as long as it lives. The same info can be given to
+        every stage of a pipeline, because ids a stage doesn't declare are ignored.
+*/
+
+void SpecializationConstants::set(uint32_t constantid, uint32_t value){
+    setWord(constantid, value);
+}
+
+void SpecializationConstants::set(uint32_t constantid, int32_t value){
+    uint32_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    setWord(constantid, word);
+}
+
+void SpecializationConstants::set(uint32_t constantid, float value){
+    uint32_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    setWord(constantid, word);
+}
+
+void SpecializationConstants::set(uint32_t constantid, bool value){
+    setWord(constantid, value ? VK_TRUE : VK_FALSE);
+}
+
+bool SpecializationConstants::contains(uint32_t constantid) const noexcept{
+    for (auto i = 0U; i < count; i++){
+        if (entries[i].constantID == constantid)
+            return true;
+    }
+    return false;
+}
+
+uint32_t SpecializationConstants::getCount() const noexcept{
+    return count;
+}
+
+VkSpecializationInfo SpecializationConstants::getInfo() const noexcept{
+    VkSpecializationInfo info = {};
+    info.mapEntryCount = count;
+    info.pMapEntries = count ? entries.data() : nullptr;
+    info.dataSize = count * sizeof(uint32_t);
+    info.pData = count ? data.data() : nullptr;
+    return info;
+}
+
+size_t SpecializationConstants::getHash() const noexcept{
+    size_t hash = count;
+    for (auto i = 0U; i < count; i++){
+        auto packed = static_cast<uint64_t>(entries[i].constantID) << 32 | data[i];
+        hash ^= std::hash<uint64_t>()(packed) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+bool SpecializationConstants::operator==(const SpecializationConstants & other) const noexcept{
+    if (count != other.count)
+        return false;
+    for (auto i = 0U; i < count; i++){
+        if (entries[i].constantID != other.entries[i].constantID || data[i] != other.data[i])
+            return false;
+    }
+    return true;
+}
+
+void SpecializationConstants::setWord(uint32_t constantid, uint32_t word){
+    //Find the id's sorted position, replacing the value if it's already there...
+    auto index = 0U;
+    while (index < count && entries[index].constantID < constantid)
+        index++;
+    if (index < count && entries[index].constantID == constantid){
+        data[index] = word;
+        return;
+    }
+    if (count >= SPECIALIZATION_MAX_CONSTANTS)
+        throw std::runtime_error("Too many specialization constants!");
+
+    //Shift the later entries up, each entry's data stays at its own slot...
+    for (auto i = count; i > index; i--){
+        entries[i] = entries[i - 1];
+        data[i] = data[i - 1];
+    }
+    for (auto i = index; i <= count; i++){
+        entries[i].offset = i * sizeof(uint32_t);
+        entries[i].size = sizeof(uint32_t);
+    }
+    entries[index].constantID = constantid;
+    data[index] = word;
+    count++;
+}
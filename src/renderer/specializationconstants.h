@@ -0,0 +1,33 @@
+#ifndef SPECIALIZATIONCONSTANTS_H
+#define SPECIALIZATIONCONSTANTS_H
+
+#include "src/utility.h"
+
+#define SPECIALIZATION_MAX_CONSTANTS 16
+
+class SpecializationConstants final
+{
+public:
+    SpecializationConstants() = default;
+    ~SpecializationConstants() = default;
+    SpecializationConstants(const SpecializationConstants & other) = default;
+    SpecializationConstants & operator=(const SpecializationConstants & other) = default;
+public:
+    void set(uint32_t constantid, uint32_t value);
+    void set(uint32_t constantid, int32_t value);
+    void set(uint32_t constantid, float value);
+    void set(uint32_t constantid, bool value);
+    [[nodiscard]] bool contains(uint32_t constantid) const noexcept;
+    [[nodiscard]] uint32_t getCount() const noexcept;
+    [[nodiscard]] VkSpecializationInfo getInfo() const noexcept;
+    [[nodiscard]] size_t getHash() const noexcept;
+    [[nodiscard]] bool operator==(const SpecializationConstants & other) const noexcept;
+private:
+    void setWord(uint32_t constantid, uint32_t word);
+private:
+    std::array <VkSpecializationMapEntry, SPECIALIZATION_MAX_CONSTANTS> entries = {};
+    std::array <uint32_t, SPECIALIZATION_MAX_CONSTANTS> data = {};
+    uint32_t count = 0;
+};
+
+#endif // SPECIALIZATIONCONSTANTS_H
@@ -1,46 +1,118 @@
 #include "swapchain.h"
+#include <algorithm>
 
-SwapChain::SwapChain(VkDevice *device)
+SwapChain::SwapChain(
+        VkDevice *device,
+        VkPhysicalDevice physicaldevice,
+        const std::shared_ptr<DeviceMemoryAllocator> & memoryallocator,
+        VkPipelineCache pipelinecache,
+        const TimestampQueryPool & timestampquerypool,
+        ThreadPool *threadpool,
+        DescriptorLayoutCache *layoutcache
+        )
     : logicalDevice(device),
+      physicalDevice(physicaldevice),
+      memoryAllocator(memoryallocator),
       swapChain(nullptr),
-      graphicsPipeline(device),
+      graphicsPipeline(device, pipelinecache, threadpool, layoutcache),
+      timestampQueryPool(timestampquerypool),
+      presented(false),
+      framesInFlight(DEFAULT_FRAMES_IN_FLIGHT),
+      currentFrame(0),
+      submittedFrames(0),
+      completedFrames(0),
+      nextOffscreenImage(0),
+      offscreen(false),
       initialised(false)
 {
     swapChainCreateInfo = {};
     if (!device)
         throw std::runtime_error("Null device passed to SwapChain!");
+    if (!memoryallocator)
+        throw std::runtime_error("Null memory allocator passed to SwapChain!");
 }
 
-void SwapChain::startRenderPass(std::vector<VkCommandBuffer> &graphicsCommandBuffers) noexcept{
-    for (auto i = 0U; i < graphicsCommandBuffers.size(); i++)
-        graphicsPipeline.startRenderPass(swapChainFramebuffers.at(i), swapChainExtent, graphicsCommandBuffers[i]);
+void SwapChain::recordCommandBuffer(
+        VkCommandBuffer &commandbuffer,
+        uint32_t imageindex,
+        const std::vector<Mesh> &meshes,
+        const std::vector<VkCommandBuffer> *secondarybuffers,
+        const GraphicsPipeline::DrawUniforms *uniforms,
+        const IndirectDrawList *indirectdraws
+        )
+{
+    //Each image's command buffer times itself with its own range of queries...
+    timestampQueryPool.resetQueries(commandbuffer, imageindex);
+    timestampQueryPool.beginScope(commandbuffer, imageindex, TimestampQueryPool::SUBMIT_SCOPE);
+    graphicsPipeline.startRenderPass(swapChainFramebuffers.at(imageindex), swapChainExtent, commandbuffer, meshes, secondarybuffers, &timestampQueryPool, imageindex, uniforms, indirectdraws);
+}
+
+void SwapChain::recordSecondaryCommandBuffer(
+        VkCommandBuffer &commandbuffer,
+        uint32_t imageindex,
+        const Mesh *meshes,
+        size_t meshcount,
+        const GraphicsPipeline::DrawUniforms *uniforms,
+        const IndirectDrawList *indirectdraws,
+        bool recordindirect
+        )
+{
+    //Safe to call from several threads at once as long as each has its own command buffer...
+    graphicsPipeline.recordSecondaryCommandBuffer(commandbuffer, swapChainFramebuffers.at(imageindex), swapChainExtent, meshes, meshcount, imageindex, uniforms, indirectdraws, recordindirect);
 }
 
 void SwapChain::initializeSwapChain(VkSwapchainCreateInfoKHR *swapchaincreateinfo){
     if (!swapchaincreateinfo)
         throw std::runtime_error("Swap chain create info is null!");
 
-    //Reuse old swapchain if one already exists...
-    swapchaincreateinfo->oldSwapchain = swapChain;
+    //Without a surface we render into our own ring of offscreen images instead...
+    offscreen = swapchaincreateinfo->surface == VK_NULL_HANDLE;
+    createImages(swapchaincreateinfo);
 
-    //Copy the create info...THIS MAY BREAK WITH SWAPCHAIN RECREATION!!!
-    swapChainCreateInfo = *swapchaincreateinfo;
+    //Sync objects and timestamp queries outlive swapchain recreation...
+    if (inFlightFences.empty())
+        createSyncObjects(framesInFlight);
+    timestampQueryPool.create(static_cast<uint32_t>(swapChainImages.size()));
 
-    //Create swapchain...
-    if (vkCreateSwapchainKHR(*logicalDevice, swapchaincreateinfo, nullptr, &swapChain) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create swap chain!");
+    //Create renderpass now since we'll need it to create framebuffers, offscreen images are left ready to be copied out...
+    graphicsPipeline.createRenderpass(swapChainImageFormat, offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    createFramebuffers();
 
-    //Get swapchain images...
-    auto imageCount = 0U;
-    vkGetSwapchainImagesKHR(*logicalDevice, swapChain, &imageCount, nullptr);
-    swapChainImages.resize(imageCount);
-    vkGetSwapchainImagesKHR(*logicalDevice, swapChain, &imageCount, swapChainImages.data());
+    //Set up the graphics pipeline...
+    graphicsPipeline.createPipelines();
+}
+
+void SwapChain::createImages(VkSwapchainCreateInfoKHR *swapchaincreateinfo){
+    if (offscreen){
+        swapChainCreateInfo = *swapchaincreateinfo;
+        createOffscreenImages(swapchaincreateinfo);
+    }else{
+        //Reuse old swapchain if one already exists, the presentation engine can hand its images over...
+        swapchaincreateinfo->oldSwapchain = swapChain;
+
+        //Copy the create info, oldSwapchain is set again before every recreation...
+        swapChainCreateInfo = *swapchaincreateinfo;
+
+        //Create swapchain...
+        if (vkCreateSwapchainKHR(*logicalDevice, swapchaincreateinfo, nullptr, &swapChain) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create swap chain!");
+
+        //Get swapchain images...
+        auto imageCount = 0U;
+        vkGetSwapchainImagesKHR(*logicalDevice, swapChain, &imageCount, nullptr);
+        swapChainImages.resize(imageCount);
+        vkGetSwapchainImagesKHR(*logicalDevice, swapChain, &imageCount, swapChainImages.data());
+    }
 
     //Store image format, extent and set initialised (for use in the destructor)...
     swapChainImageFormat = swapchaincreateinfo->imageFormat;
     swapChainExtent = swapchaincreateinfo->imageExtent;
     initialised = true;
 
+    //Each image index keeps the fence of its last frame, even across recreation, since the command buffer
+    //and uniform region with that index may still be in use by it...
+    imagesInFlight.resize(swapChainImages.size(), VK_NULL_HANDLE);
+
     //Create swapchain image views...
     swapChainImageViews.resize(swapChainImages.size());
     for (auto i = 0U; i < swapChainImages.size(); i++){
@@ -62,51 +134,287 @@ void SwapChain::initializeSwapChain(VkSwapchainCreateInfoKHR *swapchaincreateinf
             throw std::runtime_error("Failed to create image views!");
         }
     }
+}
+
+void SwapChain::createOffscreenImages(VkSwapchainCreateInfoKHR *swapchaincreateinfo){
+    //Create the images that stand in for swapchain images...
+    swapChainImages.resize(swapchaincreateinfo->minImageCount);
+    offscreenImageAllocations.resize(swapChainImages.size());
+    nextOffscreenImage = 0;
+    for (auto i = 0U; i < swapChainImages.size(); i++){
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = swapchaincreateinfo->imageFormat;
+        imageInfo.extent = {swapchaincreateinfo->imageExtent.width, swapchaincreateinfo->imageExtent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = swapchaincreateinfo->imageArrayLayers;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = swapchaincreateinfo->imageUsage;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (vkCreateImage(*logicalDevice, &imageInfo, nullptr, &swapChainImages[i]) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create offscreen image!");
+
+        //Back each image with device local memory from the allocator...
+        offscreenImageAllocations[i] = memoryAllocator->allocateImage(swapChainImages[i], imageInfo.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+}
 
-    //Create renderpass now since we'll need it to create framebuffers...
-    graphicsPipeline.createRenderpass(swapChainImageFormat);
+void SwapChain::createFramebuffers(){
+    //Transient attachments are shared by every framebuffer, only the swapchain image differs...
+    auto & rendergraph = graphicsPipeline.getRenderGraph();
+    rendergraph.createAttachments(swapChainExtent, memoryAllocator);
 
-    //Create framebufffers for all swapchain image views...
+    //Create framebuffers for all swapchain image views...
     swapChainFramebuffers.resize(swapChainImageViews.size());
     for (auto i = 0U; i < swapChainImageViews.size(); i++){
-        VkImageView attachments[] = {
-            swapChainImageViews[i]
-        };
+        auto attachments = rendergraph.getFramebufferAttachments(swapChainImageViews[i]);
         VkFramebufferCreateInfo framebufferInfo = {};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebufferInfo.renderPass = graphicsPipeline.getRenderPass();
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebufferInfo.pAttachments = attachments.data();
         framebufferInfo.width = swapChainExtent.width;
         framebufferInfo.height = swapChainExtent.height;
         framebufferInfo.layers = 1;
         if (vkCreateFramebuffer(*logicalDevice, &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS)
             throw std::runtime_error("failed to create framebuffer!");
     }
+}
 
-    //Set up the graphics pipeline...
-    graphicsPipeline.initializeFixedFunctions(swapChainExtent);
+bool SwapChain::recreateSwapChain(VkExtent2D extent){
+    //A surface dictates its own extent, offscreen images take the requested one or keep theirs...
+    auto createinfo = swapChainCreateInfo;
+    if (!offscreen){
+        VkSurfaceCapabilitiesKHR capabilities;
+        if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, createinfo.surface, &capabilities) != VK_SUCCESS)
+            throw std::runtime_error("Could not get information about the physical device's surface capabilities!");
+        if (capabilities.currentExtent.width != (std::numeric_limits<uint32_t>::max)()){
+            extent = capabilities.currentExtent;
+        }else{
+            if (!extent.width || !extent.height)
+                extent = swapChainExtent;
+            extent.width = (std::max)(capabilities.minImageExtent.width, (std::min)(capabilities.maxImageExtent.width, extent.width));
+            extent.height = (std::max)(capabilities.minImageExtent.height, (std::min)(capabilities.maxImageExtent.height, extent.height));
+        }
+        createinfo.preTransform = capabilities.currentTransform;
+    }else if (!extent.width || !extent.height){
+        extent = swapChainExtent;
+    }
+
+    //A minimised window has no extent, there's nothing to recreate until it comes back...
+    if (!extent.width || !extent.height)
+        return false;
+    createinfo.imageExtent = extent;
+
+    //Frames already submitted keep drawing into the old images, so they retire along with that frame rather
+    //than waiting for the device. The old swapchain is passed on as oldSwapchain...
+    RetiredSwapChain retired = {};
+    retired.swapChain = offscreen ? VK_NULL_HANDLE : swapChain;
+    if (offscreen){
+        retired.images = swapChainImages;
+        retired.allocations = offscreenImageAllocations;
+    }
+    retired.imageViews = swapChainImageViews;
+    retired.framebuffers = swapChainFramebuffers;
+    retired.lastFrame = submittedFrames;
+
+    //The render graph's transient attachments are sized to the old extent and still used by those frames...
+    graphicsPipeline.getRenderGraph().releaseAttachments(retired.images, retired.imageViews, retired.allocations);
+    retiredSwapChains.push_back(retired);
+    auto format = swapChainImageFormat;
+    auto imagecount = swapChainImages.size();
+    createImages(&createinfo);
+
+    //Viewport and scissor are dynamic, so the render pass and pipelines only have to change with the format...
+    if (swapChainImageFormat != format){
+        vkDeviceWaitIdle(*logicalDevice);
+        completedFrames = submittedFrames;
+        (void)finishShaderReload(true);
+        destroyRetiredPipelines();
+        graphicsPipeline.cleanup(false);
+        graphicsPipeline.createRenderpass(swapChainImageFormat, offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        graphicsPipeline.createPipelines();
+    }
+
+    //Queries are laid out per image, a different image count needs a new pool once nothing can write the old one...
+    if (swapChainImages.size() != imagecount){
+        vkDeviceWaitIdle(*logicalDevice);
+        completedFrames = submittedFrames;
+        timestampQueryPool.create(static_cast<uint32_t>(swapChainImages.size()));
+    }
+    createFramebuffers();
+    destroyRetiredSwapChains();
+    return true;
 }
 
-void SwapChain::recreateSwapChain(){
-    cleanup(false);
+void SwapChain::destroyRetiredSwapChains(bool all) noexcept{
+    for (auto i = 0U; i < retiredSwapChains.size();){
+        const auto & retired = retiredSwapChains[i];
+        if (!all && retired.lastFrame > completedFrames){
+            i++;
+            continue;
+        }
+        for (auto buffer : retired.framebuffers)
+            vkDestroyFramebuffer(*logicalDevice, buffer, nullptr);
+        for (auto view : retired.imageViews)
+            vkDestroyImageView(*logicalDevice, view, nullptr);
+        for (auto image : retired.images)
+            vkDestroyImage(*logicalDevice, image, nullptr);
+        for (const auto & allocation : retired.allocations)
+            memoryAllocator->free(allocation);
+        if (retired.swapChain != VK_NULL_HANDLE)
+            vkDestroySwapchainKHR(*logicalDevice, retired.swapChain, nullptr);
+        retiredSwapChains.erase(retiredSwapChains.begin() + i);
+    }
+}
+
+void SwapChain::setDepthMode(GraphicsPipeline::DepthMode depthmode, VkFormat depthformat){
+    if (depthmode != GraphicsPipeline::NO_DEPTH)
+        depthformat = chooseDepthFormat(depthformat);
+    if (depthmode == graphicsPipeline.getDepthMode() && (depthmode == GraphicsPipeline::NO_DEPTH || depthformat == graphicsPipeline.getDepthFormat()))
+        return;
+    graphicsPipeline.setDepthMode(depthmode, depthformat);
+    rebuildRenderPass();
+}
+
+VkFormat SwapChain::chooseDepthFormat(VkFormat requestedformat) const{
+    //Without a request take the most precise format, every device can render to at least one of these...
+    std::vector <VkFormat> candidates = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM};
+    if (requestedformat != VK_FORMAT_UNDEFINED)
+        candidates = {requestedformat};
+    for (auto format : candidates){
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+        if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+            return format;
+    }
+    throw std::runtime_error("The physical device can't use this depth format as an attachment!");
+}
+
+void SwapChain::setSampleCount(VkSampleCountFlagBits samplecount){
+    if (!(getSupportedSampleCounts() & samplecount))
+        throw std::runtime_error("The physical device can't render with this many samples!");
+    if (samplecount == graphicsPipeline.getSampleCount())
+        return;
+    graphicsPipeline.setSampleCount(samplecount);
+    rebuildRenderPass();
+}
+
+VkSampleCountFlags SwapChain::getSupportedSampleCounts() const{
+    //Colour and depth share a subpass, so a count has to work for both...
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
+}
+
+void SwapChain::rebuildRenderPass(){
+    if (!initialised)
+        return;
+
+    //The render pass changes shape, so the framebuffers and pipelines built on it go too, once nothing uses them...
+    vkDeviceWaitIdle(*logicalDevice);
+    completedFrames = submittedFrames;
+    (void)finishShaderReload(true);
+    destroyRetiredPipelines();
+    destroyRetiredSwapChains();
+    for (auto buffer : swapChainFramebuffers)
+        vkDestroyFramebuffer(*logicalDevice, buffer, nullptr);
+    swapChainFramebuffers.clear();
     graphicsPipeline.cleanup(false);
-    initializeSwapChain(&swapChainCreateInfo);
+    graphicsPipeline.createRenderpass(swapChainImageFormat, offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    createFramebuffers();
+    graphicsPipeline.createPipelines();
 }
 
-void SwapChain::cleanup(bool destroyswapchain) noexcept{
+void SwapChain::cleanup() noexcept{
+    //A reload still building on its worker must finish before the device goes away...
+    (void)finishShaderReload(true);
+    destroyRetiredPipelines(true);
+    destroyRetiredSwapChains(true);
     if (initialised){
-        //Sometimes we want to reuse the swapchain...
-        if (destroyswapchain)
+        if (!offscreen)
             vkDestroySwapchainKHR(*logicalDevice, swapChain, nullptr);
-
-        //Nothing reusable here...
         for (auto view : swapChainImageViews)
             vkDestroyImageView(*logicalDevice, view, nullptr);
         for (auto buffer : swapChainFramebuffers)
             vkDestroyFramebuffer(*logicalDevice, buffer, nullptr);
+
+        //Offscreen images are ours, not the swapchain's...
+        if (offscreen){
+            for (auto image : swapChainImages)
+                vkDestroyImage(*logicalDevice, image, nullptr);
+            for (const auto & allocation : offscreenImageAllocations)
+                memoryAllocator->free(allocation);
+            offscreenImageAllocations.clear();
+        }
+        timestampQueryPool.cleanup();
+        graphicsPipeline.cleanup();
         initialised = false;
     }
+    destroySyncObjects();
+}
+
+void SwapChain::createSyncObjects(uint32_t framesinflight){
+    if (!framesinflight || framesinflight > MAX_FRAMES_IN_FLIGHT_ALLOWED)
+        throw std::runtime_error("Invalid number of frames in flight requested!");
+    framesInFlight = framesinflight;
+    currentFrame = 0;
+
+    //Create one set of semaphores and a fence for every frame that may be in flight...
+    imageAvailableSemaphores.resize(framesInFlight);
+    renderFinishedSemaphores.resize(framesInFlight);
+    inFlightFences.resize(framesInFlight);
+    slotFrames.assign(framesInFlight, 0);
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;     //Signaled so the first wait on each slot returns immediately...
+    for (auto i = 0U; i < framesInFlight; i++){
+        if (vkCreateSemaphore(*logicalDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
+            vkCreateSemaphore(*logicalDevice, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
+            vkCreateFence(*logicalDevice, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS){
+            throw std::runtime_error("Failed to create synchronization objects for a frame!");
+        }
+    }
+}
+
+void SwapChain::destroySyncObjects() noexcept{
+    for (auto semaphore : renderFinishedSemaphores)
+        vkDestroySemaphore(*logicalDevice, semaphore, nullptr);
+    for (auto semaphore : imageAvailableSemaphores)
+        vkDestroySemaphore(*logicalDevice, semaphore, nullptr);
+    for (auto fence : inFlightFences)
+        vkDestroyFence(*logicalDevice, fence, nullptr);
+    renderFinishedSemaphores.clear();
+    imageAvailableSemaphores.clear();
+    inFlightFences.clear();
+    std::fill(imagesInFlight.begin(), imagesInFlight.end(), VK_NULL_HANDLE);
+}
+
+void SwapChain::setFramesInFlight(uint32_t framesinflight){
+    if (!framesinflight || framesinflight > MAX_FRAMES_IN_FLIGHT_ALLOWED)
+        throw std::runtime_error("Invalid number of frames in flight requested!");
+    if (framesinflight == framesInFlight && !inFlightFences.empty())
+        return;
+
+    //The old sync objects may still be in use, so let the device drain before replacing them...
+    vkDeviceWaitIdle(*logicalDevice);
+    completedFrames = submittedFrames;
+    destroySyncObjects();
+    createSyncObjects(framesinflight);
+}
+
+bool SwapChain::setPresentMode(VkPresentModeKHR presentmode, uint32_t imagecount) noexcept{
+    //Offscreen images are never presented, otherwise the change waits for the next recreation...
+    if (offscreen || (swapChainCreateInfo.presentMode == presentmode && swapChainCreateInfo.minImageCount == imagecount))
+        return false;
+    swapChainCreateInfo.presentMode = presentmode;
+    swapChainCreateInfo.minImageCount = imagecount;
+    return true;
 }
 
 VkFramebuffer SwapChain::getSwapChainFramebuffer(size_t index) const{
@@ -115,77 +423,175 @@ VkFramebuffer SwapChain::getSwapChainFramebuffer(size_t index) const{
     return swapChainFramebuffers[index];
 }
 
-VkResult SwapChain::draw(std::vector<VkCommandBuffer> &graphicsCommandBuffers, std::vector<VkQueue> &graphicsqueues){
-    //Create semaphores for synchronizing swap chain events (get swapchain image, execute commands on it, return it)...
-    VkSemaphore imageAvailableSemaphore;
-    VkSemaphore renderFinishedSemaphore;
-    VkSemaphoreCreateInfo semaphoreInfo = {};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    if (vkCreateSemaphore(*logicalDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphore) != VK_SUCCESS ||
-        vkCreateSemaphore(*logicalDevice, &semaphoreInfo, nullptr, &renderFinishedSemaphore) != VK_SUCCESS){
-        throw std::runtime_error("Failed to create semaphores!");
-    }
-
-    //Aquire image from swapchain...
-    uint32_t imageIndex;
-    auto result = vkAcquireNextImageKHR(
-                *logicalDevice,
-                swapChain,
-                (std::numeric_limits<uint64_t>::max)(),
-                imageAvailableSemaphore,
-                nullptr,
-                &imageIndex
-                );
-
-    if (result == VK_SUCCESS){
-        //TO DO: Need separate semaphores? command buffers? fix this...
-        auto numqueues = static_cast<uint32_t>(graphicsqueues.size());
-        for (auto & graphicsqueue : graphicsqueues){
-            VkSubmitInfo submitInfo = {};
-            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            VkSemaphore waitSemaphores[] = {imageAvailableSemaphore};
-            VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-            submitInfo.waitSemaphoreCount = 1;
-            submitInfo.pWaitSemaphores = waitSemaphores;
-            submitInfo.pWaitDstStageMask = waitStages;
-            submitInfo.commandBufferCount = 1;
-            submitInfo.pCommandBuffers = &graphicsCommandBuffers[imageIndex];
-            VkSemaphore signalSemaphores[] = {renderFinishedSemaphore};
-            submitInfo.signalSemaphoreCount = 1;
-            submitInfo.pSignalSemaphores = signalSemaphores;
-            if (vkQueueSubmit(graphicsqueue, numqueues, &submitInfo, nullptr) != VK_SUCCESS)
-                throw std::runtime_error("Failed to submit draw command buffer!");
-
-            //Get the resulting image and present it...
-            VkPresentInfoKHR presentInfo = {};
-            presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-            presentInfo.waitSemaphoreCount = 1;
-            presentInfo.pWaitSemaphores = signalSemaphores;
-
-            VkSwapchainKHR swapChains[] = {swapChain};
-            presentInfo.swapchainCount = 1;
-            presentInfo.pSwapchains = swapChains;
-            presentInfo.pImageIndices = &imageIndex;
-            presentInfo.pResults = nullptr;
-            if (vkQueuePresentKHR(graphicsqueue, &presentInfo) != VK_SUCCESS)
-                throw std::runtime_error("Presentation failed!");
-
-            //Do this when using validation layers to prevent memory leaks...
-            vkQueueWaitIdle(graphicsqueue);
-        }
+VkResult SwapChain::acquireImage(uint32_t &imageIndex){
+    //Wait for the GPU to finish the last frame that used this slot's semaphores and fence, it's the CPU's wait on the GPU...
+    auto waitstart = std::chrono::steady_clock::now();
+    vkWaitForFences(*logicalDevice, 1, &inFlightFences[currentFrame], VK_TRUE, (std::numeric_limits<uint64_t>::max)());
+
+    //Fences signal in submission order, so every frame up to this slot's last one has retired...
+    completedFrames = (std::max)(completedFrames, slotFrames[currentFrame]);
+    destroyRetiredPipelines();
+    destroyRetiredSwapChains();
 
-        //Destroy semaphores...
-        vkDestroySemaphore(*logicalDevice, renderFinishedSemaphore, nullptr);
-        vkDestroySemaphore(*logicalDevice, imageAvailableSemaphore, nullptr);
-    }else if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR){
-        //Just return the result and the calling code will recreate the swapchain...
+    //Aquire image from swapchain, offscreen images are simply handed out in turn...
+    auto result = VK_SUCCESS;
+    if (offscreen){
+        imageIndex = nextOffscreenImage;
+        nextOffscreenImage = (nextOffscreenImage + 1) % static_cast<uint32_t>(swapChainImages.size());
     }else{
-        throw std::runtime_error("Failed to aquire image from swapchain!");
+        result = vkAcquireNextImageKHR(
+                    *logicalDevice,
+                    swapChain,
+                    (std::numeric_limits<uint64_t>::max)(),
+                    imageAvailableSemaphores[currentFrame],
+                    nullptr,
+                    &imageIndex
+                    );
+        if (result == VK_ERROR_OUT_OF_DATE_KHR){
+            //Just return the result and the calling code will recreate the swapchain...
+            return result;
+        }else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR){
+            throw std::runtime_error("Failed to aquire image from swapchain!");
+        }
     }
 
+    //The image may still be in use by an older frame if images are acquired out of order...
+    if (imagesInFlight[imageIndex] != VK_NULL_HANDLE)
+        vkWaitForFences(*logicalDevice, 1, &imagesInFlight[imageIndex], VK_TRUE, (std::numeric_limits<uint64_t>::max)());
+    imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+    fenceWaitStatistics.addSample(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - waitstart).count()));
+
+    //This image's last submission has retired, so its timestamps can be read without stalling...
+    timestampQueryPool.collect(imageIndex);
     return result;
 }
 
+VkResult SwapChain::submitFrame(
+        VkCommandBuffer &commandbuffer,
+        uint32_t imageIndex,
+        std::vector<VkQueue> &graphicsqueues,
+        VkSemaphore waitsemaphore,
+        VkPipelineStageFlags waitstage
+        )
+{
+    //Only reset the fence once we know work will be submitted with it...
+    vkResetFences(*logicalDevice, 1, &inFlightFences[currentFrame]);
+
+    //Wait for the image to be acquired, and for any work this frame depends on such as async compute...
+    std::vector <VkSemaphore> waitSemaphores;
+    std::vector <VkPipelineStageFlags> waitStages;
+    if (!offscreen){
+        waitSemaphores.push_back(imageAvailableSemaphores[currentFrame]);
+        waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    }
+    if (waitsemaphore != VK_NULL_HANDLE){
+        waitSemaphores.push_back(waitsemaphore);
+        waitStages.push_back(waitstage);
+    }
+
+    //TO DO: Spread work over the remaining graphics queues...
+    auto & graphicsqueue = graphicsqueues.front();
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandbuffer;
+    VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
+    submitInfo.signalSemaphoreCount = offscreen ? 0 : 1;
+    submitInfo.pSignalSemaphores = signalSemaphores;
+    if (vkQueueSubmit(graphicsqueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit draw command buffer!");
+    slotFrames[currentFrame] = ++submittedFrames;
+    timestampQueryPool.markSubmitted(imageIndex);
+
+    //Nothing to present offscreen...
+    if (offscreen){
+        markPresented();
+        currentFrame = (currentFrame + 1) % framesInFlight;
+        return VK_SUCCESS;
+    }
+
+    //Get the resulting image and present it...
+    VkPresentInfoKHR presentInfo = {};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = signalSemaphores;
+    VkSwapchainKHR swapChains[] = {swapChain};
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = swapChains;
+    presentInfo.pImageIndices = &imageIndex;
+    presentInfo.pResults = nullptr;
+    auto presentresult = vkQueuePresentKHR(graphicsqueue, &presentInfo);
+    if (presentresult != VK_SUCCESS && presentresult != VK_ERROR_OUT_OF_DATE_KHR && presentresult != VK_SUBOPTIMAL_KHR)
+        throw std::runtime_error("Presentation failed!");
+    markPresented();
+
+    //Move on to the next frame slot without waiting for the GPU...
+    currentFrame = (currentFrame + 1) % framesInFlight;
+    return presentresult;
+}
+
+void SwapChain::markPresented() noexcept{
+    //The interval between presents, or submissions offscreen, shows how evenly frames reach the display...
+    auto now = std::chrono::steady_clock::now();
+    if (presented)
+        presentStatistics.addSample(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastPresent).count()));
+    lastPresent = now;
+    presented = true;
+}
+
+void SwapChain::startShaderReload(){
+    if (!initialised || isReloadingShaders())
+        return;
+
+    //Shaders are rebuilt against a copy on a worker thread, recreation waits for it before the render pass changes...
+    auto pipeline = graphicsPipeline;
+    reloadedPipeline = std::async(std::launch::async, [pipeline]{
+        return pipeline.rebuild();
+    }).share();
+}
+
+bool SwapChain::isReloadingShaders() const noexcept{
+    return reloadedPipeline.valid();
+}
+
+bool SwapChain::finishShaderReload(bool wait){
+    if (!isReloadingShaders())
+        return false;
+    if (!wait && reloadedPipeline.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return false;
+    auto result = reloadedPipeline;
+    reloadedPipeline = std::shared_future<GraphicsPipeline>();
+
+    //A broken shader leaves the old pipeline in place until the next change...
+    GraphicsPipeline reloaded;
+    try {
+        reloaded = result.get();
+    } catch (const std::exception & error) {
+        LOG_ERROR(std::string("Shader reload failed, keeping the previous pipeline: ") + error.what());
+        return false;
+    }
+
+    //Frames already submitted may still be using the old pipeline, so it retires once they have...
+    graphicsPipeline.swapShaders(reloaded);
+    retiredPipelines.push_back({reloaded, submittedFrames});
+    LOG_INFO(std::string("Reloaded ") + std::to_string(graphicsPipeline.shaders.size()) + std::string(" shaders"));
+    return true;
+}
+
+void SwapChain::destroyRetiredPipelines(bool all) noexcept{
+    for (auto i = 0U; i < retiredPipelines.size();){
+        if (all || retiredPipelines[i].lastFrame <= completedFrames){
+            retiredPipelines[i].pipeline.cleanupRetired();
+            retiredPipelines.erase(retiredPipelines.begin() + i);
+        }else{
+            i++;
+        }
+    }
+}
+
 /*GraphicsPipeline SwapChain::getGraphicPipeline() const{
     return graphicsPipeline;
 }*/
@@ -194,3 +600,7 @@ size_t SwapChain::getSwapChainFramebuffersCount() const noexcept{
     return swapChainFramebuffers.size();
 }
 
+uint32_t SwapChain::getFramesInFlight() const noexcept{
+    return framesInFlight;
+}
+
@@ -6,28 +6,99 @@
 #include <string>
 
 #include "graphicspipeline.h"
+#include "devicememoryallocator.h"
+#include <memory>
+#include <future>
+#include <chrono>
 
 class SwapChain final
 {
     friend class LogicalDevice;
+private:
+    struct RetiredPipeline final
+    {
+        GraphicsPipeline pipeline;
+        uint64_t lastFrame;
+    };
+    struct RetiredSwapChain final
+    {
+        VkSwapchainKHR swapChain;
+        std::vector <VkImage> images;
+        std::vector <VkImageView> imageViews;
+        std::vector <VkFramebuffer> framebuffers;
+        std::vector <DeviceMemoryAllocator::Allocation> allocations;
+        uint64_t lastFrame;
+    };
 public:
-    SwapChain(VkDevice *device);
+    SwapChain(
+            VkDevice *device,
+            VkPhysicalDevice physicaldevice,
+            const std::shared_ptr<DeviceMemoryAllocator> & memoryallocator,
+            VkPipelineCache pipelinecache,
+            const TimestampQueryPool & timestampquerypool,
+            ThreadPool *threadpool = nullptr,
+            DescriptorLayoutCache *layoutcache = nullptr
+            );
 public:
     SwapChain() = default;
     ~SwapChain() = default;
     SwapChain(const SwapChain & other) = default;
     SwapChain & operator=(const SwapChain & other) = default;
 private:
-    void startRenderPass(std::vector<VkCommandBuffer> &graphicsCommandBuffers) noexcept;
+    void recordCommandBuffer(
+            VkCommandBuffer &commandbuffer,
+            uint32_t imageindex,
+            const std::vector<Mesh> &meshes,
+            const std::vector<VkCommandBuffer> *secondarybuffers = nullptr,
+            const GraphicsPipeline::DrawUniforms *uniforms = nullptr,
+            const IndirectDrawList *indirectdraws = nullptr
+            );
+    void recordSecondaryCommandBuffer(
+            VkCommandBuffer &commandbuffer,
+            uint32_t imageindex,
+            const Mesh *meshes,
+            size_t meshcount,
+            const GraphicsPipeline::DrawUniforms *uniforms = nullptr,
+            const IndirectDrawList *indirectdraws = nullptr,
+            bool recordindirect = true
+            );
     void initializeSwapChain(VkSwapchainCreateInfoKHR *swapchaincreateinfo);
-    void recreateSwapChain();
-    void cleanup(bool destroyswapchain = true) noexcept;
+    void createImages(VkSwapchainCreateInfoKHR *swapchaincreateinfo);
+    void createOffscreenImages(VkSwapchainCreateInfoKHR *swapchaincreateinfo);
+    void createFramebuffers();
+    [[nodiscard]] bool recreateSwapChain(VkExtent2D extent);
+    void destroyRetiredSwapChains(bool all = false) noexcept;
+    void setDepthMode(GraphicsPipeline::DepthMode depthmode, VkFormat depthformat = VK_FORMAT_UNDEFINED);
+    [[nodiscard]] VkFormat chooseDepthFormat(VkFormat requestedformat) const;
+    void setSampleCount(VkSampleCountFlagBits samplecount);
+    [[nodiscard]] VkSampleCountFlags getSupportedSampleCounts() const;
+    void rebuildRenderPass();
+    void cleanup() noexcept;
+    void startShaderReload();
+    [[nodiscard]] bool isReloadingShaders() const noexcept;
+    [[nodiscard]] bool finishShaderReload(bool wait = false);
+    void destroyRetiredPipelines(bool all = false) noexcept;
+    void createSyncObjects(uint32_t framesinflight);
+    void destroySyncObjects() noexcept;
+    void setFramesInFlight(uint32_t framesinflight);
+    [[nodiscard]] bool setPresentMode(VkPresentModeKHR presentmode, uint32_t imagecount) noexcept;
     [[nodiscard]] VkFramebuffer getSwapChainFramebuffer(size_t index) const;
-    VkResult draw(std::vector<VkCommandBuffer> &graphicsCommandBuffers, std::vector<VkQueue> &graphicsqueues);
+    VkResult acquireImage(uint32_t &imageindex);
+    VkResult submitFrame(
+            VkCommandBuffer &commandbuffer,
+            uint32_t imageindex,
+            std::vector<VkQueue> &graphicsqueues,
+            VkSemaphore waitsemaphore = VK_NULL_HANDLE,
+            VkPipelineStageFlags waitstage = 0
+            );
+    void markPresented() noexcept;
     //GraphicsPipeline getGraphicPipeline() const;
     [[nodiscard]] size_t getSwapChainFramebuffersCount() const noexcept;
+    [[nodiscard]] uint32_t getFramesInFlight() const noexcept;
 private:
     VkDevice *logicalDevice;
+    VkPhysicalDevice physicalDevice;
+    std::shared_ptr <DeviceMemoryAllocator> memoryAllocator;
     VkSwapchainCreateInfoKHR swapChainCreateInfo;
     VkSwapchainKHR swapChain;
     std::vector <VkImage> swapChainImages;
@@ -35,7 +106,27 @@ private:
     VkFormat swapChainImageFormat;
     VkExtent2D swapChainExtent;
     std::vector<VkFramebuffer> swapChainFramebuffers;
+    std::vector <RetiredSwapChain> retiredSwapChains;
     GraphicsPipeline graphicsPipeline;
+    std::shared_future <GraphicsPipeline> reloadedPipeline;
+    std::vector <RetiredPipeline> retiredPipelines;
+    TimestampQueryPool timestampQueryPool;
+    FrameStatistics presentStatistics;
+    FrameStatistics fenceWaitStatistics;
+    std::chrono::steady_clock::time_point lastPresent;
+    bool presented;
+    uint32_t framesInFlight;
+    size_t currentFrame;
+    std::vector <VkSemaphore> imageAvailableSemaphores;
+    std::vector <VkSemaphore> renderFinishedSemaphores;
+    std::vector <VkFence> inFlightFences;
+    std::vector <VkFence> imagesInFlight;
+    std::vector <uint64_t> slotFrames;
+    uint64_t submittedFrames;
+    uint64_t completedFrames;
+    std::vector <DeviceMemoryAllocator::Allocation> offscreenImageAllocations;
+    uint32_t nextOffscreenImage;
+    bool offscreen;
     bool initialised;
 };
 
@@ -0,0 +1,91 @@
+#include "threadpool.h"
+#include <algorithm>
+#include <stdexcept>
+
+/*!
+        \class ThreadPool
+        \brief The ThreadPool class runs parallel for loops on a fixed set of worker threads.
+
+        parallelFor() hands out task indices to the workers and blocks until every task has finished.
+        Every call passes the worker's index along with the task's, so callers can keep per thread state,
+        such as command pools, without any locking. Only one parallelFor() may run at a time. The first
+        exception thrown by a task is rethrown on the calling thread.
+*/
+
+ThreadPool::ThreadPool(uint32_t threadcount)
+    : job(nullptr),
+      taskCount(0),
+      nextTask(0),
+      tasksRemaining(0),
+      generation(0),
+      stopping(false)
+{
+    if (!threadcount)
+        threadcount = (std::max)(1U, std::thread::hardware_concurrency());
+    for (auto i = 0U; i < threadcount; i++)
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard <std::mutex> guard(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto & worker : workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(size_t taskcount, const std::function<void(uint32_t worker, size_t task)> & function){
+    if (!taskcount)
+        return;
+    std::exception_ptr error;
+    auto wrapped = std::function<void(uint32_t, size_t)>([&](uint32_t worker, size_t task){
+        try {
+            function(worker, task);
+        } catch (...) {
+            std::lock_guard <std::mutex> guard(mutex);
+            if (!error)
+                error = std::current_exception();
+        }
+    });
+
+    std::unique_lock <std::mutex> lock(mutex);
+    job = &wrapped;
+    taskCount = taskcount;
+    nextTask = 0;
+    tasksRemaining = taskcount;
+    generation++;
+    workAvailable.notify_all();
+    workFinished.wait(lock, [&]{ return tasksRemaining == 0; });
+    job = nullptr;
+    lock.unlock();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+uint32_t ThreadPool::getThreadCount() const noexcept{
+    return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::workerLoop(uint32_t worker){
+    uint64_t seen = 0;
+    std::unique_lock <std::mutex> lock(mutex);
+    for (;;){
+        workAvailable.wait(lock, [&]{ return stopping || (generation != seen && nextTask < taskCount); });
+        if (stopping)
+            return;
+
+        //Keep taking tasks from the current job until it runs dry...
+        while (job && nextTask < taskCount){
+            auto task = nextTask++;
+            auto function = job;
+            lock.unlock();
+            (*function)(worker, task);
+            lock.lock();
+            if (--tasksRemaining == 0)
+                workFinished.notify_one();
+        }
+        seen = generation;
+    }
+}
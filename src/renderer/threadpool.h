@@ -0,0 +1,40 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+class ThreadPool final
+{
+public:
+    ThreadPool(uint32_t threadcount = 0);
+    ~ThreadPool();
+public:
+    ThreadPool(const ThreadPool & other) = delete;
+    ThreadPool & operator=(const ThreadPool & other) = delete;
+    ThreadPool(const ThreadPool && other) = delete;
+    ThreadPool & operator=(const ThreadPool && other) = delete;
+public:
+    void parallelFor(size_t taskcount, const std::function<void(uint32_t worker, size_t task)> & function);
+    [[nodiscard]] uint32_t getThreadCount() const noexcept;
+private:
+    void workerLoop(uint32_t worker);
+private:
+    std::vector <std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    const std::function<void(uint32_t, size_t)> *job;
+    size_t taskCount;
+    size_t nextTask;
+    size_t tasksRemaining;
+    uint64_t generation;
+    bool stopping;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,126 @@
+#include "timestampquerypool.h"
+
+/*!
+        \class TimestampQueryPool
+        \brief The TimestampQueryPool class times GPU work with timestamp queries.
+
+        Every swapchain image gets its own range of two queries per scope, written into that image's
+        command buffer, so the recorded command buffers never share queries. The results for an image
+        are read back just before the image is used again, after its fence has been waited on, which
+        means they are always a full swapchain's worth of frames old and the read never stalls. Tick
+        counts are converted to nanoseconds with limits.timestampPeriod and fed into one FrameStatistics
+        per scope. If the graphics queue family has no valid timestamp bits every call is a no-op.
+*/
+
+TimestampQueryPool::TimestampQueryPool(VkDevice *device, float timestampperiod, uint32_t timestampvalidbits)
+    : logicalDevice(device),
+      queryPool(VK_NULL_HANDLE),
+      timestampPeriod(timestampperiod),
+      timestampMask(timestampvalidbits >= 64 ? (std::numeric_limits<uint64_t>::max)() : (1ULL << timestampvalidbits) - 1),
+      frameCount(0),
+      statistics(SCOPE_COUNT),
+      droppedReadbacks(0)
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to TimestampQueryPool!");
+}
+
+bool TimestampQueryPool::isSupported() const noexcept{
+    return timestampMask != 0;
+}
+
+const char * TimestampQueryPool::getScopeName(Scope scope) noexcept{
+    switch (scope){
+    case SUBMIT_SCOPE:
+        return "submit";
+    case RENDER_PASS_SCOPE:
+        return "renderpass";
+    default:
+        return "unknown";
+    }
+}
+
+const FrameStatistics & TimestampQueryPool::getStatistics(Scope scope) const noexcept{
+    return statistics[scope];
+}
+
+uint64_t TimestampQueryPool::getDroppedReadbackCount() const noexcept{
+    return droppedReadbacks;
+}
+
+void TimestampQueryPool::resetStatistics(size_t windowsize){
+    for (auto & scopestatistics : statistics)
+        scopestatistics.reset(windowsize);
+    droppedReadbacks = 0;
+}
+
+void TimestampQueryPool::create(uint32_t framecount){
+    cleanup();
+    if (!isSupported() || !framecount)
+        return;
+
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = framecount * SCOPE_COUNT * 2;
+    if (vkCreateQueryPool(*logicalDevice, &poolInfo, nullptr, &queryPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create timestamp query pool!");
+    frameCount = framecount;
+    submitted.assign(framecount, false);
+}
+
+void TimestampQueryPool::resetQueries(VkCommandBuffer commandbuffer, uint32_t frame) const noexcept{
+    //Must be recorded outside of a render pass, before any of this frame's timestamps...
+    if (queryPool != VK_NULL_HANDLE)
+        vkCmdResetQueryPool(commandbuffer, queryPool, frame * SCOPE_COUNT * 2, SCOPE_COUNT * 2);
+}
+
+void TimestampQueryPool::beginScope(VkCommandBuffer commandbuffer, uint32_t frame, Scope scope) const noexcept{
+    if (queryPool != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(commandbuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, (frame * SCOPE_COUNT + scope) * 2);
+}
+
+void TimestampQueryPool::endScope(VkCommandBuffer commandbuffer, uint32_t frame, Scope scope) const noexcept{
+    if (queryPool != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(commandbuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, (frame * SCOPE_COUNT + scope) * 2 + 1);
+}
+
+void TimestampQueryPool::markSubmitted(uint32_t frame) noexcept{
+    if (frame < frameCount)
+        submitted[frame] = true;
+}
+
+void TimestampQueryPool::collect(uint32_t frame) noexcept{
+    if (frame >= frameCount || !submitted[frame])
+        return;
+    submitted[frame] = false;
+
+    //The frame's fence has already signalled, so never ask the driver to wait...
+    std::array<uint64_t, SCOPE_COUNT * 2> timestamps;
+    auto result = vkGetQueryPoolResults(
+                *logicalDevice,
+                queryPool,
+                frame * SCOPE_COUNT * 2,
+                SCOPE_COUNT * 2,
+                sizeof(timestamps),
+                timestamps.data(),
+                sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT
+                );
+    if (result != VK_SUCCESS){
+        droppedReadbacks++;
+        return;
+    }
+    for (auto scope = 0U; scope < SCOPE_COUNT; scope++){
+        auto ticks = (timestamps[scope * 2 + 1] - timestamps[scope * 2]) & timestampMask;
+        statistics[scope].addSample(static_cast<uint64_t>(static_cast<double>(ticks) * timestampPeriod));
+    }
+}
+
+void TimestampQueryPool::cleanup() noexcept{
+    if (queryPool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(*logicalDevice, queryPool, nullptr);
+    queryPool = VK_NULL_HANDLE;
+    frameCount = 0;
+    submitted.clear();
+}
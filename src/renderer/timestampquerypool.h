@@ -0,0 +1,50 @@
+#ifndef TIMESTAMPQUERYPOOL_H
+#define TIMESTAMPQUERYPOOL_H
+
+#include "framestatistics.h"
+#include "src/utility.h"
+
+class TimestampQueryPool final
+{
+    friend class LogicalDevice;
+    friend class SwapChain;
+    friend class GraphicsPipeline;
+public:
+    enum Scope {
+        SUBMIT_SCOPE = 0,
+        RENDER_PASS_SCOPE = 1,
+        SCOPE_COUNT = 2
+    };
+public:
+    TimestampQueryPool(VkDevice *device, float timestampperiod, uint32_t timestampvalidbits);
+public:
+    TimestampQueryPool() = default;
+    ~TimestampQueryPool() = default;
+    TimestampQueryPool(const TimestampQueryPool & other) = default;
+    TimestampQueryPool & operator=(const TimestampQueryPool & other) = default;
+public:
+    [[nodiscard]] bool isSupported() const noexcept;
+    [[nodiscard]] static const char * getScopeName(Scope scope) noexcept;
+    [[nodiscard]] const FrameStatistics & getStatistics(Scope scope) const noexcept;
+    [[nodiscard]] uint64_t getDroppedReadbackCount() const noexcept;
+    void resetStatistics(size_t windowsize = FRAME_STATISTICS_WINDOW_SIZE);
+private:
+    void create(uint32_t framecount);
+    void resetQueries(VkCommandBuffer commandbuffer, uint32_t frame) const noexcept;
+    void beginScope(VkCommandBuffer commandbuffer, uint32_t frame, Scope scope) const noexcept;
+    void endScope(VkCommandBuffer commandbuffer, uint32_t frame, Scope scope) const noexcept;
+    void markSubmitted(uint32_t frame) noexcept;
+    void collect(uint32_t frame) noexcept;
+    void cleanup() noexcept;
+private:
+    VkDevice *logicalDevice;
+    VkQueryPool queryPool;
+    float timestampPeriod;
+    uint64_t timestampMask;
+    uint32_t frameCount;
+    std::vector <bool> submitted;
+    std::vector <FrameStatistics> statistics;
+    uint64_t droppedReadbacks;
+};
+
+#endif // TIMESTAMPQUERYPOOL_H
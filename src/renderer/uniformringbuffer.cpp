@@ -0,0 +1,117 @@
+#include "uniformringbuffer.h"
+#include <cstring>
+
+/*!
+        \class UniformRingBuffer
+        \brief The UniformRingBuffer class bump allocates uniform data out of one persistently mapped buffer.
+
+        The buffer is host visible and coherent, device local too where the heap allows it, and it is mapped
+        once when it is allocated. Each swapchain image owns a frameSize region of it. beginFrame() rewinds
+        that region once the image's last submission has retired, and write() copies data to the next free
+        offset aligned to minUniformBufferOffsetAlignment. Updating uniform data is therefore a memcpy, with
+        no map, unmap, flush or allocation per frame.
+
+        Offsets returned by write() are from the start of the buffer and are meant to be used as dynamic
+        offsets, so a single VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor covers every region.
+        Frames that write the same sizes in the same order get the same offsets back, which keeps
+        command buffers recorded with those offsets valid from one frame to the next. A frame that won't
+        fit has to grow the regions with createFrames(), which replaces the buffer.
+*/
+
+UniformRingBuffer::UniformRingBuffer(
+        VkDevice *device,
+        const std::shared_ptr<DeviceMemoryAllocator> & memoryallocator,
+        const VkPhysicalDeviceLimits & limits,
+        VkDeviceSize framesize
+        )
+    : logicalDevice(device),
+      memoryAllocator(memoryallocator),
+      buffer(VK_NULL_HANDLE),
+      allocation(),
+      frameSize(0),
+      frameCount(0),
+      alignment((std::max)(limits.minUniformBufferOffsetAlignment, static_cast<VkDeviceSize>(sizeof(float)))),
+      frameStart(0),
+      head(0)
+{
+    if (!device)
+        throw std::runtime_error("Null device passed to UniformRingBuffer!");
+    if (!memoryallocator)
+        throw std::runtime_error("Null memory allocator passed to UniformRingBuffer!");
+
+    //Regions start on an offset boundary so the first write of a frame needs no padding...
+    frameSize = getAlignedSize(framesize);
+    if (!frameSize)
+        throw std::runtime_error("Uniform ring buffer frames need room for at least one write!");
+}
+
+void UniformRingBuffer::createFrames(uint32_t framecount, VkDeviceSize framesize){
+    framesize = getAlignedSize(framesize);
+    if (framecount <= frameCount && framesize <= frameSize)
+        return;
+    frameSize = (std::max)(frameSize, framesize);
+    framecount = (std::max)(frameCount, framecount);
+
+    //Only called while the device is idle, nothing can still be reading the old buffer...
+    if (buffer != VK_NULL_HANDLE){
+        vkDestroyBuffer(*logicalDevice, buffer, nullptr);
+        memoryAllocator->free(allocation);
+        buffer = VK_NULL_HANDLE;
+    }
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = frameSize * framecount;
+    bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(*logicalDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create uniform ring buffer!");
+    allocation = memoryAllocator->allocateBuffer(buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (!allocation.mapped)
+        throw std::runtime_error("Uniform ring buffer memory wasn't mapped!");
+    frameCount = framecount;
+    frameStart = 0;
+    head = 0;
+}
+
+void UniformRingBuffer::beginFrame(uint32_t frame){
+    if (frame >= frameCount)
+        throw std::runtime_error("Uniform ring buffer has no region for this frame!");
+    frameStart = frame * frameSize;
+    head = frameStart;
+}
+
+uint32_t UniformRingBuffer::write(const void *data, VkDeviceSize size){
+    auto offset = getAlignedSize(head);
+    if (buffer == VK_NULL_HANDLE || offset + size > frameStart + frameSize)
+        throw std::runtime_error("Uniform ring buffer frame is full!");
+
+    //Coherent memory, the copy is visible to the frame's submission without a flush...
+    std::memcpy(static_cast<char *>(allocation.mapped) + offset, data, static_cast<size_t>(size));
+    head = offset + size;
+    return static_cast<uint32_t>(offset);
+}
+
+VkDeviceSize UniformRingBuffer::getAlignedSize(VkDeviceSize size) const noexcept{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+VkBuffer UniformRingBuffer::getBuffer() const noexcept{
+    return buffer;
+}
+
+VkDeviceSize UniformRingBuffer::getFrameSize() const noexcept{
+    return frameSize;
+}
+
+VkDeviceSize UniformRingBuffer::getFrameUsage() const noexcept{
+    return head - frameStart;
+}
+
+void UniformRingBuffer::cleanup() noexcept{
+    if (buffer != VK_NULL_HANDLE){
+        vkDestroyBuffer(*logicalDevice, buffer, nullptr);
+        memoryAllocator->free(allocation);
+    }
+    buffer = VK_NULL_HANDLE;
+    frameCount = 0;
+}
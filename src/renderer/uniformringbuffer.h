@@ -0,0 +1,45 @@
+#ifndef UNIFORMRINGBUFFER_H
+#define UNIFORMRINGBUFFER_H
+
+#include "devicememoryallocator.h"
+#include "src/utility.h"
+#include <memory>
+
+#define UNIFORM_RING_FRAME_SIZE (4ULL * 1024 * 1024)
+
+class UniformRingBuffer final
+{
+public:
+    UniformRingBuffer(
+            VkDevice *device,
+            const std::shared_ptr<DeviceMemoryAllocator> & memoryallocator,
+            const VkPhysicalDeviceLimits & limits,
+            VkDeviceSize framesize = UNIFORM_RING_FRAME_SIZE
+            );
+public:
+    UniformRingBuffer() = default;
+    ~UniformRingBuffer() = default;
+    UniformRingBuffer(const UniformRingBuffer & other) = default;
+    UniformRingBuffer & operator=(const UniformRingBuffer & other) = default;
+public:
+    void createFrames(uint32_t framecount, VkDeviceSize framesize = 0);
+    void beginFrame(uint32_t frame);
+    [[nodiscard]] uint32_t write(const void *data, VkDeviceSize size);
+    [[nodiscard]] VkDeviceSize getAlignedSize(VkDeviceSize size) const noexcept;
+    [[nodiscard]] VkBuffer getBuffer() const noexcept;
+    [[nodiscard]] VkDeviceSize getFrameSize() const noexcept;
+    [[nodiscard]] VkDeviceSize getFrameUsage() const noexcept;
+    void cleanup() noexcept;
+private:
+    VkDevice *logicalDevice;
+    std::shared_ptr <DeviceMemoryAllocator> memoryAllocator;
+    VkBuffer buffer;
+    DeviceMemoryAllocator::Allocation allocation;
+    VkDeviceSize frameSize;
+    uint32_t frameCount;
+    VkDeviceSize alignment;
+    VkDeviceSize frameStart;
+    VkDeviceSize head;
+};
+
+#endif // UNIFORMRINGBUFFER_H
@@ -1,4 +1,5 @@
 #include "vulkanrenderer.h"
+#include "src/ui/headlesswindow.h"
 #include <algorithm>
 
 /*!
@@ -27,11 +28,20 @@ VulkanRenderer::VulkanRenderer(
         const std::vector<const char *> &enableextensions
         )
     : render(true),
+      headless(windowcreateinfo.headless),
+      offscreenExtent(windowcreateinfo.extent),
       currentPhysicalDeviceIndex(0),
       currentLogicalDeviceIndex(0),
+      surfaceInUse(false),
+      surfacePhysicalDeviceIndex(0),
+      surfaceLogicalDeviceIndex(0),
       indexOfStrongestDevice(0),
-      windowsClass(windowcreateinfo)
+      surface(VK_NULL_HANDLE),
+      frameTimingStarted(false)
 {
+    //The window pumps its own events on its own thread from here on...
+    window = Window::create(windowcreateinfo);
+
     //Setup application info...
     VkApplicationInfo appInfo;
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -76,6 +86,13 @@ VulkanRenderer::VulkanRenderer(
         instanceCreateInfo.ppEnabledLayerNames = enablelayers.data();
     }
 
+    //Headless renderers never present, so surface extensions aren't required...
+    std::vector<const char *> extensions;
+    for (auto extension : enableextensions){
+        if (!headless || !strstr(extension, "_surface"))
+            extensions.push_back(extension);
+    }
+
     //Ensure requested extensions are available...
     uint32_t numextensions = 0;
     vkEnumerateInstanceExtensionProperties(nullptr, &numextensions, nullptr);
@@ -84,11 +101,11 @@ VulkanRenderer::VulkanRenderer(
         if (vkEnumerateInstanceExtensionProperties(nullptr, &numextensions, &extensionProperties[0]) != VK_SUCCESS)
             throw std::runtime_error("Failed to enumerate extensions!");
     }
-    if (!enableextensions.size()){
+    if (!extensions.size()){
         instanceCreateInfo.enabledExtensionCount = 0;
         instanceCreateInfo.ppEnabledExtensionNames = nullptr;
     }else{
-        for (auto requiredextension: enableextensions){
+        for (auto requiredextension: extensions){
             auto found = false;
             for (auto extension: extensionProperties){
                 if (!strcmp(extension.extensionName, requiredextension)){
@@ -99,16 +116,21 @@ VulkanRenderer::VulkanRenderer(
             if (!found)
                 throw std::runtime_error(std::string("Required extension \"")+requiredextension+std::string("\" is missing!"));
         }
-        instanceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enableextensions.size());
-        instanceCreateInfo.ppEnabledExtensionNames = enableextensions.data();
+        instanceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        instanceCreateInfo.ppEnabledExtensionNames = extensions.data();
     }
 
     //Create vulkan instance...
     if (vkCreateInstance(&instanceCreateInfo, nullptr, &vulkanInstance) != VK_SUCCESS)
         throw std::runtime_error("Failed to create Vulkan Instance!");
 
-    //Set up validation layers...
-    validationLayers.initializeValidationLayers(&vulkanInstance);
+    //Set up validation layers (the debug report callback needs its extension)...
+    for (auto extension : extensions){
+        if (!strcmp(extension, VK_EXT_DEBUG_REPORT_EXTENSION_NAME)){
+            validationLayers.initializeValidationLayers(&vulkanInstance);
+            break;
+        }
+    }
 
     //Create physical devices...
     uint32_t physicalDeviceCount;
@@ -120,25 +142,20 @@ VulkanRenderer::VulkanRenderer(
     if (vkEnumeratePhysicalDevices(vulkanInstance, &physicalDeviceCount, physicalDevices.data()) != VK_SUCCESS)
         throw std::runtime_error("Failed to enumerate physical devices!");
 
-    //Get device info...
+    //Get device info and score each device, the first startup on a device benchmarks it...
+    DeviceScorer scorer;
     auto score = 0ULL;
     for (auto i = 0U; i < physicalDeviceCount; i++){
         physicalDeviceInfos.push_back(PhysicalDeviceInfo(&physicalDevices[i], &vulkanInstance));
-        if (physicalDeviceInfos.at(i).getDeviceScore() > score)
+        physicalDeviceInfos.back().scoreDevice(scorer);
+        if (!i || physicalDeviceInfos.back().getDeviceScore() > score){
+            score = physicalDeviceInfos.back().getDeviceScore();
             indexOfStrongestDevice = i;
+        }
     }
 
-    //Set up surface info...
-    VkWin32SurfaceCreateInfoKHR surfaceCreateInfo;
-    surfaceCreateInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-    surfaceCreateInfo.pNext = nullptr;
-    surfaceCreateInfo.flags = 0;
-    surfaceCreateInfo.hinstance = windowsClass.getWindows32Handle();
-    surfaceCreateInfo.hwnd = windowsClass.getWindow();
-
-    //Create Windows surface...
-    if (vkCreateWin32SurfaceKHR(vulkanInstance, &surfaceCreateInfo, nullptr, &surface) != VK_SUCCESS)
-        throw std::runtime_error("failed to create window surface!");
+    //Headless renderers draw offscreen and get a null surface...
+    surface = window->createSurface(vulkanInstance);
 }
 
 void VulkanRenderer::setWindowResized(bool resized) noexcept{
@@ -153,22 +170,248 @@ bool VulkanRenderer::keepRendering() const noexcept{
     return render;
 }
 
+bool VulkanRenderer::isHeadless() const noexcept{
+    return headless;
+}
+
+void VulkanRenderer::setOffscreenExtent(VkExtent2D extent){
+    if (!headless)
+        throw std::runtime_error("Only headless renderers have an offscreen extent!");
+    if (!extent.width || !extent.height)
+        throw std::runtime_error("Invalid offscreen extent!");
+
+    //Goes through the event queue like a real window's resize, and is picked up at the start of the next frame...
+    static_cast<HeadlessWindow *>(window.get())->resize(extent);
+}
+
+uint64_t VulkanRenderer::getDroppedWindowEventCount() const noexcept{
+    return window->getDroppedEventCount();
+}
+
+void VulkanRenderer::processWindowEvents() noexcept{
+    //Never blocks, the window's event thread has already queued whatever happened since the last frame...
+    WindowEvent event;
+    while (window->pollEvent(event)){
+        switch (event.type){
+        case WindowEvent::RESIZE_EVENT:
+            if (headless)
+                offscreenExtent = event.extent;
+            windowResized = true;
+            break;
+        case WindowEvent::CLOSE_EVENT:
+            render = false;
+            break;
+        }
+    }
+}
+
 void VulkanRenderer::drawFrame(){
+    //Paced policies hold the CPU back until the next frame is due...
+    limiterStatistics.addSample(presentPolicy.limitFrameRate());
+
+    //Time frames start to start, so anything the application does between frames counts too...
+    auto framestart = std::chrono::steady_clock::now();
+    if (frameTimingStarted)
+        frameStatistics.addSample(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(framestart - lastFrameStart).count()));
+    lastFrameStart = framestart;
+    frameTimingStarted = true;
+
+    //Every resize since the last frame is handled by one recreation at the start of this one...
+    processWindowEvents();
+    if (!render)
+        return;
+    if (windowResized)
+        recreateSwapChain();
+
     //Start drawing frames...
     physicalDeviceInfos[currentPhysicalDeviceIndex].draw(currentLogicalDeviceIndex);
+}
+
+uint32_t VulkanRenderer::addMesh(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices){
+    //Uploads run asynchronously, the mesh shows up in a later frame once it has landed...
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].addMesh(currentLogicalDeviceIndex, vertices, indices);
+}
+
+uint32_t VulkanRenderer::addComputeMesh(const std::string & shadername, uint32_t vertexcount, uint32_t indexcount){
+    //The named *comp.spv shader rewrites the mesh on the compute queue every frame...
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].addComputeMesh(currentLogicalDeviceIndex, shadername, vertexcount, indexcount);
+}
+
+void VulkanRenderer::setMeshUniforms(uint32_t mesh, const MeshUniforms & uniforms){
+    //Copied into the uniform ring every frame, changing it never re-records a command buffer...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setMeshUniforms(currentLogicalDeviceIndex, mesh, uniforms);
+}
+
+void VulkanRenderer::setMeshConstants(uint32_t mesh, const DrawConstants & constants){
+    //Pushed when the draw is recorded, so changing it re-records...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setMeshConstants(currentLogicalDeviceIndex, mesh, constants);
+}
+
+std::vector<uint32_t> VulkanRenderer::addPipelineVariants(const std::vector<PipelineState> & states){
+    //Identical states come back as the same variant, everything new is compiled in one batch...
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].addPipelineVariants(currentLogicalDeviceIndex, states);
+}
+
+void VulkanRenderer::setMeshPipeline(uint32_t mesh, uint32_t variant){
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setMeshPipeline(currentLogicalDeviceIndex, mesh, variant);
+}
+
+void VulkanRenderer::setDepthMode(GraphicsPipeline::DepthMode depthmode, VkFormat depthformat){
+    //An undefined format picks the most precise one the device can render depth to...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setDepthMode(currentLogicalDeviceIndex, depthmode, depthformat);
+}
+
+GraphicsPipeline::DepthMode VulkanRenderer::getDepthMode() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getDepthMode(currentLogicalDeviceIndex);
+}
+
+VkFormat VulkanRenderer::getDepthFormat() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getDepthFormat(currentLogicalDeviceIndex);
+}
+
+void VulkanRenderer::setSampleCount(VkSampleCountFlagBits samplecount){
+    //Samples live in transient attachments and are resolved within the render pass...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setSampleCount(currentLogicalDeviceIndex, samplecount);
+}
+
+VkSampleCountFlagBits VulkanRenderer::getSampleCount() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getSampleCount(currentLogicalDeviceIndex);
+}
+
+VkSampleCountFlags VulkanRenderer::getSupportedSampleCounts() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getSupportedSampleCounts(currentLogicalDeviceIndex);
+}
+
+RenderGraph::MemoryStatistics VulkanRenderer::getTransientMemoryStatistics() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getTransientMemoryStatistics(currentLogicalDeviceIndex);
+}
+
+std::unique_ptr<RenderGraph> VulkanRenderer::createRenderGraph() const{
+    //An empty graph on the current device, for building render passes outside the frame's own...
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].createRenderGraph(currentLogicalDeviceIndex);
+}
 
-    //Process messages...
-    if (!windowsClass.processMessage()){
-        render = false;
+void VulkanRenderer::setFramesInFlight(uint32_t framesinflight){
+    //Sets how many frames the CPU may queue up ahead of the GPU on the current device...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setFramesInFlight(currentLogicalDeviceIndex, framesinflight);
+}
+
+uint32_t VulkanRenderer::getFramesInFlight() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getFramesInFlight(currentLogicalDeviceIndex);
+}
+
+void VulkanRenderer::setPresentPolicy(const PresentPolicy & policy){
+    //The surface decides which present modes and image counts the policy can have, headless renderers only take its pacing...
+    auto & device = physicalDeviceInfos[currentPhysicalDeviceIndex];
+    if (!headless){
+        auto physicaldevice = physicalDevices[currentPhysicalDeviceIndex];
+        VkSurfaceCapabilitiesKHR capabilities;
+        if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicaldevice, surface, &capabilities) != VK_SUCCESS)
+            throw std::runtime_error("Could not get information about the physical device's surface capabilities!");
+        uint32_t presentmodecount;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(physicaldevice, surface, &presentmodecount, nullptr);
+        std::vector<VkPresentModeKHR> presentmodes(presentmodecount);
+        vkGetPhysicalDeviceSurfacePresentModesKHR(physicaldevice, surface, &presentmodecount, presentmodes.data());
+
+        //Picked up by the next frame's swapchain recreation...
+        device.setPresentMode(currentLogicalDeviceIndex, policy.choosePresentMode(presentmodes), policy.chooseImageCount(capabilities));
     }
+    device.setFramesInFlight(currentLogicalDeviceIndex, policy.getFramesInFlight());
+    presentPolicy = policy;
+}
 
-    //If the window size changes we need to recreate the swapchain...
-    if (windowResized)
-        recreateSwapChain();
+const PresentPolicy & VulkanRenderer::getPresentPolicy() const noexcept{
+    return presentPolicy;
+}
+
+const FrameStatistics & VulkanRenderer::getPresentStatistics() const{
+    //Intervals between presents, offscreen renderers count submissions instead...
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getPresentStatistics(currentLogicalDeviceIndex);
+}
+
+const FrameStatistics & VulkanRenderer::getFenceWaitStatistics() const{
+    //Time the CPU spent waiting for the GPU to give back a frame slot and its image...
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getFenceWaitStatistics(currentLogicalDeviceIndex);
+}
+
+const FrameStatistics & VulkanRenderer::getLimiterWaitStatistics() const noexcept{
+    return limiterStatistics;
+}
+
+const FrameStatistics & VulkanRenderer::getFrameStatistics() const noexcept{
+    return frameStatistics;
+}
+
+const FrameStatistics & VulkanRenderer::getGpuStatistics(TimestampQueryPool::Scope scope) const{
+    //GPU times lag the CPU by a swapchain's worth of frames, they're read back once an image is reused...
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getTimestampQueryPool(currentLogicalDeviceIndex).getStatistics(scope);
+}
+
+bool VulkanRenderer::hasGpuTimestamps() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getTimestampQueryPool(currentLogicalDeviceIndex).isSupported();
+}
+
+void VulkanRenderer::setRecordingThreadCount(uint32_t threadcount){
+    //Zero picks one thread per core, draw lists below PARALLEL_RECORDING_DRAW_THRESHOLD stay on the calling thread...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setRecordingThreadCount(currentLogicalDeviceIndex, threadcount);
+}
+
+uint32_t VulkanRenderer::getRecordingThreadCount() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getRecordingThreadCount(currentLogicalDeviceIndex);
+}
+
+void VulkanRenderer::setRecordEveryFrame(bool recordeveryframe){
+    //Command buffers are normally only re-recorded when the scene changes...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setRecordEveryFrame(currentLogicalDeviceIndex, recordeveryframe);
+}
+
+void VulkanRenderer::setShaderHotReload(bool enable){
+    //Recompiled .spv files in the shaders directory are picked up without restarting...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setShaderHotReload(currentLogicalDeviceIndex, enable);
+}
+
+bool VulkanRenderer::isShaderHotReloadEnabled() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].isShaderHotReloadEnabled(currentLogicalDeviceIndex);
+}
+
+void VulkanRenderer::setGpuDriven(bool gpudriven){
+    //Static meshes are culled by a compute pass and drawn from the list it writes...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].setGpuDriven(currentLogicalDeviceIndex, gpudriven);
+}
+
+bool VulkanRenderer::isGpuDriven() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].isGpuDriven(currentLogicalDeviceIndex);
+}
+
+const FrameStatistics & VulkanRenderer::getRecordingStatistics() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getRecordingStatistics(currentLogicalDeviceIndex);
+}
+
+bool VulkanRenderer::wasPipelineCacheLoaded() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].wasPipelineCacheLoaded(currentLogicalDeviceIndex);
+}
+
+std::vector<DeviceMemoryAllocator::HeapStatistics> VulkanRenderer::getMemoryStatistics() const{
+    return physicalDeviceInfos[currentPhysicalDeviceIndex].getMemoryStatistics(currentLogicalDeviceIndex);
+}
+
+void VulkanRenderer::resetFrameStatistics(size_t windowsize){
+    //The next frame starts a new interval rather than timing the gap since the last one...
+    frameStatistics.reset(windowsize);
+    limiterStatistics.reset(windowsize);
+    frameTimingStarted = false;
+    physicalDeviceInfos[currentPhysicalDeviceIndex].resetStatistics(currentLogicalDeviceIndex, windowsize);
 }
 
 void VulkanRenderer::recreateSwapChain(){
-    physicalDeviceInfos[currentPhysicalDeviceIndex].recreateSwapChain(currentLogicalDeviceIndex);
+    //Only the device presenting to the window has a surface to follow, the others keep their offscreen extent...
+    if (!headless && (currentPhysicalDeviceIndex != surfacePhysicalDeviceIndex || currentLogicalDeviceIndex != surfaceLogicalDeviceIndex)){
+        windowResized = false;
+        return;
+    }
+
+    //Surfaces report their own extent, offscreen images take ours...
+    physicalDeviceInfos[currentPhysicalDeviceIndex].recreateSwapChain(currentLogicalDeviceIndex, headless ? offscreenExtent : VkExtent2D{0, 0});
     //Window resize handled, revert state...
     windowResized = false;
 }
@@ -187,7 +430,73 @@ void VulkanRenderer::initializeRenderLoop(int physicaldeviceindex, uint32_t logi
     currentLogicalDeviceIndex = logicaldeviceindex;
 
     //Show window...
-    windowsClass.showWindow();
+    window->show();
+}
+
+void VulkanRenderer::setCurrentDevice(uint32_t physicaldeviceindex, uint32_t logicaldeviceindex){
+    //The current device belongs to the calling thread, it can't be handed one a render thread is driving...
+    if (!renderThreads.empty())
+        throw std::runtime_error("The current device can't change while render threads are running!");
+    initializeRenderLoop(static_cast<int>(physicaldeviceindex), logicaldeviceindex);
+}
+
+uint32_t VulkanRenderer::getPhysicalDeviceCount() const noexcept{
+    return static_cast<uint32_t>(physicalDeviceInfos.size());
+}
+
+uint32_t VulkanRenderer::getLogicalDeviceCount(uint32_t physicaldeviceindex) const{
+    if (physicaldeviceindex >= physicalDeviceInfos.size())
+        throw std::runtime_error("Invalid physical device index!");
+    return physicalDeviceInfos[physicaldeviceindex].getLogicalDeviceCount();
+}
+
+void VulkanRenderer::startRenderThreads(){
+    if (!renderThreads.empty())
+        throw std::runtime_error("Render threads are already running!");
+
+    //Every other logical device gets a loop of its own, the current one is still drawn by drawFrame()...
+    auto physicaldevicecount = (std::min)(static_cast<uint32_t>(physicalDeviceInfos.size()), static_cast<uint32_t>(MAX_NUM_PHYSICAL_DEVICES_SUPPORTED));
+    try{
+        for (auto i = 0U; i < physicaldevicecount; i++){
+            for (auto j = 0U; j < physicalDeviceInfos[i].getLogicalDeviceCount(); j++){
+                if (i == currentPhysicalDeviceIndex && j == currentLogicalDeviceIndex)
+                    continue;
+                if (!physicalDeviceInfos[i].hasGraphicsQueues(j))
+                    continue;
+                renderThreads.push_back(std::make_unique<RenderThread>(&physicalDeviceInfos[i], j));
+            }
+        }
+    }catch (...){
+        renderThreads.clear();
+        throw;
+    }
+}
+
+void VulkanRenderer::stopRenderThreads(){
+    //Every thread is stopped before the first error is passed on...
+    std::exception_ptr error = nullptr;
+    for (auto & thread : renderThreads){
+        try{
+            thread->stop();
+        }catch (...){
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    renderThreads.clear();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+uint32_t VulkanRenderer::getRenderThreadCount() const noexcept{
+    return static_cast<uint32_t>(renderThreads.size());
+}
+
+uint64_t VulkanRenderer::getRenderThreadFrameCount() const noexcept{
+    uint64_t frames = 0;
+    for (const auto & thread : renderThreads)
+        frames += thread->getFrameCount();
+    return frames;
 }
 
 /*void VulkanRenderer::addLogicalDevice(VkDeviceCreateInfo * devicecreateinfo, uint32_t graphicsqueuecount, uint32_t computequeuecount, int physicaldeviceindex){
@@ -207,14 +516,35 @@ void VulkanRenderer::addLogicalDevice(
         int deviceindex
         )
 {
-    //Make sure physicaldeviceindex is valid...
-    if (deviceindex < 0 || static_cast<uint32_t>(deviceindex) >= physicalDevices.size())
+    //Make sure physicaldeviceindex is valid, a negative index picks the highest scoring device...
+    if (deviceindex < 0)
+        deviceindex = static_cast<int>(indexOfStrongestDevice);
+    if (static_cast<uint32_t>(deviceindex) >= physicalDevices.size())
         throw std::runtime_error("Invalid physicaldeviceindex device!");
 
+    //Devices can't be added under a running render thread...
+    if (!renderThreads.empty())
+        throw std::runtime_error("Logical devices can't be added while render threads are running!");
+
     //Make sure queue flags is not empty...
     if (queuetypes.empty())
         throw std::runtime_error("No queue properties specified for the logical device!");
 
+    //Headless devices never present, so they don't need the swapchain extension...
+    std::vector<const char *> extensions;
+    for (auto extension : enableextensions){
+        if (!headless || strcmp(extension, VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+            extensions.push_back(extension);
+    }
+
+    //Let the GPU write the indirect draw count when the device can...
+    auto & physicaldeviceinfo = physicalDeviceInfos[static_cast<uint32_t>(deviceindex)];
+    auto requested = std::find_if(extensions.begin(), extensions.end(), [](const char *extension){
+        return !strcmp(extension, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    });
+    if (requested == extensions.end() && physicaldeviceinfo.supportsExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+        extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
     //Make sure graphics and compute queues are requested separately...
     if ((queuetypes.front().flag & VK_QUEUE_GRAPHICS_BIT) == (queuetypes.back().flag & VK_QUEUE_GRAPHICS_BIT))
         throw std::runtime_error("Duplicate VK_QUEUE_GRAPHICS_BIT queue flags were passed into addLogicalDevice()!");
@@ -233,32 +563,61 @@ void VulkanRenderer::addLogicalDevice(
         devicecreateinfo.enabledLayerCount = static_cast<uint32_t>(enablelayers.size());
         devicecreateinfo.ppEnabledLayerNames = enablelayers.data();
     }
-    if (enableextensions.empty()){
+    if (extensions.empty()){
         devicecreateinfo.enabledExtensionCount = 0;
         devicecreateinfo.ppEnabledExtensionNames = nullptr;
     }else{
-        devicecreateinfo.enabledExtensionCount = static_cast<uint32_t>(enableextensions.size());
-        devicecreateinfo.ppEnabledExtensionNames = enableextensions.data();
+        devicecreateinfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        devicecreateinfo.ppEnabledExtensionNames = extensions.data();
     }
     devicecreateinfo.pEnabledFeatures = &features;
-    devicecreateinfo.queueCreateInfoCount = static_cast<uint32_t>(queuetypes.size());
-
-    //Set up the number and types of queues required for the logical device...
-    std::vector <VkDeviceQueueCreateInfo> queueinfos(queuetypes.size());
-    uint32_t index = 0;
-    for (auto queueinfo : queuetypes){
-        auto queuefamilyinfo = physicalDeviceInfos[static_cast<uint32_t>(deviceindex)].getQueueFamilyIndex(queueinfo.flag);
-        if (!queuefamilyinfo.queueCount)
-            throw std::runtime_error("Queue family unsupported!");
-        VkDeviceQueueCreateInfo queuecreateinfo;
+
+    //Set up the number and types of queues required for the logical device. Compute queues go in a family
+    //of their own when there is one, otherwise they share the graphics family's create info...
+    const auto & graphicspriorities = (queuetypes.front().flag & VK_QUEUE_GRAPHICS_BIT) ? queuetypes.front().prioritys : queuetypes.back().prioritys;
+    const auto & computepriorities = (queuetypes.front().flag & VK_QUEUE_COMPUTE_BIT) ? queuetypes.front().prioritys : queuetypes.back().prioritys;
+    auto graphicsfamilyinfo = physicaldeviceinfo.getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT);
+    auto computefamilyinfo = physicaldeviceinfo.getComputeQueueFamilyIndex(
+                static_cast<uint32_t>(graphicspriorities.size()),
+                static_cast<uint32_t>(computepriorities.size())
+                );
+    if (!graphicspriorities.empty() && !graphicsfamilyinfo.queueCount)
+        throw std::runtime_error("Queue family unsupported!");
+    if (graphicspriorities.size() > graphicsfamilyinfo.queueCount)
+        throw std::runtime_error("Too many graphics queues requested!");
+    std::vector <VkDeviceQueueCreateInfo> queueinfos;
+    std::vector <float> sharedpriorities(graphicspriorities);
+    auto sharedfamily = !graphicspriorities.empty() && computefamilyinfo.queueFamilyIndex == graphicsfamilyinfo.queueFamilyIndex;
+    if (sharedfamily)
+        sharedpriorities.insert(sharedpriorities.end(), computepriorities.begin(), computepriorities.begin() + computefamilyinfo.queueCount);
+    auto addqueues = [&](uint32_t family, const std::vector<float> & priorities, uint32_t count){
+        if (!count)
+            return;
+        VkDeviceQueueCreateInfo queuecreateinfo = {};
+        queuecreateinfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queuecreateinfo.queueCount = count;
+        queuecreateinfo.queueFamilyIndex = family;
+        queuecreateinfo.pQueuePriorities = priorities.data();
+        queueinfos.push_back(queuecreateinfo);
+    };
+    addqueues(graphicsfamilyinfo.queueFamilyIndex, sharedpriorities, static_cast<uint32_t>(sharedpriorities.size()));
+    if (!sharedfamily)
+        addqueues(computefamilyinfo.queueFamilyIndex, computepriorities, computefamilyinfo.queueCount);
+    if (queueinfos.empty())
+        throw std::runtime_error("Queue family unsupported!");
+
+    //Add a queue from a transfer only family for uploads if the device has one...
+    static const float transferpriority = 1.0f;
+    auto transferfamilyinfo = physicaldeviceinfo.getQueueFamilyIndex(VK_QUEUE_TRANSFER_BIT, -1, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    if (transferfamilyinfo.queueCount){
+        VkDeviceQueueCreateInfo queuecreateinfo = {};
         queuecreateinfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queuecreateinfo.pNext = nullptr;
-        queuecreateinfo.flags = 0;
-        queuecreateinfo.queueCount = static_cast<uint32_t>(queueinfo.prioritys.size());
-        queuecreateinfo.queueFamilyIndex = queuefamilyinfo.queueFamilyIndex;
-        queuecreateinfo.pQueuePriorities = queueinfo.prioritys.data();
-        memcpy(&queueinfos[index++], &queuecreateinfo, sizeof(VkDeviceQueueCreateInfo));
+        queuecreateinfo.queueCount = 1;
+        queuecreateinfo.queueFamilyIndex = transferfamilyinfo.queueFamilyIndex;
+        queuecreateinfo.pQueuePriorities = &transferpriority;
+        queueinfos.push_back(queuecreateinfo);
     }
+    devicecreateinfo.queueCreateInfoCount = static_cast<uint32_t>(queueinfos.size());
     devicecreateinfo.pQueueCreateInfos = queueinfos.data();
 
     //If a graphics queue is requested, set up the swapchain...
@@ -268,8 +627,25 @@ void VulkanRenderer::addLogicalDevice(
         if (queue.flag & VK_QUEUE_GRAPHICS_BIT || queue.flag & VK_QUEUE_GRAPHICS_BIT)
             found = true;
     }
+    //A surface only takes one swapchain, devices after the one presenting to it render offscreen...
+    auto offscreen = headless || surfaceInUse;
     if (found){
-        if (!swapchaincreateinfo){
+        if (!swapchaincreateinfo && offscreen){
+            //Describe the offscreen image ring that stands in for the swapchain...
+            swapchaininfo = {};
+            swapchaininfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+            swapchaininfo.surface = VK_NULL_HANDLE;
+            swapchaininfo.minImageCount = OFFSCREEN_IMAGE_COUNT;
+            swapchaininfo.imageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+            swapchaininfo.imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+            swapchaininfo.imageExtent = offscreenExtent;
+            swapchaininfo.imageArrayLayers = 1;
+            swapchaininfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            swapchaininfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            swapchaininfo.clipped = VK_TRUE;
+            swapchaininfo.oldSwapchain = VK_NULL_HANDLE;
+            swapchaincreateinfo = &swapchaininfo;
+        }else if (!swapchaincreateinfo){
             //Get the physical device's surface capabilities...
             VkSurfaceCapabilitiesKHR capabilities;
             if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevices[static_cast<uint32_t>(deviceindex)], surface, &capabilities) != VK_SUCCESS)
@@ -293,10 +669,8 @@ void VulkanRenderer::addLogicalDevice(
             presentmodes.resize(presentmodecount);
             vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevices[static_cast<uint32_t>(deviceindex)], surface, &presentmodecount, presentmodes.data());
 
-            //Get minimum image count..
-            uint32_t imagecount = capabilities.minImageCount + 1;
-            if (capabilities.maxImageCount > 0 && imagecount > capabilities.maxImageCount)
-                imagecount = capabilities.maxImageCount;
+            //The present policy trades latency against throughput with the image count and present mode...
+            auto imagecount = presentPolicy.chooseImageCount(capabilities);
 
             //Create swapchain create info based on what the physical device supports...
             auto surfaceformat = chooseSwapSurfaceFormat(formats);
@@ -316,12 +690,12 @@ void VulkanRenderer::addLogicalDevice(
                 swapchaininfo.pQueueFamilyIndices = nullptr,
                 swapchaininfo.preTransform = capabilities.currentTransform,
                 swapchaininfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-                swapchaininfo.presentMode = chooseSwapPresentMode(presentmodes),
+                swapchaininfo.presentMode = presentPolicy.choosePresentMode(presentmodes),
                 swapchaininfo.clipped = VK_TRUE,
                 swapchaininfo.oldSwapchain = nullptr
             };
             swapchaincreateinfo = &swapchaininfo;
-        }else{
+        }else if (swapchaincreateinfo->surface != VK_NULL_HANDLE){
             //Ensure it's requested attributes are supported by the selected physical device...
             VkSurfaceCapabilitiesKHR surfacecapabilities = {};
             if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevices[static_cast<uint32_t>(deviceindex)], surface, &surfacecapabilities) != VK_SUCCESS)
@@ -354,8 +728,14 @@ void VulkanRenderer::addLogicalDevice(
         addDevice(&devicecreateinfo, deviceindex, graphicsqueuecount, computequeuecount, swapchaincreateinfo);
 
         //Start drawing if desired...
+        auto logicaldeviceindex = physicalDeviceInfos.at(static_cast<uint32_t>(deviceindex)).getLogicalDeviceCount() - 1;
+        if (found && !offscreen && swapchaincreateinfo->surface != VK_NULL_HANDLE){
+            surfaceInUse = true;
+            surfacePhysicalDeviceIndex = static_cast<uint32_t>(deviceindex);
+            surfaceLogicalDeviceIndex = logicaldeviceindex;
+        }
         if (graphicsqueuecount > 0)
-            initializeRenderLoop(deviceindex, physicalDeviceInfos.at(static_cast<uint32_t>(deviceindex)).getLogicalDeviceCount() - 1);
+            initializeRenderLoop(deviceindex, logicaldeviceindex);
     }catch (std::runtime_error error){
         throw error;
     }
@@ -372,18 +752,6 @@ VkSurfaceFormatKHR VulkanRenderer::chooseSwapSurfaceFormat(const std::vector<VkS
     return availableformats[0];
 }
 
-VkPresentModeKHR VulkanRenderer::chooseSwapPresentMode(const std::vector<VkPresentModeKHR> & availablepresentmodes) const noexcept{
-    VkPresentModeKHR bestmode = VK_PRESENT_MODE_FIFO_KHR;
-    for (const auto& availablepresentmode : availablepresentmodes){
-        if (availablepresentmode == VK_PRESENT_MODE_MAILBOX_KHR){
-            return availablepresentmode;
-        }else if (availablepresentmode == VK_PRESENT_MODE_IMMEDIATE_KHR){
-            bestmode = availablepresentmode;
-        }
-    }
-    return bestmode;
-}
-
 VkExtent2D VulkanRenderer::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) const noexcept{
     if (capabilities.currentExtent.width != (std::numeric_limits<uint32_t>::max)()){
         return capabilities.currentExtent;
@@ -400,21 +768,14 @@ void VulkanRenderer::addDevice(VkDeviceCreateInfo * devicecreateinfo, int device
         throw std::runtime_error("Graphics queues are requested but swapchain info is null!!");
     auto index = -1;
     if (deviceindex >= 0){
-        if (static_cast<uint32_t>(deviceindex) < sizeof(physicalDevices)){
+        if (static_cast<uint32_t>(deviceindex) < physicalDevices.size()){
             index = deviceindex;
         }else{
             throw std::runtime_error("Physical device index out of range!");
         }
-    }else{
-        //Find the most powerful device and create the logical device on it...
-        uint64_t score = 0;
-        for (uint32_t i = 0; i < sizeof(physicalDevices); i++){
-            uint64_t temp = physicalDeviceInfos[i].getDeviceScore();
-            if (temp > score){
-                score = temp;
-                index = static_cast<int>(i);
-            }
-        }
+    }else if (!physicalDeviceInfos.empty()){
+        //Create the logical device on the most powerful device...
+        index = static_cast<int>(indexOfStrongestDevice);
     }
     //Create the device...
     if (index >= 0){
@@ -430,8 +791,11 @@ void VulkanRenderer::addDevice(VkDeviceCreateInfo * devicecreateinfo, int device
 
 VulkanRenderer::~VulkanRenderer()
 {
+    //Render threads go first, they're still drawing on the devices about to be cleaned up...
+    renderThreads.clear();
     for (auto device : physicalDeviceInfos)
         device.cleanup();
-    vkDestroySurfaceKHR(vulkanInstance, surface, nullptr);
+    if (surface != VK_NULL_HANDLE)
+        vkDestroySurfaceKHR(vulkanInstance, surface, nullptr);
     vkDestroyInstance(vulkanInstance, nullptr);
 }
@@ -3,8 +3,13 @@
 
 #include "src/utility.h"
 #include "physicaldeviceinfo.h"
-#include "src/ui/win32.h"
+#include "src/ui/window.h"
 #include "vulkanvalidationlayers.h"
+#include "framestatistics.h"
+#include "presentpolicy.h"
+#include "renderthread.h"
+#include <memory>
+#include <chrono>
 
 class VulkanRenderer final
 {
@@ -16,9 +21,7 @@ public:
                 }
             ,
             const std::vector<const char *> &enableextensions = std::vector<const char *> {
-                VK_EXT_DEBUG_REPORT_EXTENSION_NAME,
-                "VK_KHR_win32_surface",
-                "VK_KHR_surface"
+                DEFAULT_INSTANCE_EXTENSIONS
                 }
             );
     ~VulkanRenderer();
@@ -31,21 +34,66 @@ public:
     static void setWindowResized(bool resized) noexcept;
     [[nodiscard]] bool wasWindowResized() const noexcept;
     [[nodiscard]] bool keepRendering() const noexcept;
+    [[nodiscard]] bool isHeadless() const noexcept;
+    void setOffscreenExtent(VkExtent2D extent);
+    [[nodiscard]] uint64_t getDroppedWindowEventCount() const noexcept;
     void drawFrame();
+    void setCurrentDevice(uint32_t physicaldeviceindex, uint32_t logicaldeviceindex);
+    [[nodiscard]] uint32_t getPhysicalDeviceCount() const noexcept;
+    [[nodiscard]] uint32_t getLogicalDeviceCount(uint32_t physicaldeviceindex) const;
+    void startRenderThreads();
+    void stopRenderThreads();
+    [[nodiscard]] uint32_t getRenderThreadCount() const noexcept;
+    [[nodiscard]] uint64_t getRenderThreadFrameCount() const noexcept;
+    uint32_t addMesh(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices);
+    uint32_t addComputeMesh(const std::string & shadername, uint32_t vertexcount, uint32_t indexcount);
+    void setMeshUniforms(uint32_t mesh, const MeshUniforms & uniforms);
+    void setMeshConstants(uint32_t mesh, const DrawConstants & constants);
+    [[nodiscard]] std::vector<uint32_t> addPipelineVariants(const std::vector<PipelineState> & states);
+    void setMeshPipeline(uint32_t mesh, uint32_t variant);
+    void setDepthMode(GraphicsPipeline::DepthMode depthmode, VkFormat depthformat = VK_FORMAT_UNDEFINED);
+    [[nodiscard]] GraphicsPipeline::DepthMode getDepthMode() const;
+    [[nodiscard]] VkFormat getDepthFormat() const;
+    void setSampleCount(VkSampleCountFlagBits samplecount);
+    [[nodiscard]] VkSampleCountFlagBits getSampleCount() const;
+    [[nodiscard]] VkSampleCountFlags getSupportedSampleCounts() const;
+    [[nodiscard]] RenderGraph::MemoryStatistics getTransientMemoryStatistics() const;
+    [[nodiscard]] std::unique_ptr<RenderGraph> createRenderGraph() const;
+    void setFramesInFlight(uint32_t framesinflight);
+    [[nodiscard]] uint32_t getFramesInFlight() const;
+    void setPresentPolicy(const PresentPolicy & policy);
+    [[nodiscard]] const PresentPolicy & getPresentPolicy() const noexcept;
+    [[nodiscard]] const FrameStatistics & getPresentStatistics() const;
+    [[nodiscard]] const FrameStatistics & getFenceWaitStatistics() const;
+    [[nodiscard]] const FrameStatistics & getLimiterWaitStatistics() const noexcept;
+    [[nodiscard]] const FrameStatistics & getFrameStatistics() const noexcept;
+    [[nodiscard]] const FrameStatistics & getGpuStatistics(TimestampQueryPool::Scope scope) const;
+    [[nodiscard]] bool hasGpuTimestamps() const;
+    void setRecordingThreadCount(uint32_t threadcount = 0);
+    [[nodiscard]] uint32_t getRecordingThreadCount() const;
+    void setRecordEveryFrame(bool recordeveryframe);
+    void setShaderHotReload(bool enable);
+    [[nodiscard]] bool isShaderHotReloadEnabled() const;
+    void setGpuDriven(bool gpudriven);
+    [[nodiscard]] bool isGpuDriven() const;
+    [[nodiscard]] const FrameStatistics & getRecordingStatistics() const;
+    [[nodiscard]] bool wasPipelineCacheLoaded() const;
+    [[nodiscard]] std::vector<DeviceMemoryAllocator::HeapStatistics> getMemoryStatistics() const;
+    void resetFrameStatistics(size_t windowsize = FRAME_STATISTICS_WINDOW_SIZE);
     void addLogicalDevice(
             const std::array<QueueInfo, MAX_NUM_QUEUE_TYPES_ALLOWED> & queuetypes,
             const VkPhysicalDeviceFeatures & features,
             VkSwapchainCreateInfoKHR * swapchaincreateinfo = nullptr,
             const std::vector<const char *> &enablelayers = std::vector<const char *> {/*"VK_LAYER_LUNARG_standard_validation"*/},
             const std::vector<const char *> &enableextensions = std::vector<const char *> {VK_KHR_SWAPCHAIN_EXTENSION_NAME},
-            int deviceindex = 0
+            int deviceindex = -1
             );
     //void addLogicalDevice(VkDeviceCreateInfo *devicecreateinfo, uint32_t graphicsqueuecount, uint32_t computequeuecount, int physicaldeviceindex = -1);
 private:
     void recreateSwapChain();
+    void processWindowEvents() noexcept;
     void initializeRenderLoop(int physicaldeviceindex = -1, uint32_t logicaldeviceindex = 0);
     [[nodiscard]] VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> & availableformats) const noexcept;
-    [[nodiscard]] VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> & availablepresentmodes) const noexcept;
     [[nodiscard]] VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) const noexcept;
     void addDevice(
             VkDeviceCreateInfo *devicecreateinfo,
@@ -57,17 +105,28 @@ private:
 private:
     static bool windowResized;
     bool render;
+    bool headless;
+    VkExtent2D offscreenExtent;
     uint32_t currentPhysicalDeviceIndex;
     uint32_t currentLogicalDeviceIndex;
+    bool surfaceInUse;
+    uint32_t surfacePhysicalDeviceIndex;
+    uint32_t surfaceLogicalDeviceIndex;
+    std::vector <std::unique_ptr<RenderThread>> renderThreads;
     VkInstance vulkanInstance;
     uint32_t indexOfStrongestDevice;
     std::vector <VkPhysicalDevice> physicalDevices;
     std::vector <PhysicalDeviceInfo> physicalDeviceInfos;
     VkSurfaceKHR surface;
-    Win32 windowsClass;
+    std::unique_ptr<Window> window;
     VulkanValidationLayers validationLayers;
     std::vector <VkLayerProperties> layerProperties;
     std::vector <VkExtensionProperties> extensionProperties;
+    FrameStatistics frameStatistics;
+    PresentPolicy presentPolicy;
+    FrameStatistics limiterStatistics;
+    std::chrono::steady_clock::time_point lastFrameStart;
+    bool frameTimingStarted;
 };
 
 #endif // VULKANRENDERER_H
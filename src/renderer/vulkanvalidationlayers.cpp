@@ -14,7 +14,8 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
         void*
         )
 {
-    //qDebug(msg);
+    //May be called from driver threads, the logger doesn't block them...
+    LOG_WARNING(msg);
     return VK_FALSE;
 }
 
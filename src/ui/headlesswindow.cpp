@@ -0,0 +1,35 @@
+#include "headlesswindow.h"
+
+/*!
+        \class HeadlessWindow
+        \brief The HeadlessWindow class stands in for a window when frames are rendered offscreen.
+
+        There's no OS window, so no surface and no event thread. resize() and close() are called by
+        whoever drives the renderer, on the render thread, and their events go through the same queue
+        as a real window's.
+*/
+
+HeadlessWindow::HeadlessWindow(const WindowCreateInfo & windowcreateinfo)
+    : extent(windowcreateinfo.extent)
+{
+    if (!extent.width || !extent.height)
+        throw std::runtime_error("Invalid offscreen extent!");
+}
+
+VkSurfaceKHR HeadlessWindow::createSurface(VkInstance instance){
+    //Offscreen images stand in for a swapchain, there's nothing to present to...
+    return VK_NULL_HANDLE;
+}
+
+void HeadlessWindow::resize(VkExtent2D newextent) noexcept{
+    extent = newextent;
+    pushEvent(WindowEvent::RESIZE_EVENT, extent);
+}
+
+void HeadlessWindow::close() noexcept{
+    pushEvent(WindowEvent::CLOSE_EVENT);
+}
+
+VkExtent2D HeadlessWindow::getExtent() const noexcept{
+    return extent;
+}
@@ -0,0 +1,21 @@
+#ifndef HEADLESSWINDOW_H
+#define HEADLESSWINDOW_H
+
+#include "window.h"
+
+class HeadlessWindow final : public Window
+{
+public:
+    HeadlessWindow(const WindowCreateInfo & windowcreateinfo);
+public:
+    ~HeadlessWindow() override = default;
+public:
+    [[nodiscard]] VkSurfaceKHR createSurface(VkInstance instance) override;
+    void resize(VkExtent2D extent) noexcept;
+    void close() noexcept;
+    [[nodiscard]] VkExtent2D getExtent() const noexcept;
+private:
+    VkExtent2D extent;
+};
+
+#endif // HEADLESSWINDOW_H
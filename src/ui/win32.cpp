@@ -1,17 +1,50 @@
 #include "win32.h"
 #include "src/utility.h"
 
+/*!
+        \class Win32
+        \brief The Win32 class is the Windows backend of Window.
+
+        The window is created on, and owned by, an event thread that pumps its messages with a blocking
+        GetMessage(), so the render thread never runs the message loop. The modal loop Windows enters
+        while a window is dragged or sized only stalls the event thread, and frames keep being presented
+        at the old size until the resize arrives through the event queue. WM_CLOSE is turned into a close
+        event instead of destroying the window, the window lives until the Win32 object is destroyed,
+        after the renderer has destroyed its surface.
+*/
+
+//Posted by the destructor, windows can only be destroyed by the thread that created them...
+#define WM_DESTROY_FROM_OWNER (WM_APP + 1)
+
+//Posted by show(), keyboard focus can only be given by the thread that owns the window...
+#define WM_FOCUS_FROM_OWNER (WM_APP + 2)
+
 //The Windows procedure...
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam){
+    if (msg == WM_NCCREATE){
+        auto createStruct = reinterpret_cast<CREATESTRUCT *>(lParam);
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(createStruct->lpCreateParams));
+        return DefWindowProc(hwnd, msg, wParam, lParam);
+    }
+    auto owner = reinterpret_cast<Win32 *>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
     switch(msg){
     case WM_CLOSE:
+        if (owner)
+            owner->pushEvent(WindowEvent::CLOSE_EVENT);
+        break;
+    case WM_DESTROY_FROM_OWNER:
         DestroyWindow(hwnd);
         break;
+    case WM_FOCUS_FROM_OWNER:
+        SetForegroundWindow(hwnd);
+        SetFocus(hwnd);
+        break;
     case WM_DESTROY:
         PostQuitMessage(0);
         break;
-    case WM_SIZING:
-        //VulkanRenderer::setWindowResized(true);
+    case WM_SIZE:
+        if (owner)
+            owner->pushEvent(WindowEvent::RESIZE_EVENT, {LOWORD(lParam), HIWORD(lParam)});
         break;
     default:
         return DefWindowProc(hwnd, msg, wParam, lParam);
@@ -19,25 +52,51 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam){
     return 0;
 }
 
-Win32::Win32(WindowCreateInfo &windowcreateinfo)
-    : createInfo(windowcreateinfo)
+Win32::Win32(const WindowCreateInfo & windowcreateinfo)
+    : createInfo(windowcreateinfo),
+      window(nullptr),
+      handle(windowcreateinfo.hInstance),
+      windowsClass(),
+      eventThread()
 {
-    //Get window handle and register the Window Class...
-    handle = windowcreateinfo.hInstance;
+    //The window belongs to the thread that creates it, so the event thread does...
+    std::promise<void> created;
+    auto result = created.get_future();
+    eventThread = std::thread(&Win32::pumpMessages, this, std::move(created));
+    result.wait();
+    if (!window){
+        eventThread.join();
+        UnregisterClass(L"Null", handle);
+        throw std::runtime_error("Failed to create window!");
+    }
+}
+
+Win32::~Win32(){
+    if (window)
+        PostMessage(window, WM_DESTROY_FROM_OWNER, 0, 0);
+    if (eventThread.joinable())
+        eventThread.join();
+    UnregisterClass(L"Null", handle);
+}
+
+void Win32::pumpMessages(std::promise<void> created) noexcept{
+    //Register the Window Class...
     windowsClass.cbSize = sizeof(WNDCLASSEX);
     windowsClass.style = 0;
     windowsClass.lpfnWndProc = WndProc;
     windowsClass.cbClsExtra = 0;
     windowsClass.cbWndExtra = 0;
-    windowsClass.hInstance = nullptr;
+    windowsClass.hInstance = handle;
     windowsClass.hIcon = nullptr;
     windowsClass.hCursor = nullptr;
     windowsClass.hbrBackground = nullptr;
     windowsClass.lpszMenuName = nullptr;
     windowsClass.lpszClassName = L"Null";
     windowsClass.hIconSm = nullptr;
-    if (!RegisterClassEx(&windowsClass))
-        throw std::runtime_error("Failed to register Windows class!");
+    if (!RegisterClassEx(&windowsClass)){
+        created.set_value();
+        return;
+    }
 
     //Create the window...
     window = CreateWindowEx(
@@ -47,34 +106,42 @@ Win32::Win32(WindowCreateInfo &windowcreateinfo)
                 WS_OVERLAPPEDWINDOW,
                 static_cast<int>(0x80000000),
                 static_cast<int>(0x80000000),
-                1980,
-                1020,
+                static_cast<int>(createInfo.extent.width),
+                static_cast<int>(createInfo.extent.height),
                 nullptr,
                 nullptr,
                 handle,
-                nullptr
+                this
                 );
-}
+    created.set_value();
+    if (!window)
+        return;
 
-bool Win32::processMessage()  const noexcept{
-    auto messaged = false;
-    //Process messages...
-    if (MSG message; GetMessage(&message, nullptr, 0, 0)){    //Use PeekMessage to not block user input???
+    //Blocking is fine here, this thread has nothing else to do...
+    MSG message;
+    while (GetMessage(&message, nullptr, 0, 0) > 0){
         TranslateMessage(&message);
         DispatchMessage(&message);
-        messaged = true;
     }
-    return messaged;
 }
 
-bool Win32::showWindow() noexcept{
-    auto result = true;
-    if (!ShowWindow(window, createInfo.nShowCmd))
-        result = false;
+VkSurfaceKHR Win32::createSurface(VkInstance instance){
+    VkWin32SurfaceCreateInfoKHR surfaceInfo = {};
+    surfaceInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+    surfaceInfo.hwnd = window;
+    surfaceInfo.hinstance = handle;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    if (vkCreateWin32SurfaceKHR(instance, &surfaceInfo, nullptr, &surface) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create window surface!");
+    return surface;
+}
+
+void Win32::show() noexcept{
+    //ShowWindow() is sent on to the event thread, which is always pumping. SetFocus() only works on the
+    //calling thread's own windows, so focusing is posted to the event thread...
+    ShowWindow(window, createInfo.nShowCmd);
     createInfo.nShowCmd = SW_SHOW;
-    SetForegroundWindow(window);
-    SetFocus(window);
-    return result;
+    PostMessage(window, WM_FOCUS_FROM_OWNER, 0, 0);
 }
 
 HINSTANCE Win32::getWindows32Handle() const noexcept{
@@ -2,27 +2,31 @@
 #define WIN32_H
 
 #include <Windows.h>
+#include "window.h"
 #include "src/utility.h"
+#include <thread>
+#include <future>
 
-class Win32 final
+class Win32 final : public Window
 {
+    friend LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 public:
-    Win32(WindowCreateInfo &windowcreateinfo);
-    bool processMessage() const noexcept;
-    bool showWindow() noexcept;
+    Win32(const WindowCreateInfo & windowcreateinfo);
+public:
+    ~Win32() override;
+public:
+    [[nodiscard]] VkSurfaceKHR createSurface(VkInstance instance) override;
+    void show() noexcept override;
     [[nodiscard]] HINSTANCE getWindows32Handle() const noexcept;
     [[nodiscard]] HWND getWindow() const noexcept;
-public:
-    ~Win32() = default;
-    Win32(const Win32 & other) = delete;
-    Win32 & operator=(const Win32 & other) = delete;
-    Win32(const Win32 && other) = delete;
-    Win32 & operator=(const Win32 && other) = delete;
+private:
+    void pumpMessages(std::promise<void> created) noexcept;
 private:
     WindowCreateInfo createInfo;
     HWND window;
     HINSTANCE handle;
     WNDCLASSEX windowsClass;
+    std::thread eventThread;
 };
 
 #endif // WIN32_H
@@ -0,0 +1,51 @@
+#include "window.h"
+#include "headlesswindow.h"
+#ifdef _WIN32
+#include "win32.h"
+#endif
+#ifdef VK_USE_PLATFORM_XCB_KHR
+#include "xcbwindow.h"
+#endif
+
+/*!
+        \class Window
+        \brief The Window class is the platform neutral interface the renderer draws to and takes window events from.
+
+        Each backend pumps its OS events on a thread of its own and pushes what the renderer cares about,
+        resizes and close requests, onto a lock free queue. The render thread drains it with pollEvent(),
+        which never blocks, so frames keep going while the OS is busy with the window, e.g. during a drag.
+        createSurface() makes the surface for the backend's window. The headless backend has no surface
+        and returns VK_NULL_HANDLE.
+
+        create() picks the headless backend when the create info asks for it. Otherwise it picks the one
+        built for the platform: Win32 on Windows, or XCB where VK_USE_PLATFORM_XCB_KHR is defined.
+*/
+
+std::unique_ptr<Window> Window::create(const WindowCreateInfo & windowcreateinfo){
+    if (windowcreateinfo.headless)
+        return std::make_unique<HeadlessWindow>(windowcreateinfo);
+#if defined(_WIN32)
+    return std::make_unique<Win32>(windowcreateinfo);
+#elif defined(VK_USE_PLATFORM_XCB_KHR)
+    return std::make_unique<XcbWindow>(windowcreateinfo);
+#else
+    throw std::runtime_error("No window backend was built for this platform, use a headless WindowCreateInfo!");
+#endif
+}
+
+void Window::show() noexcept{
+    //Backends without anything to show leave this alone...
+}
+
+bool Window::pollEvent(WindowEvent & event) noexcept{
+    return events.pop(event);
+}
+
+uint64_t Window::getDroppedEventCount() const noexcept{
+    return events.getDroppedCount();
+}
+
+void Window::pushEvent(WindowEvent::Type type, VkExtent2D extent) noexcept{
+    //Each window pushes from one thread only, the backend's event thread, or the render thread for headless windows...
+    (void)events.push({type, extent});
+}
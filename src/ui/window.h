@@ -0,0 +1,30 @@
+#ifndef WINDOW_H
+#define WINDOW_H
+
+#include "windoweventqueue.h"
+#include "src/utility.h"
+#include <memory>
+
+class Window
+{
+public:
+    [[nodiscard]] static std::unique_ptr<Window> create(const WindowCreateInfo & windowcreateinfo);
+public:
+    virtual ~Window() = default;
+    Window(const Window & other) = delete;
+    Window & operator=(const Window & other) = delete;
+    Window(const Window && other) = delete;
+    Window & operator=(const Window && other) = delete;
+public:
+    [[nodiscard]] virtual VkSurfaceKHR createSurface(VkInstance instance) = 0;
+    virtual void show() noexcept;
+    [[nodiscard]] bool pollEvent(WindowEvent & event) noexcept;
+    [[nodiscard]] uint64_t getDroppedEventCount() const noexcept;
+protected:
+    Window() = default;
+    void pushEvent(WindowEvent::Type type, VkExtent2D extent = {0, 0}) noexcept;
+private:
+    WindowEventQueue events;
+};
+
+#endif // WINDOW_H
@@ -0,0 +1,45 @@
+#include "windoweventqueue.h"
+
+/*!
+        \class WindowEventQueue
+        \brief The WindowEventQueue class hands window events from a window's event thread to the render thread.
+
+        A fixed size single producer, single consumer ring. The event thread is the only one to push and
+        the render thread the only one to pop, so each end owns one index and neither ever takes a lock or
+        waits on the other. A push into a full queue drops the event and counts it. The render thread
+        drains the queue every frame, and resizes are coalesced on its side anyway.
+*/
+
+WindowEventQueue::WindowEventQueue()
+    : head(0),
+      tail(0),
+      dropped(0),
+      events()
+{
+    //
+}
+
+bool WindowEventQueue::push(const WindowEvent & event) noexcept{
+    //Only the producer writes the tail, the head it reads can only have moved on...
+    auto position = tail.load(std::memory_order_relaxed);
+    if (position - head.load(std::memory_order_acquire) >= WINDOW_EVENT_QUEUE_CAPACITY){
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    events[position % WINDOW_EVENT_QUEUE_CAPACITY] = event;
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool WindowEventQueue::pop(WindowEvent & event) noexcept{
+    auto position = head.load(std::memory_order_relaxed);
+    if (position == tail.load(std::memory_order_acquire))
+        return false;
+    event = events[position % WINDOW_EVENT_QUEUE_CAPACITY];
+    head.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+uint64_t WindowEventQueue::getDroppedCount() const noexcept{
+    return dropped.load(std::memory_order_relaxed);
+}
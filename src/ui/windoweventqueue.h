@@ -0,0 +1,40 @@
+#ifndef WINDOWEVENTQUEUE_H
+#define WINDOWEVENTQUEUE_H
+
+#include "src/utility.h"
+#include <atomic>
+
+#define WINDOW_EVENT_QUEUE_CAPACITY 256
+
+struct WindowEvent final
+{
+    enum Type {
+        RESIZE_EVENT = 0,
+        CLOSE_EVENT = 1
+    };
+    Type type;
+    VkExtent2D extent;
+};
+
+class WindowEventQueue final
+{
+public:
+    WindowEventQueue();
+public:
+    ~WindowEventQueue() = default;
+    WindowEventQueue(const WindowEventQueue & other) = delete;
+    WindowEventQueue & operator=(const WindowEventQueue & other) = delete;
+    WindowEventQueue(const WindowEventQueue && other) = delete;
+    WindowEventQueue & operator=(const WindowEventQueue && other) = delete;
+public:
+    [[nodiscard]] bool push(const WindowEvent & event) noexcept;
+    [[nodiscard]] bool pop(WindowEvent & event) noexcept;
+    [[nodiscard]] uint64_t getDroppedCount() const noexcept;
+private:
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint64_t> dropped;
+    std::array <WindowEvent, WINDOW_EVENT_QUEUE_CAPACITY> events;
+};
+
+#endif // WINDOWEVENTQUEUE_H
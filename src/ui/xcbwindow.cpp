@@ -0,0 +1,151 @@
+#include "xcbwindow.h"
+
+#ifdef VK_USE_PLATFORM_XCB_KHR
+#include <cstdlib>
+
+/*!
+        \class XcbWindow
+        \brief The XcbWindow class is the Linux backend of Window, on X11 through XCB.
+
+        XCB connections are thread safe, so the window is created on the caller's thread and an event
+        thread then sits in xcb_wait_for_event() for it. Size changes come in as configure notifies and
+        the window manager's close button as a WM_DELETE_WINDOW client message, and both are pushed onto
+        the event queue. The destructor wakes the event thread by sending the window a client message of
+        its own, which is why stopping is checked before anything else.
+*/
+
+XcbWindow::XcbWindow(const WindowCreateInfo & windowcreateinfo)
+    : connection(nullptr),
+      window(0),
+      protocolsAtom(0),
+      deleteWindowAtom(0),
+      extent(windowcreateinfo.extent),
+      stopping(false),
+      eventThread()
+{
+    //Connect to the X server named by DISPLAY...
+    connection = xcb_connect(nullptr, nullptr);
+    if (xcb_connection_has_error(connection)){
+        xcb_disconnect(connection);
+        throw std::runtime_error("Failed to connect to the X server!");
+    }
+    auto screen = xcb_setup_roots_iterator(xcb_get_setup(connection)).data;
+    if (!screen){
+        xcb_disconnect(connection);
+        throw std::runtime_error("X server has no screens!");
+    }
+
+    //Create the window...
+    window = xcb_generate_id(connection);
+    uint32_t eventmask = XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    xcb_create_window(
+                connection,
+                XCB_COPY_FROM_PARENT,
+                window,
+                screen->root,
+                0,
+                0,
+                static_cast<uint16_t>(extent.width),
+                static_cast<uint16_t>(extent.height),
+                0,
+                XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                screen->root_visual,
+                XCB_CW_EVENT_MASK,
+                &eventmask
+                );
+    const char title[] = "Vulkan Renderer";
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, sizeof(title) - 1, title);
+
+    //Ask the window manager for a message instead of killing the connection when the window is closed...
+    try{
+        protocolsAtom = internAtom("WM_PROTOCOLS");
+        deleteWindowAtom = internAtom("WM_DELETE_WINDOW");
+    }catch (...){
+        xcb_destroy_window(connection, window);
+        xcb_disconnect(connection);
+        throw;
+    }
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window, protocolsAtom, XCB_ATOM_ATOM, 32, 1, &deleteWindowAtom);
+    xcb_flush(connection);
+
+    eventThread = std::thread(&XcbWindow::pumpEvents, this);
+}
+
+XcbWindow::~XcbWindow(){
+    //Wake the event thread with a message it knows to stop on...
+    stopping.store(true, std::memory_order_release);
+    xcb_client_message_event_t wake = {};
+    wake.response_type = XCB_CLIENT_MESSAGE;
+    wake.format = 32;
+    wake.window = window;
+    wake.type = protocolsAtom;
+    xcb_send_event(connection, 0, window, XCB_EVENT_MASK_NO_EVENT, reinterpret_cast<const char *>(&wake));
+    xcb_flush(connection);
+    if (eventThread.joinable())
+        eventThread.join();
+    xcb_destroy_window(connection, window);
+    xcb_disconnect(connection);
+}
+
+xcb_atom_t XcbWindow::internAtom(const char *name) const{
+    auto reply = xcb_intern_atom_reply(connection, xcb_intern_atom(connection, 0, static_cast<uint16_t>(std::strlen(name)), name), nullptr);
+    if (!reply)
+        throw std::runtime_error(std::string("Failed to intern X atom ") + name + std::string("!"));
+    auto atom = reply->atom;
+    std::free(reply);
+    return atom;
+}
+
+void XcbWindow::pumpEvents() noexcept{
+    //Only this thread touches extent once it has started...
+    while (auto event = xcb_wait_for_event(connection)){
+        if (stopping.load(std::memory_order_acquire)){
+            std::free(event);
+            break;
+        }
+        switch (event->response_type & 0x7f){
+        case XCB_CONFIGURE_NOTIFY:{
+            auto configure = reinterpret_cast<xcb_configure_notify_event_t *>(event);
+            if (configure->width != extent.width || configure->height != extent.height){
+                extent = {configure->width, configure->height};
+                pushEvent(WindowEvent::RESIZE_EVENT, extent);
+            }
+            break;
+        }
+        case XCB_CLIENT_MESSAGE:{
+            auto message = reinterpret_cast<xcb_client_message_event_t *>(event);
+            if (message->data.data32[0] == deleteWindowAtom)
+                pushEvent(WindowEvent::CLOSE_EVENT);
+            break;
+        }
+        default:
+            break;
+        }
+        std::free(event);
+    }
+}
+
+VkSurfaceKHR XcbWindow::createSurface(VkInstance instance){
+    VkXcbSurfaceCreateInfoKHR surfaceInfo = {};
+    surfaceInfo.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
+    surfaceInfo.connection = connection;
+    surfaceInfo.window = window;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    if (vkCreateXcbSurfaceKHR(instance, &surfaceInfo, nullptr, &surface) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create window surface!");
+    return surface;
+}
+
+void XcbWindow::show() noexcept{
+    xcb_map_window(connection, window);
+    xcb_flush(connection);
+}
+
+xcb_connection_t *XcbWindow::getConnection() const noexcept{
+    return connection;
+}
+
+xcb_window_t XcbWindow::getWindow() const noexcept{
+    return window;
+}
+#endif
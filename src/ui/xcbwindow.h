@@ -0,0 +1,36 @@
+#ifndef XCBWINDOW_H
+#define XCBWINDOW_H
+
+#ifdef VK_USE_PLATFORM_XCB_KHR
+#include <xcb/xcb.h>
+#include "window.h"
+#include "src/utility.h"
+#include <thread>
+#include <atomic>
+
+class XcbWindow final : public Window
+{
+public:
+    XcbWindow(const WindowCreateInfo & windowcreateinfo);
+public:
+    ~XcbWindow() override;
+public:
+    [[nodiscard]] VkSurfaceKHR createSurface(VkInstance instance) override;
+    void show() noexcept override;
+    [[nodiscard]] xcb_connection_t *getConnection() const noexcept;
+    [[nodiscard]] xcb_window_t getWindow() const noexcept;
+private:
+    [[nodiscard]] xcb_atom_t internAtom(const char *name) const;
+    void pumpEvents() noexcept;
+private:
+    xcb_connection_t *connection;
+    xcb_window_t window;
+    xcb_atom_t protocolsAtom;
+    xcb_atom_t deleteWindowAtom;
+    VkExtent2D extent;
+    std::atomic<bool> stopping;
+    std::thread eventThread;
+};
+#endif
+
+#endif // XCBWINDOW_H
@@ -2,14 +2,20 @@
 #define UTILITY_H
 
 #include <vulkan.h>
+#ifdef _WIN32
 #include <Windows.h>
 #include <vulkan_win32.h>
+#endif
 #include <vector>
 #include <string>
 #include <array>
 #include <fstream>
 #include <mutex>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
 #include <experimental/filesystem>
+#include "logfile.h"
 
 namespace fs = std::experimental::filesystem;
 
@@ -17,6 +23,8 @@ namespace fs = std::experimental::filesystem;
 #define MAX_NUM_LOGICAL_DEVICES_PER_PHYSICAL_DEVICE_ALLOWED 2
 #define MAX_NUM_QUEUE_TYPES_ALLOWED 2
 #define MIN_SWAPCHAIN_IMAGE_COUNT 2
+#define MAX_FRAMES_IN_FLIGHT_ALLOWED 3
+#define DEFAULT_FRAMES_IN_FLIGHT 2
 #define MAX_NUM_SHADERS_PER_GRAPHICS_PIPELINE_ALLOWED 8
 #define VK_EXTENT_1080_P {1920, 1080}
 #define VK_EXTENT_1440_P {2560, 1440}
@@ -32,10 +40,35 @@ namespace fs = std::experimental::filesystem;
 #define COMPUTE_SHADER_SUBSTRING "comp."
 #define PATH_TO_LOG_DIRECTORY_WINDOWS "logs\\debug.txt"
 #define PATH_TO_LOG_DIRECTORY_LINUX "logs/debug.txt"
+#define PIPELINE_CACHE_DIRECTORY "cache"
+#define PIPELINE_CACHE_FILE_MAGIC 0x5043564BU
+#define DEVICE_SCORE_DIRECTORY "scores"
+#define DEVICE_SCORE_FILE_MAGIC 0x5344564BU
+#define DEVICE_SCORE_BENCHMARK_SIZE (32ULL * 1024 * 1024)
+#define DEVICE_SCORE_BENCHMARK_ITERATIONS 8
+#define OFFSCREEN_IMAGE_COUNT 3
+#define COMPUTE_WORKGROUP_SIZE 64
+#define COMPUTE_WORKGROUP_SIZE_CONSTANT_ID 0
+#define PARALLEL_RECORDING_DRAW_THRESHOLD 1024
+#define MIN_DRAWS_PER_RECORDING_THREAD 256
+#define SHADER_WATCH_INTERVAL_MS 100
+#define SHADER_RELOAD_DEBOUNCE_MS 250
+#define SPIRV_MAGIC_NUMBER 0x07230203U
+#define CULL_SHADER_NAME "cull.comp.spv"
+#define INDIRECT_DRAW_MAX_OBJECTS 65536
+#define GEOMETRY_POOL_SIZE (32ULL * 1024 * 1024)
+#if defined(_WIN32)
+#define DEFAULT_INSTANCE_EXTENSIONS VK_EXT_DEBUG_REPORT_EXTENSION_NAME, "VK_KHR_win32_surface", "VK_KHR_surface"
+#elif defined(VK_USE_PLATFORM_XCB_KHR)
+#define DEFAULT_INSTANCE_EXTENSIONS VK_EXT_DEBUG_REPORT_EXTENSION_NAME, "VK_KHR_xcb_surface", "VK_KHR_surface"
+#else
+#define DEFAULT_INSTANCE_EXTENSIONS VK_EXT_DEBUG_REPORT_EXTENSION_NAME
+#endif
 
 class WindowCreateInfo final
 {
 public:
+#ifdef _WIN32
     WindowCreateInfo(
             HINSTANCE instance,
             HINSTANCE previnstance,
@@ -45,14 +78,36 @@ public:
         : hInstance(instance),
           hPrevInstance(previnstance),
           lpCmdLine(lpcmdline),
-          nShowCmd(showcmd)
+          nShowCmd(showcmd),
+          headless(false),
+          extent(VK_EXTENT_1080_P)
     {
         //
     }
+#endif
+    //Headless by default, no window or surface and frames are rendered into an offscreen image ring of the given size.
+    //Otherwise a window of the given size from the platform's backend...
+    WindowCreateInfo(VkExtent2D windowextent, bool headlessrendering = true)
+        :
+#ifdef _WIN32
+          hInstance(nullptr),
+          hPrevInstance(nullptr),
+          lpCmdLine(nullptr),
+          nShowCmd(0),
+#endif
+          headless(headlessrendering),
+          extent(windowextent)
+    {
+        //
+    }
+#ifdef _WIN32
     HINSTANCE hInstance;
     HINSTANCE hPrevInstance;
     LPSTR lpCmdLine;
     int nShowCmd;
+#endif
+    bool headless;
+    VkExtent2D extent;
 };
 
 class QueueFamilyInfo final
@@ -101,59 +156,25 @@ public:
 
 namespace {
 
-class LogFile final
-{
-private:
-    static std::ofstream logFile;
-    static std::mutex mutex;
-public:
-    LogFile(){
-        //Generate path to log file...
-        auto currentpath = fs::current_path().u8string();
-        auto index = currentpath.find_last_of('\\') + 1;
-        std::string logpath = PATH_TO_LOG_DIRECTORY_WINDOWS;
-        if (index == (std::numeric_limits<size_t>::max)()){ //Not Windows...
-            index = currentpath.find_last_of('/') + 1;
-            logpath = PATH_TO_LOG_DIRECTORY_LINUX;
-            if (index == (std::numeric_limits<size_t>::max)())
-                throw std::runtime_error("LogFile: Invalid directory path!");
-        }
-        currentpath.resize(currentpath.size() + 1 + logpath.size() - sizeof("build"));
-        auto j = 0U;
-        while (index < currentpath.size())
-            currentpath[index++] = logpath[j++];
-        currentpath[index] = '\0';
-        logFile.open(currentpath, std::ios::out | std::ios::trunc);
-    }
-
-    ~LogFile(){
-        logFile << "\n\nApplication closing... Bye..\n";
-        logFile.close();
-    }
-
-    static void writeToLog(const char * message){
-        std::lock_guard <std::mutex> guard(mutex);
-        //logFile.open(QDir::currentPath().toStdString()+"/DebugLog.txt", std::ios::out | std::ios::trunc);
-        logFile << message << "\n";
-    }
-
-    static void writeToLog(const std::string & message){
-        std::lock_guard <std::mutex> guard(mutex);
-        //logFile.open(QDir::currentPath().toStdString()+"/DebugLog.txt", std::ios::out | std::ios::trunc);
-        logFile << message << "\n";
-    }
-
-    static void writeToLog(const std::vector <std::string> & messages){
-        std::lock_guard <std::mutex> guard(mutex);
-        //logFile.open(QDir::currentPath().toStdString()+"/DebugLog.txt", std::ios::out | std::ios::trunc);
-        for (auto i = 0U; i < messages.size(); i++){
-            logFile << messages.at(i) << "\n";
-        }
+std::string getShaderDirectory(){
+    //Shaders live in the source tree, next to the build directory...
+    auto currentpath = fs::current_path().u8string();
+    auto index = currentpath.find_last_of('\\');
+    std::string shaderpath = PATH_TO_SHADERS_DIRECTORY_WINDOWS;
+    if (index == (std::numeric_limits<size_t>::max)()){ //Not Windows...
+        index = currentpath.find_last_of('/');
+        shaderpath = PATH_TO_SHADERS_DIRECTORY_LINUX;
+        if (index == (std::numeric_limits<size_t>::max)())
+            throw std::runtime_error("Invalid shader directory path!");
     }
-};
-
-std::ofstream LogFile::logFile;
-std::mutex LogFile::mutex;
+    index++;
+    currentpath.resize(currentpath.size() + 1 + shaderpath.size() - sizeof("build"));
+    auto j = 0U;
+    while (index < currentpath.size())
+        currentpath[index++] = shaderpath[j++];
+    currentpath[index] = '\0';
+    return currentpath;
+}
 
 std::vector<char> readFile(const std::string& filename) {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);